@@ -23,6 +23,10 @@
 
 #include "ccp.h"
 #include "console.h"
+#include "bhp.h"
+#include "tasks.h"
+#include "out.h"
+#include "run.h"
 #include <IQRF.h>
 #include <IQRFPgm.h>
 
@@ -36,12 +40,85 @@
  * C++ prototypes
  */
  void myIqrfRxFunc(uint8_t *DataBuffer, uint8_t DataSize);
+ void consoleTask(void);
+ void rxTask(void);
+ void sendTask(void);
+ #if CONSOLE_BENCH
+ void benchTask(void);
+ void benchEnd(void);
+ #endif
+ void pgmTask(void);
+ void progressTask(void);
+ void rxPrintRow(const uint8_t *Data, uint8_t Size);
+ void pgmJobUpload(void);
+ void pgmJobEnd(uint8_t Message);
+
+// maximal size of SPI packet
+#define SPI_PACKET_SIZE       64
+
+// default parameters of bench command
+#define BENCH_DEFAULT_COUNT   100
+#define BENCH_DEFAULT_SIZE    16
+
+// number of received bytes printed on one line
+#define RX_ROW_SIZE           16
+// size of printed line (hexadecimal bytes with separators, space, ASCII chars, CR LF)
+#define RX_ROW_LINE_SIZE      (RX_ROW_SIZE * 4 + 3)
+
+// states of programming job
+#define PGM_JOB_IDLE          0
+#define PGM_JOB_CHECK         1     // code file is checked
+#define PGM_JOB_WRITE         2     // code file is written
+#define PGM_JOB_KEY_OR_PASS   3     // user key or password is written
 
 /*
  * Variables
  */
 uint8_t   SDCardReady;
 uint8_t   UserBuffer[16];
+#if CONSOLE_COMPRESSED
+IQRF_PGM_LZ_STREAM CompressedFile;
+#endif
+
+uint8_t   TaskConsole;                      // task identifiers
+uint8_t   TaskRx;
+uint8_t   TaskSend;
+#if CONSOLE_BENCH
+uint8_t   TaskBench;
+#endif
+uint8_t   TaskPgm;
+uint8_t   TaskProgress;
+uint8_t   TaskOut;
+
+volatile uint8_t RxSize;                    // size of received packet waiting for output (0 = none)
+volatile uint8_t RxDropped;                 // number of packets dropped, because output was busy
+volatile uint16_t RxPackets;                // number of packets received from TR module
+uint8_t   RxData[SPI_PACKET_SIZE];
+uint8_t   RxRowPtr;                         // offset of next printed row of received packet
+uint8_t   RxPrinting;                       // header of received packet has been printed
+uint8_t   SendBuffer[SPI_PACKET_SIZE];      // packet of send and bench command
+uint8_t   SendSize;                         // size of packet being sent (0 = no packet)
+#if CONSOLE_BENCH
+uint16_t  BenchCount;                       // number of packets of bench job (0 = no job)
+uint16_t  BenchDone;                        // number of finished packets
+uint8_t   BenchSize;                        // size of packets
+uint16_t  BenchGap;                         // gap between packets in ticks
+uint8_t   BenchPacketStarted;               // packet is being sent
+uint16_t  BenchErrors;                      // packets not sent
+uint16_t  BenchRetries;                     // packets submitted again, because TR module was busy (counted once per packet)
+uint8_t   BenchPacketRetried;               // packet being sent has already been counted in BenchRetries
+uint16_t  BenchRxStart;                     // value of RxPackets at start of the job
+uint32_t  BenchStartTime;
+uint32_t  BenchPacketTime;                  // start time of packet being sent
+uint32_t  BenchNextTime;                    // start time of next packet
+uint32_t  BenchLatencySum;
+uint32_t  BenchLatencyMin;
+uint32_t  BenchLatencyMax;
+#endif
+uint8_t   PgmJobState;
+uint8_t   PgmJobCompressed;                 // code file of programming job is compressed
+uint8_t   PgmProgress;                      // progress of code file write (0 - 100)
+uint8_t   PgmProgressPrinted;               // number of printed progress bar chars
 
 extern File CodeFile;
 
@@ -60,7 +137,19 @@ void setup()
     SPI.begin();                            // start SPI peripheral for IQRF library
     iqrfInit(myIqrfRxFunc);                 // initialize IQRF library
 
-    Serial.println();
+    // console input and RX output run all the time, jobs are enabled by console commands
+    TaskConsole = taskAdd("console", consoleTask, true);
+    TaskRx = taskAdd("rx", rxTask, true);
+    TaskSend = taskAdd("send", sendTask, false);
+#if CONSOLE_BENCH
+    TaskBench = taskAdd("bench", benchTask, false);
+#endif
+    TaskPgm = taskAdd("pgm", pgmTask, false);
+    TaskProgress = taskAdd("progress", progressTask, false);
+    TaskOut = taskAdd("out", outTask, true);
+    runInit();
+
+    Out.println();
 }
 
 /**
@@ -68,35 +157,31 @@ void setup()
  */
 void loop()
 {
-    // console command processor
-    ccp();
-}
-
-
-/**
- * Converts the upper nibble of a binary value to a hexadecimal ASCII byte
- *
- * @param - B binary value to conversion
- * @return - ASCII char converted from upper nibble
- *
- */
-char bToHexa_high(uint8_t B)
-{
-    B >>= 4;
-    return ((B > 0x9) ? B+'A'-10 : B+'0');
+    // cooperative run-loop, long operations are done in steps by tasks
+    taskRun();
 }
 
 /**
- * Converts the lower nibble of a binary value to a hexadecimal ASCII byte.
- *
- * @param - B binary value to conversion
- * @return - ASCII char converted from lower nibble
- *
+ * Console input task
  */
-char bToHexa_low(uint8_t B)
+void consoleTask(void)
 {
-    B &= 0x0F;
-    return ((B > 0x9) ? B+'A'-10 : B+'0');
+#if CONSOLE_BINARY
+    if (BhpActive) {
+        // binary host protocol
+        bhpPoll();
+        return;
+    }
+#endif
+    if (RunActive) {
+        // any key stops running script
+        if (Serial.available() > 0) {
+            Serial.read();
+            runStop();
+        }
+    } else
+        // console command processor
+        ccp();
 }
 
 
@@ -110,40 +195,98 @@ char bToHexa_low(uint8_t B)
  */
 void myIqrfRxFunc(uint8_t *DataBuffer, uint8_t DataSize)
 {
-    Serial.println(CrLf);
-    sysMsgPrinter(CCP_RECEIVED_DATA);
-    for (uint8_t Cnt=0; Cnt<DataSize; Cnt++) {
-        Serial.print(DataBuffer[Cnt], HEX);
-        Serial.print(" ");
+    RxPackets++;
+    // packet is only stored, it is printed by RX task outside of IQRF driver
+    if (RxSize) {
+        RxDropped++;
+        return;
+    }
+    if (DataSize > sizeof(RxData))
+        DataSize = sizeof(RxData);
+    memcpy(RxData, DataBuffer, DataSize);
+    RxSize = DataSize;
+}
+
+/**
+ * RX output task, prints packet received from TR module
+ */
+void rxTask(void)
+{
+    uint8_t DataSize = RxSize;
+
+    if (!DataSize)
+        return;
+#if CONSOLE_BINARY
+    // binary host protocol streams received data without formatting
+    if (BhpActive) {
+        bhpSendRx(RxData, DataSize, RxDropped);
+        RxDropped = 0;
+        RxPrinting = false;
+        RxSize = 0;
+        return;
+    }
+#endif
+    if (!RxPrinting) {
+        Out.println(CrLf);
+        sysMsgPrinter(CCP_RECEIVED_DATA);
+        RxRowPtr = 0;
+        RxPrinting = true;
+    }
+    // one row per pass, packet is kept until its last row is in output ring (rows are never dropped)
+    if (RxRowPtr < DataSize) {
+        if (Out.space() < RX_ROW_LINE_SIZE)
+            return;
+        rxPrintRow(&RxData[RxRowPtr], DataSize - RxRowPtr > RX_ROW_SIZE ? RX_ROW_SIZE : DataSize - RxRowPtr);
+        RxRowPtr += RX_ROW_SIZE;
+        if (RxRowPtr < DataSize)
+            return;
     }
-    Serial.println();
-    for (uint8_t Cnt=0; Cnt<DataSize; Cnt++) {
-        if (DataBuffer[Cnt]<32 || DataBuffer[Cnt]>127)
-            Serial.write('.');
-        else
-            Serial.write(DataBuffer[Cnt]);
+    Out.println(CrLf);
+    if (RxDropped) {
+        Out.print(RxDropped);
+        Out.println(" packets dropped");
+        RxDropped = 0;
     }
-    Serial.println(CrLf);
-    Serial.print(CmdPrompt);                                // print prompt
+    Out.print(CmdPrompt);                                // print prompt
+    RxPrinting = false;
+    RxSize = 0;
+}
+
+/**
+ * Print one row of received data (hexadecimal and ASCII) to output ring
+ * @param Data pointer to data of the row
+ * @param Size number of bytes in the row (up to RX_ROW_SIZE)
+ */
+void rxPrintRow(const uint8_t *Data, uint8_t Size)
+{
+    char Line[RX_ROW_LINE_SIZE];
+    uint8_t Ptr;
+
+    // whole row is formatted first and passed to output ring at once
+    Ptr = outHexEncode(Line, Data, Size, ' ');
+    for (uint8_t Cnt=Size; Cnt<RX_ROW_SIZE; Cnt++) {
+        memcpy(&Line[Ptr], "   ", 3);
+        Ptr += 3;
+    }
+    Line[Ptr++] = ' ';
+    for (uint8_t Cnt=0; Cnt<Size; Cnt++)
+        Line[Ptr++] = (Data[Cnt]<32 || Data[Cnt]>127) ? '.' : Data[Cnt];
+    Line[Ptr++] = '\r';
+    Line[Ptr++] = '\n';
+    Out.post(Line, Ptr);
 }
 
 
 /**
- * Send SPI packet to TR module
- * @param DataBuff Pointer to buffer with SPI packet
- * @param DataSize Size of packet
- * @return Operation result
+ * Send task, sends packet of send command to TR module
  */
-uint8_t sendMyIqrfPacket(uint8_t *DataBuff, uint8_t DataSize)
+void sendTask(void)
 {
     uint8_t Message;
     uint8_t OpResult;
 
-    // "Sending data" message
-    sysMsgPrinter(CCP_SENDING_DATA);
-    // send data and wait for result
-    while((OpResult = iqrfSendData(DataBuff, DataSize)) == IQRF_OPERATION_IN_PROGRESS)
-        ;   /* void */
+    if ((OpResult = iqrfSendData(SendBuffer, SendSize)) == IQRF_OPERATION_IN_PROGRESS)
+        return;
 
     switch(OpResult) {
     case IQRF_OPERATION_OK:                         // data sent OK
@@ -155,13 +298,117 @@ uint8_t sendMyIqrfPacket(uint8_t *DataBuff, uint8_t DataSize)
     case IQRF_TR_MODULE_NOT_READY:                  // TR module not ready
         Message = CCP_TR_NOT_READY;
         break;
+    case IQRF_TR_MODULE_BUSY:                       // TR module buffer is full
+        Message = CCP_TR_BUSY;
+        break;
     case IQRF_WRONG_DATA_SIZE:                      // Data size error
         Message = CCP_BAD_PARAMETER;
         break;
     }
     sysMsgPrinter(Message);
+    Out.print(CrLf);
+    Out.print(CmdPrompt);
+
+    SendSize = 0;
+    taskEnable(TaskSend, false);
+}
+
+#if CONSOLE_BENCH
+/**
+ * Bench task, sends packets of bench command to TR module back to back
+ */
+void benchTask(void)
+{
+    uint8_t OpResult;
+    uint32_t Latency;
+
+    if (!BenchPacketStarted) {
+        // gap between packets
+        if ((int32_t)(iqrfGetSysTick() - BenchNextTime) < 0)
+            return;
+        // packet number in the first bytes, the receiver can detect lost packets
+        SendBuffer[0] = BenchDone >> 8;
+        if (BenchSize > 1)
+            SendBuffer[1] = BenchDone & 0x00FF;
+        BenchPacketTime = iqrfGetSysTick();
+        BenchPacketStarted = true;
+        BenchPacketRetried = false;
+    }
+
+    if ((OpResult = iqrfSendData(SendBuffer, BenchSize)) == IQRF_OPERATION_IN_PROGRESS)
+        return;
+    if (OpResult == IQRF_TR_MODULE_BUSY) {
+        // TR module buffer is full, the packet is submitted again in next pass
+        if (!BenchPacketRetried) {
+            BenchRetries++;
+            BenchPacketRetried = true;
+        }
+        return;
+    }
+    if (OpResult != IQRF_OPERATION_OK)
+        BenchErrors++;
+
+    // completion latency includes waiting for TR module buffer
+    Latency = iqrfGetSysTick() - BenchPacketTime;
+    BenchLatencySum += Latency;
+    if (Latency < BenchLatencyMin)
+        BenchLatencyMin = Latency;
+    if (Latency > BenchLatencyMax)
+        BenchLatencyMax = Latency;
+
+    BenchPacketStarted = false;
+    BenchNextTime = iqrfGetSysTick() + BenchGap;
+    if (++BenchDone == BenchCount)
+        benchEnd();
+}
+
+/**
+ * Finish bench job and print its results
+ */
+void benchEnd(void)
+{
+    uint32_t Time = iqrfGetSysTick() - BenchStartTime;
+
+    Out.print(BenchDone);
+    Out.print(" packets in ");
+    Out.print(Time);
+    Out.print(" ms, ");
+    Out.print(Time ? BenchDone * (uint32_t)TICKS_IN_SECOND / Time : 0);
+    Out.println(" packets/s");
+    Out.print(BenchErrors);
+    Out.print(" errors, ");
+    Out.print(BenchRetries);
+    Out.println(" packets retried");
+    if (BenchDone) {
+        Out.print("latency min ");
+        Out.print(BenchLatencyMin);
+        Out.print(" / avg ");
+        Out.print(BenchLatencySum / BenchDone);
+        Out.print(" / max ");
+        Out.print(BenchLatencyMax);
+        Out.println(" ms");
+    }
+    Out.print((uint16_t)(RxPackets - BenchRxStart));
+    Out.println(" packets received");
+
+    BenchCount = 0;
+    taskEnable(TaskBench, false);
+    Out.print(CrLf);
+    Out.print(CmdPrompt);
+}
+#endif
 
-    return(OpResult);
+/**
+ * Check whether TR module is used by a job of console command
+ * @return true = send, bench or programming job is running
+ */
+uint8_t trJobRunning(void)
+{
+#if CONSOLE_BENCH
+    if (BenchCount)
+        return(true);
+#endif
+    return(SendSize || PgmJobState != PGM_JOB_IDLE);
 }
 
 
@@ -179,15 +426,16 @@ const char OSModuleIbk[] PROGMEM = {"Module IBK     : "};
 void ccpTrModuleInfo(uint16_t CommandParameter)
 {
     uint8_t Ptr, I;
-    char TempString[32];
+    uint8_t Bytes[16];
+    char TempString[52];
 
     // decode and print module type
-    Serial.print(CrLf);
+    Out.print(CrLf);
     strcpy_P(TempString, OSModuleType);
-    Serial.print(TempString);
+    Out.print(TempString);
 
     if (iqrfGetMcuType() == MCU_UNKNOWN) {
-        Serial.print("UNKNOWN");
+        Out.print("UNKNOWN");
     } else {
         Ptr=0;
         if (iqrfGetModuleId() & 0x80000000L) {
@@ -236,57 +484,53 @@ void ccpTrModuleInfo(uint16_t CommandParameter)
             TempString[Ptr++] = 'D';
         TempString[Ptr++] = 'x';
         TempString[Ptr++] = 0;
-        Serial.println(TempString);
+        Out.println(TempString);
 
         // print module MCU
         strcpy_P(TempString, OSModuleType);
-        Serial.print(TempString);
+        Out.print(TempString);
         switch (iqrfGetMcuType()) {
         case PIC16LF819:
-            Serial.println("PIC16LF819");
+            Out.println("PIC16LF819");
             break;
         case PIC16LF88:
-            Serial.println("PIC16LF88");
+            Out.println("PIC16LF88");
             break;
         case PIC16F886:
-            Serial.println("PIC16F886");
+            Out.println("PIC16F886");
             break;
         case PIC16LF1938:
-            Serial.println("PIC16LF1938");
+            Out.println("PIC16LF1938");
             break;
         }
 
         // print module ID
         strcpy_P(TempString, OSModuleId);
-        Serial.print(TempString);
-        Serial.println(iqrfGetModuleId(), HEX);
+        Out.print(TempString);
+        Out.println(iqrfGetModuleId(), HEX);
 
         // print module IBK
         strcpy_P(TempString, OSModuleIbk);
-        Serial.print(TempString);
+        Out.print(TempString);
         I = iqrfGetOsVersion() >> 8;
         // if OS version is 4.03 and more, print IBK
         if ((I > 4) || ((I == 4) && ((iqrfGetOsVersion() & 0x00FF) >= 3))) {
-            for (I=0; I<16; I++) {
-                TempString[0] = bToHexa_high(iqrfGetModuleIbk(I));
-                TempString[1] = bToHexa_low(iqrfGetModuleIbk(I));
-                TempString[2] = 0x20;
-                TempString[3] = 0x00;
-                Serial.print(TempString);
-                if (I == 15)
-                    Serial.println();
-            }
+            for (I=0; I<16; I++)
+                Bytes[I] = iqrfGetModuleIbk(I);
+            Ptr = outHexEncode(TempString, Bytes, sizeof(Bytes), ' ');
+            TempString[Ptr] = 0;
+            Out.println(TempString);
         } else {
-            Serial.println("---");
+            Out.println("---");
         }
 
         // print OS version string
         strcpy_P(TempString, OSModuleOsVer);
-        Serial.print(TempString);
+        Out.print(TempString);
         Ptr = 0;
 
         // major version
-        TempString[Ptr++] = bToHexa_low(iqrfGetOsVersion() >> 8);
+        TempString[Ptr++] = OutHexChars[(iqrfGetOsVersion() >> 8) & 0x0F];
         TempString[Ptr++] = '.';
 
         // minor version
@@ -306,20 +550,19 @@ void ccpTrModuleInfo(uint16_t CommandParameter)
         // OS build
         TempString[Ptr++] = ' ';
         TempString[Ptr++] = '(';
-        TempString[Ptr++] = bToHexa_high(iqrfGetOsBuild() >> 8);
-        TempString[Ptr++] = bToHexa_low(iqrfGetOsBuild() >> 8);
-        TempString[Ptr++] = bToHexa_high(iqrfGetOsBuild() & 0x00FF);
-        TempString[Ptr++] = bToHexa_low(iqrfGetOsBuild() & 0x00FF);
+        Bytes[0] = iqrfGetOsBuild() >> 8;
+        Bytes[1] = iqrfGetOsBuild() & 0x00FF;
+        Ptr += outHexEncode(&TempString[Ptr], Bytes, 2, 0);
         TempString[Ptr++] = ')';
         TempString[Ptr] = 0;
-        Serial.println(TempString);
+        Out.println(TempString);
 
         strcpy_P(TempString, OSModuleFCC);
-        Serial.print(TempString);
-        Serial.println(iqrfGetFccStatus() ? "YES" : "NO");
+        Out.print(TempString);
+        Out.println(iqrfGetFccStatus() ? "YES" : "NO");
     }
 
-    Serial.println();
+    Out.println();
 }
 
 
@@ -330,30 +573,199 @@ void ccpTrModuleInfo(uint16_t CommandParameter)
  */
 void ccpTrSendData(uint16_t CommandParameter)
 {
-    uint8_t CcpStringSize;
+    // TR module is used by running job
+    if (trJobRunning()) {
+        sysMsgPrinter(CCP_TR_BUSY);
+        return;
+    }
+    SendSize = ccpReadString((char *)SendBuffer);
+    if (SendSize == 0) {
+        sysMsgPrinter(CCP_BAD_PARAMETER);
+        return;
+    }
+    // "Sending data" message, result is printed by send task
+    sysMsgPrinter(CCP_SENDING_DATA);
+    taskEnable(TaskSend, true);
+}
+
+
+/**
+ * Run command script from SD card (run file)
+ * @param CommandParameter parameter from CCP command table
+ * @return none
+ * @note The command only starts the script, it is run by script runner task
+ */
+void ccpRun(uint16_t CommandParameter)
+{
+    if (!SDCardReady) {
+        sysMsgPrinter(CCP_SD_CARD_ERR);
+    } else if (RunActive) {
+        sysMsgPrinter(CCP_TR_BUSY);
+    } else if (!ccpFindCmdParameter(CcpCommandParameter)) {
+        sysMsgPrinter(CCP_BAD_PARAMETER);
+    } else if (!runStart(CcpCommandParameter)) {
+        sysMsgPrinter(CCP_FILE_NOT_FOUND);
+    }
+}
+
+
+#if CONSOLE_BENCH
+/**
+ * Measure throughput of TX path (bench [count [size [gap]]] / bench stop)
+ * @param CommandParameter parameter from CCP command table
+ * @return none
+ * @note The command only starts bench job, results are printed by bench task
+ */
+void ccpBench(uint16_t CommandParameter)
+{
+    uint32_t Param[3] = {BENCH_DEFAULT_COUNT, BENCH_DEFAULT_SIZE, 0};
+
+    if (ccpFindCmdParameter(CcpCommandParameter) && strcmp("stop",CcpCommandParameter) == 0) {
+        // results of finished packets are printed, packet being sent is completed by IQRF driver
+        if (BenchCount && !BenchPacketStarted)
+            benchEnd();
+        else if (BenchCount)
+            BenchCount = BenchDone + 1;
+        return;
+    }
+    if (trJobRunning()) {
+        sysMsgPrinter(CCP_TR_BUSY);
+        return;
+    }
+    // packet count, payload size and gap between packets in ms
+    for (uint8_t Cnt=0; Cnt<3 && CcpCommandParameter[0]; Cnt++) {
+        Param[Cnt] = strtoul(CcpCommandParameter, NULL, 10);
+        ccpFindCmdParameter(CcpCommandParameter);
+    }
+    if (Param[0] == 0 || Param[0] > 0xFFFF || Param[1] == 0 || Param[1] > SPI_PACKET_SIZE || Param[2] > 0xFFFF) {
+        sysMsgPrinter(CCP_BAD_PARAMETER);
+        return;
+    }
 
-    CcpStringSize = ccpReadString(CcpCommandParameter);
-    sendMyIqrfPacket((uint8_t *)CcpCommandParameter, CcpStringSize);
+    for (uint8_t Cnt=0; Cnt<Param[1]; Cnt++)
+        SendBuffer[Cnt] = Cnt;
+    BenchCount = Param[0];
+    BenchSize = Param[1];
+    BenchGap = Param[2] * TICKS_IN_SECOND / 1000;
+    BenchDone = 0;
+    BenchErrors = 0;
+    BenchRetries = 0;
+    BenchLatencySum = 0;
+    BenchLatencyMin = 0xFFFFFFFFUL;
+    BenchLatencyMax = 0;
+    BenchPacketStarted = false;
+    BenchRxStart = RxPackets;
+    BenchStartTime = iqrfGetSysTick();
+    BenchNextTime = BenchStartTime;
+    Out.print("Bench ");
+    Out.print(BenchCount);
+    Out.print(" x ");
+    Out.print(BenchSize);
+    Out.println(" B");
+    taskEnable(TaskBench, true);
+}
+#endif
+
+
+/**
+ * Print run time statistics of tasks (tasks / tasks clear)
+ * @param CommandParameter parameter from CCP command table
+ * @return none
+ */
+void ccpTaskStats(uint16_t CommandParameter)
+{
+    if (ccpFindCmdParameter(CcpCommandParameter) && strcmp("clear",CcpCommandParameter) == 0) {
+        taskClearStats();
+        Out.Dropped = 0;
+        Out.HighWatermark = 0;
+        return;
+    }
+    taskPrintStats();
+    // output ring statistics
+    Out.print("out ring: max ");
+    Out.print(Out.HighWatermark);
+    Out.print(" of ");
+    Out.print(OUT_RING_SIZE);
+    Out.print(" B, ");
+    Out.print(Out.Dropped);
+    Out.println(" B dropped");
+}
+
+
+#if CONSOLE_BINARY
+/**
+ * Switch serial line to binary host protocol (bin / bin baudrate)
+ * @param CommandParameter parameter from CCP command table
+ * @return none
+ * @note Text output of running job or script would be mixed with binary frames, so the command is refused
+ */
+void ccpBinMode(uint16_t CommandParameter)
+{
+    uint32_t Baud = BHP_DEFAULT_BAUD;
+
+    if (trJobRunning() || RunActive) {
+        sysMsgPrinter(CCP_TR_BUSY);
+        return;
+    }
+    if (ccpFindCmdParameter(CcpCommandParameter)) {
+        Baud = strtoul(CcpCommandParameter, NULL, 10);
+        if (Baud == 0) {
+            sysMsgPrinter(CCP_BAD_PARAMETER);
+            return;
+        }
+    }
+    Out.print("Binary mode, ");
+    Out.print(Baud);
+    Out.println(" Bd");
+    bhpStart(Baud);
+}
+#endif
+
+
+/**
+ * Select delta programming mode (delta on / delta off / delta force)
+ * @param CommandParameter parameter from CCP command table
+ * @return none
+ */
+void ccpPgmDelta(uint16_t CommandParameter)
+{
+    if (!ccpFindCmdParameter(CcpCommandParameter)) {
+        sysMsgPrinter(CCP_BAD_PARAMETER);
+        return;
+    }
+    if (strcmp("on",CcpCommandParameter) == 0)
+        // write only changed blocks
+        iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_ON);
+    else if (strcmp("off",CcpCommandParameter) == 0)
+        // write all blocks
+        iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_OFF);
+    else if (strcmp("force",CcpCommandParameter) == 0)
+        // write all blocks and rebuild delta manifest
+        iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_FORCE);
+    else
+        sysMsgPrinter(CCP_BAD_PARAMETER);
 }
 
 
 const char ProgressBar[] PROGMEM = {'-','-','-','-','-','-','-','-','-','-',0x0D,0x00};
 /**
  * Programm IQRF / HEX /TRCNFG  file to TR module
- * @param CommandParameter parameter from CCP command table
+ * @param CommandParameter parameter from CCP command table (0 = check and upload, 1 = single pass upload)
  * @return none
+ * @note The command only starts programming job, the job is run by programming task
  */
 void ccpPgmFile(uint16_t CommandParameter)
 {
     uint8_t Message = 0;
-    uint8_t TempVariable;
-    uint8_t StoreProgress;
     uint8_t Cnt;
     char Filename[26];
 
     // if SD card is not ready print error msg
     if (!SDCardReady) {
         sysMsgPrinter(CCP_SD_CARD_ERR);
+    } else if (trJobRunning()) {
+        // TR module is used by running job
+        sysMsgPrinter(CCP_TR_BUSY);
     } else {
         // read file type
         if (ccpFindCmdParameter(CcpCommandParameter)) {
@@ -367,6 +779,12 @@ void ccpPgmFile(uint16_t CommandParameter)
             else if (strcmp("trcnfg",CcpCommandParameter) == 0)
                 // set TRCNFG filetype
                 CodeFileInfo.FileType = IQRF_PGM_CFG_FILE_TYPE;
+            else if (strcmp("img",CcpCommandParameter) == 0)
+                // set binary block image filetype
+                CodeFileInfo.FileType = IQRF_PGM_IMAGE_FILE_TYPE;
+            else if (strcmp("lz",CcpCommandParameter) == 0)
+                // compressed code file, type of code file is read from the file
+                CodeFileInfo.FileType = 0;
             else if (strcmp("pass",CcpCommandParameter) == 0)
                 // set USER PASSWORD filetype
                 CodeFileInfo.FileType = IQRF_PGM_PASS_FILE_TYPE;
@@ -404,7 +822,18 @@ void ccpPgmFile(uint16_t CommandParameter)
             if (CodeFile) {
                 // read size of file
                 CodeFileInfo.FileSize = CodeFile.size();
-                if (CodeFileInfo.FileType == IQRF_PGM_PASS_FILE_TYPE || CodeFileInfo.FileType == IQRF_PGM_KEY_FILE_TYPE) {
+                // decompress compressed code file during reading, password and key files are not compressed
+                PgmJobCompressed = false;
+#if CONSOLE_COMPRESSED
+                if (CodeFileInfo.FileType == 0) {
+                    PgmJobCompressed = iqrfPgmSetCompressedStream(&CompressedFile, NULL, NULL);
+                    if (!PgmJobCompressed || CodeFileInfo.FileType == IQRF_PGM_PASS_FILE_TYPE || CodeFileInfo.FileType == IQRF_PGM_KEY_FILE_TYPE)
+                        CodeFileInfo.FileType = 0;
+                }
+#endif
+                if (CodeFileInfo.FileType == 0) {
+                    Message = CCP_FILE_FORMAT_ERR;
+                } else if (CodeFileInfo.FileType == IQRF_PGM_PASS_FILE_TYPE || CodeFileInfo.FileType == IQRF_PGM_KEY_FILE_TYPE) {
                     if (CodeFileInfo.FileSize != 16) {
                         Message = CCP_FILE_FORMAT_ERR;
                     } else {
@@ -413,62 +842,152 @@ void ccpPgmFile(uint16_t CommandParameter)
                             UserBuffer[Cnt] = iqrfReadByteFromFile();
                         iqrfRunDriver();
                         sysMsgPrinter(CCP_UPLOADING);    // message "Uploading..."
-                        // write user password of user key to TR module
-                        while ((TempVariable = iqrfPgmWriteKeyOrPass(CodeFileInfo.FileType, UserBuffer)) == 0)
-                            ;   /* void */
-                        // check result of programming operation
-                        if (TempVariable == IQRF_PGM_SUCCESS)
-                            Message = CCP_FILE_WRITE_OK;
-                        else
-                            Message = CCP_PROGRAMMING_ERR;
+                        PgmJobState = PGM_JOB_KEY_OR_PASS;
                     }
-                    sysMsgPrinter(Message);
+                } else if (CommandParameter) {
+                    // single pass programming, code file is checked during upload
+                    pgmJobUpload();
                 } else {
                     sysMsgPrinter(CCP_CHECKING);
-                    // check if code file is correct
-                    while ((TempVariable = iqrfPgmCheckCodeFile()) <= 100)
-                        ;   /* void */
-                    // if format of code file is correct
-                    if (TempVariable == IQRF_PGM_SUCCESS) {
-                        sysMsgPrinter(CCP_CODE_FILE_OK);
-                        // rewind code file
-                        iqrfSuspendDriver();
-                        CodeFile.seek(0);
-                        iqrfRunDriver();
+                    PgmJobState = PGM_JOB_CHECK;
+                }
 
-                        sysMsgPrinter(CCP_UPLOADING);    // message "Uploading..."
-                        strcpy_P(Filename, ProgressBar);
-                        Serial.print(Filename);
-                        StoreProgress = 0;
-                        // write code file to TR module
-                        while ((TempVariable = iqrfPgmWriteCodeFile()) <= 100) {
-                            // during code file storing, print progress bar
-                            while (StoreProgress < TempVariable/10) {
-                                Serial.write('*');
-                                StoreProgress++;
-                            }
-                        }
-                        // if code file written OK
-                        if (TempVariable == IQRF_PGM_SUCCESS) {
-                            while (StoreProgress < 10) {
-                               Serial.write('*');
-                               StoreProgress++;
-                           }
-                           Serial.println();
-                           sysMsgPrinter(CCP_FILE_WRITE_OK);
-                        } else {
-                          Serial.println();
-                          sysMsgPrinter(CCP_PROGRAMMING_ERR);
-                        }
-                    } else {
-                        // if format of code file is wrong, print error msg
-                        sysMsgPrinter(CCP_FILE_FORMAT_ERR);
-                    }
+                if (Message) {
+                    sysMsgPrinter(Message);
+                    CodeFile.close();   // close file
+                    // select default input stream again
+                    if (PgmJobCompressed)
+                        iqrfPgmSetStream(NULL, NULL);
+                } else {
+                    // job continues in background, console stays responsive
+                    taskEnable(TaskPgm, true);
                 }
-                CodeFile.close();   // close file
             } else {   // if code file not exist, print error msg
                 sysMsgPrinter(CCP_FILE_NOT_FOUND);
             }
         }
     }
 }
+
+
+/**
+ * Programming task, runs one step of programming job
+ */
+void pgmTask(void)
+{
+    uint8_t Result;
+
+    switch (PgmJobState) {
+    case PGM_JOB_CHECK:
+        // check if code file is correct
+        if ((Result = iqrfPgmCheckCodeFile()) <= 100)
+            return;
+        if (Result != IQRF_PGM_SUCCESS) {
+            // if format of code file is wrong, print error msg
+            pgmJobEnd(CCP_FILE_FORMAT_ERR);
+            return;
+        }
+        sysMsgPrinter(CCP_CODE_FILE_OK);
+        // rewind code file
+        iqrfSuspendDriver();
+        CodeFile.seek(0);
+        iqrfRunDriver();
+        pgmJobUpload();
+        break;
+
+    case PGM_JOB_WRITE:
+        // write code file to TR module, progress bar is printed by progress task
+        if ((Result = iqrfPgmWriteCodeFile()) <= 100) {
+            PgmProgress = Result;
+            return;
+        }
+        if (Result == IQRF_PGM_SUCCESS) {
+            PgmProgress = 100;
+            pgmJobEnd(CCP_FILE_WRITE_OK);
+        } else if (Result == IQRF_PGM_FORMAT_ERROR) {
+            pgmJobEnd(CCP_FILE_FORMAT_ERR);
+        } else {
+            pgmJobEnd(CCP_PROGRAMMING_ERR);
+        }
+        break;
+
+    case PGM_JOB_KEY_OR_PASS:
+        // write user password of user key to TR module
+        if ((Result = iqrfPgmWriteKeyOrPass(CodeFileInfo.FileType, UserBuffer)) == 0)
+            return;
+        pgmJobEnd(Result == IQRF_PGM_SUCCESS ? CCP_FILE_WRITE_OK : CCP_PROGRAMMING_ERR);
+        break;
+
+    default:
+        taskEnable(TaskPgm, false);
+        break;
+    }
+}
+
+/**
+ * Progress output task, prints progress bar of code file write
+ */
+void progressTask(void)
+{
+    while (PgmProgressPrinted < PgmProgress/10) {
+        Out.write('*');
+        PgmProgressPrinted++;
+    }
+}
+
+/**
+ * Start write of checked code file
+ */
+void pgmJobUpload(void)
+{
+    char Bar[12];
+
+    sysMsgPrinter(CCP_UPLOADING);    // message "Uploading..."
+    strcpy_P(Bar, ProgressBar);
+    Out.print(Bar);
+    PgmProgress = 0;
+    PgmProgressPrinted = 0;
+    PgmJobState = PGM_JOB_WRITE;
+    taskEnable(TaskProgress, true);
+}
+
+/**
+ * Finish programming job
+ * @param Message result message of the job
+ */
+void pgmJobEnd(uint8_t Message)
+{
+    if (PgmJobState == PGM_JOB_WRITE) {
+        // complete progress bar
+        progressTask();
+        Out.println();
+    }
+    sysMsgPrinter(Message);
+    if (PgmJobState == PGM_JOB_WRITE && Message == CCP_FILE_WRITE_OK) {
+        // print number of written and skipped (delta mode) packets
+        Out.print(IqrfPgmContext.Stats.PacketsSent);
+        Out.print(" packets written, ");
+        Out.print(IqrfPgmContext.Stats.PacketsSkipped);
+        Out.println(" unchanged packets skipped");
+#if CONSOLE_COMPRESSED
+        if (PgmJobCompressed) {
+            // print SD card reads saved by compression (check and upload)
+            Out.print(CompressedFile.BytesRead);
+            Out.print(" bytes read from compressed file, ");
+            Out.print((long)(CompressedFile.BytesDecoded - CompressedFile.BytesRead));
+            Out.println(" bytes saved");
+        }
+#endif
+    }
+
+    CodeFile.close();   // close file
+    // select default input stream again
+    if (PgmJobCompressed)
+        iqrfPgmSetStream(NULL, NULL);
+
+    PgmJobState = PGM_JOB_IDLE;
+    taskEnable(TaskPgm, false);
+    taskEnable(TaskProgress, false);
+    Out.print(CrLf);
+    Out.print(CmdPrompt);
+}
@@ -0,0 +1,283 @@
+/**
+ * @file Binary host protocol of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "bhp.h"
+#include "ccp.h"
+#include "out.h"
+#include <IQRF.h>
+
+// binary host protocol is optional feature of the console, see CONSOLE_BINARY in ccptab.h
+#if CONSOLE_BINARY
+
+/* function prototypes */
+void bhpProcessFrame(uint8_t Size);
+void bhpSendFrame(uint8_t Type, uint8_t Seq, const uint8_t *Payload, uint8_t Size);
+void bhpSendStatus(uint8_t Seq, uint8_t Result);
+
+/* global variables */
+uint8_t BhpActive;                        // serial line is used by binary host protocol
+uint32_t BhpBaud;                         // baud rate to be set (0 = already set)
+uint8_t BhpInFrame[BHP_MAX_ENCODED];      // received frame
+uint8_t BhpInPtr;
+uint8_t BhpInOverflow;                    // received frame is too long, it is dropped
+uint8_t BhpRxSeq;                         // sequence number of next RX frame
+uint8_t BhpTxData[BHP_MAX_PAYLOAD];       // SPI packet being sent to TR module
+uint8_t BhpTxSize;
+uint8_t BhpTxSeq;
+uint8_t BhpTxPending;
+
+/**
+ * Switch serial line to binary host protocol
+ * @param Baud baud rate of binary protocol
+ */
+void bhpStart(uint32_t Baud)
+{
+    BhpInPtr = 0;
+    BhpInOverflow = false;
+    BhpTxPending = false;
+    // baud rate is changed in bhpPoll(), after response of console command is sent
+    BhpBaud = Baud;
+    BhpActive = true;
+}
+
+/**
+ * Return to text console
+ */
+void bhpStop(void)
+{
+    Out.flush();
+    Serial.flush();
+    Serial.begin(BHP_CONSOLE_BAUD);
+    BhpActive = false;
+    Out.print(CrLf);
+    Out.print(CmdPrompt);
+}
+
+/**
+ * Process received frames and pending TX packet (called from main loop)
+ */
+void bhpPoll(void)
+{
+    uint8_t Byte;
+    uint8_t Result;
+
+    if (BhpBaud) {
+        Out.flush();
+        Serial.flush();
+        Serial.begin(BhpBaud);
+        BhpBaud = 0;
+    }
+
+    while (BhpActive && Serial.available() > 0) {
+        Byte = Serial.read();
+        if (Byte != 0) {
+            if (BhpInPtr < sizeof(BhpInFrame))
+                BhpInFrame[BhpInPtr++] = Byte;
+            else
+                BhpInOverflow = true;
+            continue;
+        }
+        // end of frame (empty frames are used by the host for synchronization)
+        if (BhpInOverflow)
+            bhpSendStatus(0, BHP_RESULT_FRAME_ERR);
+        else if (BhpInPtr)
+            bhpProcessFrame(bhpCobsDecode(BhpInFrame, BhpInPtr));
+        BhpInPtr = 0;
+        BhpInOverflow = false;
+    }
+
+    // TX packet is passed directly to IQRF driver, result is reported when the packet is sent
+    if (BhpTxPending && (Result = iqrfSendData(BhpTxData, BhpTxSize)) != IQRF_OPERATION_IN_PROGRESS) {
+        BhpTxPending = false;
+        bhpSendStatus(BhpTxSeq, Result);
+    }
+}
+
+/**
+ * Process decoded frame received from the host
+ * @param Size size of decoded frame
+ */
+void bhpProcessFrame(uint8_t Size)
+{
+    uint8_t Seq;
+
+    // frame: type, sequence number, payload, CRC
+    if (Size < 4 || bhpCrc16(BhpInFrame, Size - 2) != (((uint16_t)BhpInFrame[Size - 2] << 8) | BhpInFrame[Size - 1])) {
+        bhpSendStatus(Size >= 2 ? BhpInFrame[1] : 0, BHP_RESULT_FRAME_ERR);
+        return;
+    }
+    Seq = BhpInFrame[1];
+    Size -= 4;
+
+    switch (BhpInFrame[0]) {
+    case BHP_FRAME_TX:
+        if (BhpTxPending) {
+            bhpSendStatus(Seq, IQRF_TR_MODULE_BUSY);
+        } else if (Size == 0 || Size > BHP_MAX_PAYLOAD) {
+            bhpSendStatus(Seq, IQRF_WRONG_DATA_SIZE);
+        } else {
+            memcpy(BhpTxData, &BhpInFrame[2], Size);
+            BhpTxSize = Size;
+            BhpTxSeq = Seq;
+            BhpTxPending = true;
+        }
+        break;
+    case BHP_FRAME_STATUS_REQ:
+        bhpSendStatus(Seq, BhpTxPending ? IQRF_OPERATION_IN_PROGRESS : IQRF_OPERATION_OK);
+        break;
+    case BHP_FRAME_EXIT:
+        // pending TX packet must be finished first
+        if (BhpTxPending) {
+            bhpSendStatus(Seq, IQRF_TR_MODULE_BUSY);
+        } else {
+            bhpSendStatus(Seq, IQRF_OPERATION_OK);
+            bhpStop();
+        }
+        break;
+    default:
+        bhpSendStatus(Seq, BHP_RESULT_FRAME_ERR);
+        break;
+    }
+}
+
+/**
+ * Send SPI packet received from TR module to the host
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ * @param Dropped number of packets received and dropped before this one
+ */
+void bhpSendRx(uint8_t *DataBuffer, uint8_t DataSize, uint8_t Dropped)
+{
+    // dropped packets skip their sequence numbers, so the host sees the gap
+    BhpRxSeq += Dropped;
+    bhpSendFrame(BHP_FRAME_RX, BhpRxSeq++, DataBuffer, DataSize > BHP_MAX_PAYLOAD ? BHP_MAX_PAYLOAD : DataSize);
+}
+
+/**
+ * Send STATUS frame to the host
+ * @param Seq sequence number of request
+ * @param Result result code of request
+ */
+void bhpSendStatus(uint8_t Seq, uint8_t Result)
+{
+    uint8_t Status[2];
+
+    Status[0] = Result;
+    Status[1] = iqrfGetSpiStatus();
+    bhpSendFrame(BHP_FRAME_STATUS, Seq, Status, sizeof(Status));
+}
+
+/**
+ * Send frame to the host
+ * @param Type type of frame
+ * @param Seq sequence number
+ * @param Payload pointer to payload
+ * @param Size size of payload (up to BHP_MAX_PAYLOAD)
+ */
+void bhpSendFrame(uint8_t Type, uint8_t Seq, const uint8_t *Payload, uint8_t Size)
+{
+    // local buffers, RAM is used only while the frame is sent
+    uint8_t Frame[BHP_MAX_FRAME];
+    uint8_t Encoded[BHP_MAX_ENCODED];
+    uint16_t Crc;
+    uint8_t EncodedSize;
+
+    Frame[0] = Type;
+    Frame[1] = Seq;
+    memcpy(&Frame[2], Payload, Size);
+    Crc = bhpCrc16(Frame, Size + 2);
+    Frame[Size + 2] = Crc >> 8;
+    Frame[Size + 3] = Crc & 0x00FF;
+    EncodedSize = bhpCobsEncode(Frame, Size + 4, Encoded);
+    Encoded[EncodedSize++] = 0;
+    // whole frame or nothing, the host detects lost frame by sequence number
+    Out.post((const char *)Encoded, EncodedSize);
+}
+
+/**
+ * Encode frame by COBS
+ * @param Source pointer to frame
+ * @param Size size of frame (up to 253 bytes)
+ * @param Destination pointer to buffer for encoded frame
+ * @return size of encoded frame
+ */
+uint8_t bhpCobsEncode(const uint8_t *Source, uint8_t Size, uint8_t *Destination)
+{
+    uint8_t CodePtr = 0;
+    uint8_t Ptr = 1;
+    uint8_t Code = 1;
+
+    // every zero byte is replaced by distance to next zero byte
+    for (uint8_t Cnt=0; Cnt<Size; Cnt++) {
+        if (Source[Cnt] == 0) {
+            Destination[CodePtr] = Code;
+            CodePtr = Ptr++;
+            Code = 1;
+        } else {
+            Destination[Ptr++] = Source[Cnt];
+            Code++;
+        }
+    }
+    Destination[CodePtr] = Code;
+    return(Ptr);
+}
+
+/**
+ * Decode COBS encoded frame in place
+ * @param Data pointer to encoded frame without delimiter
+ * @param Size size of encoded frame
+ * @return size of decoded frame, 0 = format error
+ */
+uint8_t bhpCobsDecode(uint8_t *Data, uint8_t Size)
+{
+    uint8_t Ptr = 0;
+    uint8_t DecodedPtr = 0;
+    uint8_t Code;
+
+    while (Ptr < Size) {
+        Code = Data[Ptr++];
+        if (Code == 0 || (uint16_t)Ptr + Code - 1 > Size)
+            return(0);
+        for (uint8_t Cnt=1; Cnt<Code; Cnt++)
+            Data[DecodedPtr++] = Data[Ptr++];
+        if (Code < 0xFF && Ptr < Size)
+            Data[DecodedPtr++] = 0;
+    }
+    return(DecodedPtr);
+}
+
+/**
+ * Compute CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF)
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return CRC of data
+ */
+uint16_t bhpCrc16(const uint8_t *Data, uint8_t Size)
+{
+    uint16_t Crc = 0xFFFF;
+
+    while (Size--) {
+        Crc ^= (uint16_t)*Data++ << 8;
+        for (uint8_t Cnt=0; Cnt<8; Cnt++)
+            Crc = (Crc & 0x8000) ? (Crc << 1) ^ 0x1021 : Crc << 1;
+    }
+    return(Crc);
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file Binary host protocol of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BHP_H
+#define _BHP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// frame: type, sequence number, payload, CRC-16/CCITT (big-endian), COBS encoded and terminated by 0x00
+#define BHP_FRAME_TX          0x01      // host -> console, SPI packet for TR module
+#define BHP_FRAME_RX          0x02      // console -> host, SPI packet received from TR module
+#define BHP_FRAME_STATUS      0x03      // console -> host, result code and SPI status of TR module
+#define BHP_FRAME_STATUS_REQ  0x04      // host -> console, request of STATUS frame
+#define BHP_FRAME_EXIT        0x05      // host -> console, return to text console
+
+// result codes of STATUS frame (besides IQRF_OPERATION_OK, IQRF_TR_MODULE_WRITE_ERR ...)
+#define BHP_RESULT_FRAME_ERR  0xF0      // wrong CRC, size or type of received frame
+
+#define BHP_MAX_PAYLOAD       64        // maximal size of SPI packet
+#define BHP_MAX_FRAME         (2 + BHP_MAX_PAYLOAD + 2)
+#define BHP_MAX_ENCODED       (BHP_MAX_FRAME + 2)     // COBS overhead byte and delimiter
+
+#if !defined(BHP_DEFAULT_BAUD)
+#define BHP_DEFAULT_BAUD      115200
+#endif
+#define BHP_CONSOLE_BAUD      9600      // baud rate of text console
+
+extern uint8_t BhpActive;
+
+/**
+ * Switch serial line to binary host protocol
+ * @param Baud baud rate of binary protocol
+ */
+void bhpStart(uint32_t Baud);
+
+/**
+ * Return to text console
+ */
+void bhpStop(void);
+
+/**
+ * Process received frames and pending TX packet (called from main loop)
+ */
+void bhpPoll(void);
+
+/**
+ * Send SPI packet received from TR module to the host
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ * @param Dropped number of packets received and dropped before this one
+ */
+void bhpSendRx(uint8_t *DataBuffer, uint8_t DataSize, uint8_t Dropped);
+
+/**
+ * Encode frame by COBS
+ * @param Source pointer to frame
+ * @param Size size of frame (up to 253 bytes)
+ * @param Destination pointer to buffer for encoded frame (Size + 1 bytes, delimiter is not included)
+ * @return size of encoded frame
+ */
+uint8_t bhpCobsEncode(const uint8_t *Source, uint8_t Size, uint8_t *Destination);
+
+/**
+ * Decode COBS encoded frame in place
+ * @param Data pointer to encoded frame without delimiter
+ * @param Size size of encoded frame
+ * @return size of decoded frame, 0 = format error
+ */
+uint8_t bhpCobsDecode(uint8_t *Data, uint8_t Size);
+
+/**
+ * Compute CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF)
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return CRC of data
+ */
+uint16_t bhpCrc16(const uint8_t *Data, uint8_t Size);
+
+#endif
@@ -25,15 +25,9 @@
 #include <SD.h>
 #include "ccp.h"
 #include "console.h"
+#include "out.h"
 #include "IQRF.h"
 
-/* data types */
-typedef struct {                        // command decode table item structure
-    char  Com[16];
-    void  (*Func)(uint16_t);
-    uint16_t  Param;
-} COM;
-
 /* function prototypes */
 void find_command(void);
 void memcpy_P (uint8_t *Destination, uint8_t *Source, uint16_t Count);
@@ -44,22 +38,37 @@ void ccpTestCmd (uint16_t CommandParameter);
 void ccpStatCmd (uint16_t CommandParameter);
 
 
-/* global variables */
-const COM Commands[] PROGMEM = {          // command decode table
-    "rst",ccpClsCmd,'H',
-    "ls",ccpLsCmd,0,
-
-    "send",ccpTrSendData,0,
-    "pgm",ccpPgmFile,0,
+/**
+ * Compare command names at compile time
+ * @return true = name A is before name B in strcmp order
+ */
+constexpr bool ccpNameBefore(const char *A, const char *B)
+{
+    return(*A != *B ? (uint8_t)*A < (uint8_t)*B : (*A != 0 && ccpNameBefore(A + 1, B + 1)));
+}
 
-    "trinfo",ccpTrModuleInfo,0,
-    "trrst",ccpTestCmd,0,
-    "trpgmmode",ccpTestCmd,1,
-    "trpwroff",ccpTestCmd,2,
-    "trpwron",ccpTestCmd,3,
+/**
+ * Check order of command table at compile time
+ * @return true = items are sorted by command name and names are unique
+ */
+constexpr bool ccpTableSorted(const COM *Table, size_t Count)
+{
+    return(Count < 2 || (ccpNameBefore(Table[0].Com, Table[1].Com) && ccpTableSorted(Table + 1, Count - 1)));
+}
 
-    "stat",ccpStatCmd,0,
+/* global variables */
+#define CCP_COMMAND_ITEM(Name, Func, Param)     {Name, Func, Param},
+constexpr COM Commands[] PROGMEM = {      // command decode table, sorted by command name (see ccptab.h)
+    CCP_CONSOLE_COMMANDS(CCP_COMMAND_ITEM)
 };
+// commands are found by binary search
+static_assert(ccpTableSorted(Commands, sizeof(Commands)/sizeof(COM)), "Commands[] must be sorted by command name");
+
+struct {                                  // registered extension command tables
+    const COM *Table;
+    uint8_t Count;
+} CcpExtTables[CCP_MAX_EXT_TABLES];
+uint8_t CcpExtTableCnt;
 
 #define HEADER_LINE_SIZE    75
 const char Header[][HEADER_LINE_SIZE] PROGMEM = {
@@ -86,6 +95,7 @@ const char SystemMsg[17][26] PROGMEM = {        // error messages
     "Received data:           ",   /* 13 */
     "File written successfully",   /* 14 */
     "Programming ERROR        ",   /* 15 */
+    "TR module busy           ",   /* 16 */
 };
 
 const char CmdPrompt[] = {"cmd> "};
@@ -96,9 +106,9 @@ COM CmdWorkCopy;
 void (*run_func)(uint16_t);                   // pointer to command service function
 uint16_t Parameter;                           // command service function parameter
 uint8_t ComEndPos;                            // end of command position in input buffer
-uint8_t CSel;
 
 char CcpCommandParameter[SIZE_OF_PARAM];
+uint8_t CcpLastError;                         // last system message reported failure of command
 char InLine[SIZE_OF_IN_BUFF] = {"rst\0"};     // input buffer
 uint8_t InLinePtr = SIZE_OF_IN_BUFF-1;        // input buffer pointer
 boolean RepeatInLine = true;
@@ -140,16 +150,16 @@ void ccp(void)
             InLine[InLinePtr] = 0;                                // set end of input string
 
             if (RepeatInLine)
-                Serial.println(InLine);                           // repeat previous command if new don't exist
+                Out.println(InLine);                           // repeat previous command if new don't exist
             else
-                Serial.print(CrLf);                               // print new line
+                Out.print(CrLf);                               // print new line
 
-            Serial.print(CrLf);
+            Out.print(CrLf);
             find_command();                                       // decode entered command
             run_func(Parameter);                                  // execute command service function
 
-            Serial.print(CrLf);                                   // new line
-            Serial.print(CmdPrompt);                              // print prompt
+            Out.print(CrLf);                                   // new line
+            Out.print(CmdPrompt);                              // print prompt
 
             RepeatInLine = true;                                  // repeat command if ENTER is pressed
         } else {
@@ -160,12 +170,12 @@ void ccp(void)
             if (ConsoleChar == 0x08) {                            // back space char has been received
                 if (InLinePtr) {                                  // if any chars are in input buffer
                   InLinePtr--;                                    // one char back in input buffer
-                  Serial.print(Back);                             // send string to clear last char on console
+                  Out.print(Back);                             // send string to clear last char on console
                 }
             } else {
                 if (InLinePtr < SIZE_OF_IN_BUFF) {                // input buffer is not full
                     InLine[InLinePtr++] = ConsoleChar;            // write received char to input buffer
-                    Serial.write(ConsoleChar);                    // loop back received char to console
+                    Out.write(ConsoleChar);                    // loop back received char to console
                 }
             }
         }
@@ -180,33 +190,45 @@ void ccp(void)
  */
 void find_command(void)
 {
-    uint8_t x,y;
-
-    for (CSel=0; CSel < (sizeof(Commands)/sizeof(COM)); CSel++) {    // compare input buffer with existing command patterns
-        memcpy_P(&CmdWorkCopy, &Commands[CSel], sizeof(CmdWorkCopy));
-        x=0;                                                        // initialize start position in input buffer
-        // find start of command
-        while (InLine[x] == ' ' && x < SIZE_OF_IN_BUFF) x++
-            ; /* void */
-        if (x == SIZE_OF_IN_BUFF)
-            goto err_find_out;                                      // if command not exist, decode end
-        for (y=0; y<sizeof(CmdWorkCopy.Com); y++) {                 // compare input command with command patterns
-            if (CmdWorkCopy.Com[y]==0 && (InLine[x]==' ' || InLine[x]==0)) { // if command exist
-                run_func = CmdWorkCopy.Func;                        // initialize pointer to function to run
-                Parameter = CmdWorkCopy.Param;                      // initialize function parameter
-                ComEndPos = x;                                      // set position in input buffer for command parameter reading
-                return;                                             // decode end
-            }
-            if (InLine[x] != CmdWorkCopy.Com[y])
-                break;                                              // compare with next command pattern
-            x++;                                                    // compare next char in command
-        }
+    const COM *Cmd;
+    uint8_t x, Size;
+
+    // find start and end of command
+    for (x=0; x < SIZE_OF_IN_BUFF-1 && InLine[x] == ' '; x++)
+        ; /* void */
+    for (Size=0; x+Size < SIZE_OF_IN_BUFF && InLine[x+Size] != ' ' && InLine[x+Size] != 0; Size++)
+        ; /* void */
+
+    // binary search in built-in commands, then in registered extension commands
+    Cmd = ccpTabFind(Commands, sizeof(Commands)/sizeof(COM), &InLine[x], Size);
+    for (uint8_t Ext=0; Cmd == NULL && Ext < CcpExtTableCnt; Ext++)
+        Cmd = ccpTabFind(CcpExtTables[Ext].Table, CcpExtTables[Ext].Count, &InLine[x], Size);
+
+    if (Cmd == NULL) {
+        run_func = sysMsgPrinter;                                   // in case of error, run error service function
+        Parameter = CCP_COMMAND_NOT_FOUND;
+        ComEndPos = 0;
+        return;
     }
+    memcpy_P(&CmdWorkCopy, Cmd, sizeof(CmdWorkCopy));               // only found item is copied from flash
+    run_func = CmdWorkCopy.Func;                                    // initialize pointer to function to run
+    Parameter = CmdWorkCopy.Param;                                  // initialize function parameter
+    ComEndPos = x + Size;                                           // set position in input buffer for command parameter reading
+}
 
-err_find_out:
-    run_func = sysMsgPrinter;                                       // in case of error, run error service function
-    Parameter = CCP_COMMAND_NOT_FOUND;
-    ComEndPos = 0;
+/**
+ * register table of extension commands
+ * @param Table pointer to command table in flash, items must be sorted by command name
+ * @param Count number of items in the table
+ * @return true = table registered, false = table is not sorted or too many tables
+ */
+uint8_t ccpAddCommands(const COM *Table, uint8_t Count)
+{
+    if (CcpExtTableCnt >= CCP_MAX_EXT_TABLES || !ccpTabSorted(Table, Count))
+        return(false);
+    CcpExtTables[CcpExtTableCnt].Table = Table;
+    CcpExtTables[CcpExtTableCnt++].Count = Count;
+    return(true);
 }
 
 /**
@@ -292,7 +314,23 @@ void sysMsgPrinter(uint16_t Msg)
     char Message[26];
 
     strcpy_P(Message, &SystemMsg[Msg][0]);
-    Serial.println(Message);
+    Out.println(Message);
+    if ((CCP_ERROR_MSGS >> Msg) & 1)
+        CcpLastError = true;
+}
+
+/**
+ * execute command line without console input (used by script runner)
+ * @param Line command line with parameters
+ * @return none
+ */
+void ccpExecute(const char *Line)
+{
+    strncpy(InLine, Line, SIZE_OF_IN_BUFF - 1);
+    InLine[SIZE_OF_IN_BUFF - 1] = 0;
+    CcpLastError = false;
+    find_command();                                           // decode command
+    run_func(Parameter);                                      // execute command service function
 }
 
 /**
@@ -305,16 +343,16 @@ void ccpClsCmd (uint16_t CommandParameter)
     uint8_t x,y;
     char HeaderChar;
 
-    Serial.print(CrLf);
-    Serial.print(CrLf);
+    Out.print(CrLf);
+    Out.print(CrLf);
 
     if (CommandParameter == 'H') {
         for (y=0; y<sizeof(Header)/HEADER_LINE_SIZE; y++) {
             for (x=0; x<HEADER_LINE_SIZE; x++) {
                 HeaderChar =  pgm_read_byte_near(&Header[y][x]);
-                Serial.write(HeaderChar);
+                Out.write(HeaderChar);
             }
-            Serial.print(CrLf);
+            Out.print(CrLf);
         }
     }
 }
@@ -339,12 +377,12 @@ void ccpLsCmd (uint16_t CommandParameter)
             File entry =  root.openNextFile();                // open next file in root directory
             if (! entry)
                 break;                                        // no more files exist -> end
-            Serial.print(entry.name());                       // print
+            Out.print(entry.name());                       // print
             if (entry.isDirectory()) {
-                Serial.println("/");
+                Out.println("/");
             } else {
-                Serial.print("\t\t");
-                Serial.println(entry.size(), DEC);
+                Out.print("\t\t");
+                Out.println(entry.size(), DEC);
             }
             entry.close();
         }
@@ -387,7 +425,7 @@ void ccpTestCmd (uint16_t CommandParameter)
  */
 void ccpStatCmd (uint16_t CommandParameter)
 {
-    Serial.println();
-    Serial.println(iqrfGetSpiStatus(), HEX);
-    Serial.println();
+    Out.println();
+    Out.println(iqrfGetSpiStatus(), HEX);
+    Out.println();
 }
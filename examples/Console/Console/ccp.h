@@ -23,9 +23,16 @@
 #ifndef _CCP_H
 #define _CCP_H
 
+#include "ccptab.h"
+
 #define SIZE_OF_IN_BUFF   48
 #define SIZE_OF_PARAM     43
 
+// maximal number of registered extension command tables
+#if !defined(CCP_MAX_EXT_TABLES)
+#define CCP_MAX_EXT_TABLES        2
+#endif
+
 #define CCP_COMMAND_NOT_FOUND     0
 #define CCP_CODE_FILE_OK          1
 #define CCP_SD_CARD_ERR           2
@@ -42,14 +49,24 @@
 #define CCP_RECEIVED_DATA         13
 #define CCP_FILE_WRITE_OK         14
 #define CCP_PROGRAMMING_ERR       15
+#define CCP_TR_BUSY               16
+
+// system messages reporting failure of command
+#define CCP_ERROR_MSGS            ((1UL << CCP_COMMAND_NOT_FOUND) | (1UL << CCP_SD_CARD_ERR) | (1UL << CCP_BAD_PARAMETER) \
+                                  | (1UL << CCP_FILE_NOT_FOUND) | (1UL << CCP_FILE_FORMAT_ERR) | (1UL << CCP_DIR_NOT_FOUND) \
+                                  | (1UL << CCP_DATA_SENT_ERR) | (1UL << CCP_TR_NOT_READY) | (1UL << CCP_PROGRAMMING_ERR) \
+                                  | (1UL << CCP_TR_BUSY))
 
 extern char CcpCommandParameter[SIZE_OF_PARAM];
 extern const char CrLf[];
 extern const char CmdPrompt[];
+extern uint8_t CcpLastError;                  // command reported error since ccpExecute()
 
 extern void ccp(void);
 extern uint8_t ccpFindCmdParameter(char *DestinationString);
 extern uint8_t ccpReadString(char *DestinationString);
+extern void ccpExecute(const char *Line);
+extern uint8_t ccpAddCommands(const COM *Table, uint8_t Count);
 extern void sysMsgPrinter(uint16_t Msg);
 
 #endif
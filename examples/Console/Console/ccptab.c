@@ -0,0 +1,72 @@
+/**
+ * @file Command tables of Arduino console command processor
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ccptab.h"
+
+/**
+ * Find command in command table (binary search)
+ * @param Table pointer to command table in flash, items must be sorted by command name (strcmp order)
+ * @param Count number of items in the table
+ * @param Word command name (without terminating zero)
+ * @param Size size of command name
+ * @return pointer to table item in flash, NULL = command not found
+ */
+const COM *ccpTabFind(const COM *Table, uint8_t Count, const char *Word, uint8_t Size)
+{
+    uint8_t Low = 0;
+    uint8_t High = Count;
+    uint8_t Mid;
+    int Cmp;
+
+    if (Size == 0 || Size >= CCP_COMMAND_SIZE)
+        return(NULL);
+
+    // names are compared directly in flash, no table item is copied to RAM
+    while (Low < High) {
+        Mid = (Low + High) / 2;
+        Cmp = strncmp_P(Word, Table[Mid].Com, Size);
+        // the same prefix, but command name in the table is longer
+        if (Cmp == 0 && pgm_read_byte(&Table[Mid].Com[Size]) != 0)
+            Cmp = -1;
+        if (Cmp == 0)
+            return(&Table[Mid]);
+        if (Cmp < 0)
+            High = Mid;
+        else
+            Low = Mid + 1;
+    }
+    return(NULL);
+}
+
+/**
+ * Check order of command table
+ * @param Table pointer to command table in flash
+ * @param Count number of items in the table
+ * @return true = items are sorted by command name and names are unique
+ */
+uint8_t ccpTabSorted(const COM *Table, uint8_t Count)
+{
+    char Name[CCP_COMMAND_SIZE];
+
+    for (uint8_t Cnt=1; Cnt<Count; Cnt++) {
+        strcpy_P(Name, Table[Cnt - 1].Com);
+        if (strcmp_P(Name, Table[Cnt].Com) >= 0)
+            return(false);
+    }
+    return(true);
+}
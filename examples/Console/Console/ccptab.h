@@ -0,0 +1,120 @@
+/**
+ * @file Command tables of Arduino console command processor
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CCPTAB_H
+#define _CCPTAB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+// host build (microbenchmark), tables are in RAM
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(Address)          (*(const uint8_t *)(Address))
+#define strncmp_P                       strncmp
+#define strcmp_P                        strcmp
+#define strcpy_P                        strcpy
+#endif
+
+#define CCP_COMMAND_SIZE  16              // maximal size of command name including terminating zero
+
+// optional features of the console (0 = left out), they do not fit RAM of ATmega328P (2 kB) and ATmega32U4 (2.5 kB) by default
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega32U4__)
+#define CONSOLE_FEATURE_DEFAULT   0
+#else
+#define CONSOLE_FEATURE_DEFAULT   1
+#endif
+#if !defined(CONSOLE_BENCH)
+#define CONSOLE_BENCH             CONSOLE_FEATURE_DEFAULT   // bench command (TX path throughput)
+#endif
+#if !defined(CONSOLE_BINARY)
+#define CONSOLE_BINARY            CONSOLE_FEATURE_DEFAULT   // bin command (binary host protocol)
+#endif
+#if !defined(CONSOLE_COMPRESSED)
+#define CONSOLE_COMPRESSED        CONSOLE_FEATURE_DEFAULT   // programming from compressed code files
+#endif
+
+#if CONSOLE_BENCH
+#define CCP_IF_BENCH(Item)        Item
+#else
+#define CCP_IF_BENCH(Item)
+#endif
+#if CONSOLE_BINARY
+#define CCP_IF_BINARY(Item)       Item
+#else
+#define CCP_IF_BINARY(Item)
+#endif
+
+typedef struct {                          // command decode table item structure
+    char  Com[CCP_COMMAND_SIZE];
+    void  (*Func)(uint16_t);
+    uint16_t  Param;
+} COM;
+
+// built-in commands of the console (name, service function, parameter), sorted by command name
+// the list is expanded by Item(Name, Func, Param) macro of the user (command table of ccp.cpp, host benchmark)
+// commands of optional features are wrapped by CCP_IF_xxx() macros
+#define CCP_CONSOLE_COMMANDS(Item)          \
+    CCP_IF_BENCH(Item("bench",  ccpBench,   0))     \
+    CCP_IF_BINARY(Item("bin",   ccpBinMode, 0))     \
+    Item("delta",       ccpPgmDelta,        0)      \
+    Item("ls",          ccpLsCmd,           0)      \
+    Item("pgm",         ccpPgmFile,         0)      \
+    Item("pgmfast",     ccpPgmFile,         1)      \
+    Item("rst",         ccpClsCmd,          'H')    \
+    Item("run",         ccpRun,             0)      \
+    Item("send",        ccpTrSendData,      0)      \
+    Item("stat",        ccpStatCmd,         0)      \
+    Item("tasks",       ccpTaskStats,       0)      \
+    Item("trinfo",      ccpTrModuleInfo,    0)      \
+    Item("trpgmmode",   ccpTestCmd,         1)      \
+    Item("trpwroff",    ccpTestCmd,         2)      \
+    Item("trpwron",     ccpTestCmd,         3)      \
+    Item("trrst",       ccpTestCmd,         0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Find command in command table (binary search)
+ * @param Table pointer to command table in flash, items must be sorted by command name (strcmp order)
+ * @param Count number of items in the table
+ * @param Word command name (without terminating zero)
+ * @param Size size of command name
+ * @return pointer to table item in flash, NULL = command not found
+ */
+const COM *ccpTabFind(const COM *Table, uint8_t Count, const char *Word, uint8_t Size);
+
+/**
+ * Check order of command table
+ * @param Table pointer to command table in flash
+ * @param Count number of items in the table
+ * @return true = items are sorted by command name and names are unique
+ */
+uint8_t ccpTabSorted(const COM *Table, uint8_t Count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,6 +25,12 @@ extern uint8_t   SDCardReady;
 
 void ccpTrModuleInfo(uint16_t CommandParameter);
 void ccpTrSendData(uint16_t CommandParameter);
+void ccpBench(uint16_t CommandParameter);
+void ccpRun(uint16_t CommandParameter);
+void ccpBinMode(uint16_t CommandParameter);
+void ccpTaskStats(uint16_t CommandParameter);
 void ccpPgmFile(uint16_t CommandParameter);
+void ccpPgmDelta(uint16_t CommandParameter);
+uint8_t trJobRunning(void);
 
 #endif
@@ -0,0 +1,166 @@
+/**
+ * @file Buffered console output of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "out.h"
+
+/* global variables */
+OutRing Out;
+const char OutHexChars[] = "0123456789ABCDEF";
+
+/**
+ * Write data, wait for free space in the ring if it is full (console messages are not lost)
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return number of written bytes
+ */
+size_t OutRing::write(const uint8_t *Data, size_t Size)
+{
+    uint16_t Part;
+    size_t Written = Size;
+
+    while (Size) {
+        drain();
+        if ((Part = OUT_RING_SIZE - Count) == 0)
+            continue;
+        if (Part > Size)
+            Part = Size;
+        put(Data, Part);
+        Data += Part;
+        Size -= Part;
+    }
+    return(Written);
+}
+
+/**
+ * Write one byte, wait for free space in the ring if it is full
+ * @param Byte byte to be written
+ * @return number of written bytes
+ */
+size_t OutRing::write(uint8_t Byte)
+{
+    return(write(&Byte, 1));
+}
+
+/**
+ * Post whole line (or frame) without waiting, it is dropped if there is no space in the ring
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return true = data stored, false = data dropped
+ */
+uint8_t OutRing::post(const char *Data, uint16_t Size)
+{
+    if (OUT_RING_SIZE - Count < Size)
+        drain();
+    if (OUT_RING_SIZE - Count < Size) {
+        Dropped += Size;
+        return(false);
+    }
+    put((const uint8_t *)Data, Size);
+    return(true);
+}
+
+/**
+ * Get free space of the ring, the ring is drained first
+ * @return number of bytes, which can be posted without dropping
+ */
+uint16_t OutRing::space(void)
+{
+    drain();
+    return(OUT_RING_SIZE - Count);
+}
+
+/**
+ * Move data from the ring to Serial, as much as Serial accepts without blocking
+ */
+void OutRing::drain(void)
+{
+    uint16_t Size;
+    int Free;
+
+    while (Count && (Free = Serial.availableForWrite()) > 0) {
+        // contiguous part of the ring
+        Size = (Tail + Count > OUT_RING_SIZE) ? OUT_RING_SIZE - Tail : Count;
+        if (Size > (uint16_t)Free)
+            Size = Free;
+        Serial.write(&Ring[Tail], Size);
+        Tail = (Tail + Size) % OUT_RING_SIZE;
+        Count -= Size;
+    }
+}
+
+/**
+ * Wait until all data of the ring are passed to Serial
+ */
+void OutRing::flush(void)
+{
+    while (Count)
+        drain();
+}
+
+/**
+ * Store data to the ring (there must be enough free space)
+ * @param Data pointer to data
+ * @param Size size of data
+ */
+void OutRing::put(const uint8_t *Data, uint16_t Size)
+{
+    uint16_t Part;
+
+    while (Size) {
+        Part = OUT_RING_SIZE - Head;
+        if (Part > Size)
+            Part = Size;
+        memcpy(&Ring[Head], Data, Part);
+        Head = (Head + Part) % OUT_RING_SIZE;
+        Count += Part;
+        Data += Part;
+        Size -= Part;
+    }
+    if (Count > HighWatermark)
+        HighWatermark = Count;
+}
+
+/**
+ * Encode bytes to hexadecimal ASCII chars
+ * @param Destination pointer to buffer for chars (3 chars per byte with separator, 2 chars without it)
+ * @param Source pointer to bytes
+ * @param Size number of bytes
+ * @param Separator char written after every byte (0 = no separator)
+ * @return number of written chars
+ */
+uint16_t outHexEncode(char *Destination, const uint8_t *Source, uint8_t Size, char Separator)
+{
+    char *Ptr = Destination;
+
+    while (Size--) {
+        *Ptr++ = OutHexChars[*Source >> 4];
+        *Ptr++ = OutHexChars[*Source++ & 0x0F];
+        if (Separator)
+            *Ptr++ = Separator;
+    }
+    return(Ptr - Destination);
+}
+
+/**
+ * Output task, drains the ring to Serial
+ */
+void outTask(void)
+{
+    Out.drain();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Buffered console output of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _OUT_H
+#define _OUT_H
+
+#include <Arduino.h>
+
+// size of output ring
+#if !defined(OUT_RING_SIZE)
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega32U4__)
+#define OUT_RING_SIZE         128
+#else
+#define OUT_RING_SIZE         512
+#endif
+#endif
+
+/**
+ * Output ring drained to Serial, all console output goes through it to keep order of messages
+ */
+class OutRing : public Print {
+public:
+    /**
+     * Write data, wait for free space in the ring if it is full (console messages are not lost)
+     * @param Data pointer to data
+     * @param Size size of data
+     * @return number of written bytes
+     */
+    size_t write(const uint8_t *Data, size_t Size);
+
+    /**
+     * Write one byte, wait for free space in the ring if it is full
+     * @param Byte byte to be written
+     * @return number of written bytes
+     */
+    size_t write(uint8_t Byte);
+    using Print::write;
+
+    /**
+     * Post whole line (or frame) without waiting, it is dropped if there is no space in the ring
+     * @param Data pointer to data
+     * @param Size size of data
+     * @return true = data stored, false = data dropped
+     */
+    uint8_t post(const char *Data, uint16_t Size);
+
+    /**
+     * Get free space of the ring, the ring is drained first
+     * @return number of bytes, which can be posted without dropping
+     */
+    uint16_t space(void);
+
+    /**
+     * Move data from the ring to Serial, as much as Serial accepts without blocking
+     */
+    void drain(void);
+
+    /**
+     * Wait until all data of the ring are passed to Serial
+     */
+    void flush(void);
+
+    uint32_t Dropped;                     // number of dropped bytes
+    uint16_t HighWatermark;               // maximal number of bytes in the ring
+
+private:
+    void put(const uint8_t *Data, uint16_t Size);
+
+    uint8_t Ring[OUT_RING_SIZE];
+    uint16_t Head;                        // position of next written byte
+    uint16_t Tail;                        // position of next byte sent to Serial
+    uint16_t Count;                       // number of bytes in the ring
+};
+
+extern OutRing Out;
+extern const char OutHexChars[];
+
+/**
+ * Encode bytes to hexadecimal ASCII chars
+ * @param Destination pointer to buffer for chars (3 chars per byte with separator, 2 chars without it)
+ * @param Source pointer to bytes
+ * @param Size number of bytes
+ * @param Separator char written after every byte (0 = no separator)
+ * @return number of written chars
+ */
+uint16_t outHexEncode(char *Destination, const uint8_t *Source, uint8_t Size, char Separator);
+
+/**
+ * Output task, drains the ring to Serial
+ */
+void outTask(void);
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file Script runner of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include <SD.h>
+#include "run.h"
+#include "ccp.h"
+#include "console.h"
+#include "out.h"
+#include "tasks.h"
+#include <IQRF.h>
+
+/* data types */
+typedef struct {                          // running loop of the script
+    uint32_t Position;                    // file position of first line of the loop
+    uint16_t Count;                       // number of remaining passes
+} RUN_LOOP;
+
+/* function prototypes */
+uint8_t runReadLine(char *Line);
+uint8_t runKeyword(const char *Line, const char *Keyword);
+void runError(const char *Line);
+
+/* global variables */
+uint8_t RunActive;                        // script is running
+uint8_t RunTaskId;
+File RunFile;
+RUN_LOOP RunLoops[RUN_MAX_LOOPS];
+uint8_t RunDepth;                         // number of running loops
+uint8_t RunStepPending;                   // command of the step is running
+uint8_t RunLastError;                     // previous command failed
+uint16_t RunSteps;                        // number of executed commands
+uint32_t RunStartTime;
+uint32_t RunStepTime;                     // start time of running command
+uint32_t RunWakeTime;                     // end of delay
+
+/**
+ * Register script runner task
+ */
+void runInit(void)
+{
+    RunTaskId = taskAdd("run", runTask, false);
+}
+
+/**
+ * Start script
+ * @param Filename name of script file on SD card
+ * @return true = script started, false = file not found
+ */
+uint8_t runStart(const char *Filename)
+{
+    iqrfSuspendDriver();
+    RunFile = SD.open(Filename);
+    iqrfRunDriver();
+    if (!RunFile)
+        return(false);
+
+    RunDepth = 0;
+    RunStepPending = false;
+    RunLastError = false;
+    RunSteps = 0;
+    RunStartTime = iqrfGetSysTick();
+    RunWakeTime = RunStartTime;
+    RunActive = true;
+    taskEnable(RunTaskId, true);
+    return(true);
+}
+
+/**
+ * Stop running script
+ */
+void runStop(void)
+{
+    iqrfSuspendDriver();
+    RunFile.close();
+    iqrfRunDriver();
+    RunActive = false;
+    taskEnable(RunTaskId, false);
+
+    Out.print(RunSteps);
+    Out.print(" steps in ");
+    Out.print(iqrfGetSysTick() - RunStartTime);
+    Out.println(" ms");
+    Out.print(CrLf);
+    Out.print(CmdPrompt);
+}
+
+/**
+ * Script runner task, runs next line of the script when previous command is finished
+ */
+void runTask(void)
+{
+    char Line[SIZE_OF_IN_BUFF];
+    char *Cmd = Line;
+    uint8_t Size;
+    uint32_t Count;
+
+    // command is finished, when its job (send, bench, pgm ...) ends
+    if (RunStepPending) {
+        if (trJobRunning())
+            return;
+        RunStepPending = false;
+        RunLastError = CcpLastError;
+        Out.print("step ");
+        Out.print(RunSteps);
+        Out.print(": ");
+        Out.print(iqrfGetSysTick() - RunStepTime);
+        Out.println(RunLastError ? " ms, ERROR" : " ms");
+    }
+    if ((int32_t)(iqrfGetSysTick() - RunWakeTime) < 0)
+        return;
+
+    // one line of the script in every pass of run-loop
+    if (!runReadLine(Line)) {
+        runStop();
+        return;
+    }
+
+    while (*Cmd == ' ')
+        Cmd++;
+    // conditions on result of previous command
+    if ((Size = runKeyword(Cmd, "ifok")) != 0) {
+        if (RunLastError)
+            return;
+        Cmd += Size;
+    } else if ((Size = runKeyword(Cmd, "iferr")) != 0) {
+        if (!RunLastError)
+            return;
+        Cmd += Size;
+    }
+    while (*Cmd == ' ')
+        Cmd++;
+    if (*Cmd == 0 || *Cmd == '#')
+        return;
+
+    if ((Size = runKeyword(Cmd, "loop")) != 0) {
+        Count = strtoul(&Cmd[Size], NULL, 10);
+        if (Count == 0 || Count > 0xFFFF || RunDepth == RUN_MAX_LOOPS) {
+            runError(Cmd);
+            return;
+        }
+        RunLoops[RunDepth].Position = RunFile.position();
+        RunLoops[RunDepth++].Count = Count;
+    } else if (runKeyword(Cmd, "end")) {
+        if (RunDepth == 0) {
+            runError(Cmd);
+            return;
+        }
+        if (--RunLoops[RunDepth - 1].Count) {
+            iqrfSuspendDriver();
+            RunFile.seek(RunLoops[RunDepth - 1].Position);
+            iqrfRunDriver();
+        } else {
+            RunDepth--;
+        }
+    } else if ((Size = runKeyword(Cmd, "delay")) != 0) {
+        RunWakeTime = iqrfGetSysTick() + strtoul(&Cmd[Size], NULL, 10) * TICKS_IN_SECOND / 1000;
+    } else if (runKeyword(Cmd, "stop")) {
+        runStop();
+    } else {
+        // console command, the script continues when its job ends
+        Out.print("run> ");
+        Out.println(Cmd);
+        RunSteps++;
+        RunStepTime = iqrfGetSysTick();
+        RunStepPending = true;
+        ccpExecute(Cmd);
+    }
+}
+
+/**
+ * Read next line of the script
+ * @param Line buffer for the line (SIZE_OF_IN_BUFF chars), longer lines are truncated
+ * @return true = line read, false = end of file
+ */
+uint8_t runReadLine(char *Line)
+{
+    uint8_t Ptr = 0;
+    int Char;
+
+    iqrfSuspendDriver();
+    while ((Char = RunFile.read()) >= 0 && Char != '\n') {
+        if (Char != '\r' && Ptr < SIZE_OF_IN_BUFF - 1)
+            Line[Ptr++] = Char;
+    }
+    iqrfRunDriver();
+    Line[Ptr] = 0;
+    return(Char >= 0 || Ptr);
+}
+
+/**
+ * Check keyword at start of the line
+ * @param Line script line
+ * @param Keyword keyword
+ * @return size of keyword (0 = line does not start with the keyword)
+ */
+uint8_t runKeyword(const char *Line, const char *Keyword)
+{
+    uint8_t Size = strlen(Keyword);
+
+    if (strncmp(Line, Keyword, Size) != 0 || (Line[Size] != ' ' && Line[Size] != 0))
+        return(0);
+    return(Size);
+}
+
+/**
+ * Stop script with wrong line
+ * @param Line wrong line
+ */
+void runError(const char *Line)
+{
+    Out.print(Line);
+    Out.print(": ");
+    sysMsgPrinter(CCP_BAD_PARAMETER);
+    runStop();
+}
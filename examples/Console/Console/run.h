@@ -0,0 +1,66 @@
+/**
+ * @file Script runner of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _RUN_H
+#define _RUN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// maximal depth of nested loops
+#if !defined(RUN_MAX_LOOPS)
+#define RUN_MAX_LOOPS         4
+#endif
+
+/*
+ * Script is a text file with one console command per line, other lines are:
+ *   # comment
+ *   loop count     - repeat lines up to matching "end" count times
+ *   end            - end of loop
+ *   delay ms       - wait
+ *   ifok command   - run command only if previous command succeeded
+ *   iferr command  - run command only if previous command failed
+ *   stop           - end script
+ */
+
+extern uint8_t RunActive;
+
+/**
+ * Register script runner task
+ */
+void runInit(void);
+
+/**
+ * Start script
+ * @param Filename name of script file on SD card
+ * @return true = script started, false = file not found
+ */
+uint8_t runStart(const char *Filename);
+
+/**
+ * Stop running script
+ */
+void runStop(void);
+
+/**
+ * Script runner task, runs next line of the script when previous command is finished
+ */
+void runTask(void);
+
+#endif
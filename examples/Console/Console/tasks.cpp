@@ -0,0 +1,104 @@
+/**
+ * @file Cooperative task scheduler of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "tasks.h"
+#include "out.h"
+
+/* global variables */
+T_TASK Tasks[TASK_MAX_TASKS];             // task table, tasks run in order of registration
+uint8_t TaskCnt;
+
+/**
+ * Register task
+ * @param Name name of the task
+ * @param Func task function
+ * @param Enabled true = task runs from now
+ * @return identifier of the task, TASK_NONE = task table is full
+ */
+uint8_t taskAdd(const char *Name, T_TASK_FUNC Func, uint8_t Enabled)
+{
+    if (TaskCnt >= TASK_MAX_TASKS)
+        return(TASK_NONE);
+    memset(&Tasks[TaskCnt], 0, sizeof(T_TASK));
+    Tasks[TaskCnt].Name = Name;
+    Tasks[TaskCnt].Func = Func;
+    Tasks[TaskCnt].Enabled = Enabled;
+    return(TaskCnt++);
+}
+
+/**
+ * Enable or disable task
+ * @param Id identifier of the task
+ * @param Enabled true = task runs in every pass of run-loop
+ */
+void taskEnable(uint8_t Id, uint8_t Enabled)
+{
+    if (Id < TaskCnt)
+        Tasks[Id].Enabled = Enabled;
+}
+
+/**
+ * Run every enabled task once (called from main loop)
+ */
+void taskRun(void)
+{
+    uint32_t StartTime;
+    uint32_t RunTime;
+
+    for (uint8_t Id=0; Id<TaskCnt; Id++) {
+        if (!Tasks[Id].Enabled)
+            continue;
+        StartTime = micros();
+        Tasks[Id].Func();
+        RunTime = micros() - StartTime;
+        Tasks[Id].Runs++;
+        Tasks[Id].RunTime += RunTime;
+        if (RunTime > Tasks[Id].MaxRunTime)
+            Tasks[Id].MaxRunTime = RunTime;
+    }
+}
+
+/**
+ * Print run time statistics of all tasks
+ */
+void taskPrintStats(void)
+{
+    for (uint8_t Id=0; Id<TaskCnt; Id++) {
+        Out.print(Tasks[Id].Name);
+        Out.print(Tasks[Id].Enabled ? " (running): " : ": ");
+        Out.print(Tasks[Id].Runs);
+        Out.print(" runs, ");
+        Out.print(Tasks[Id].RunTime / 1000);
+        Out.print(" ms, max ");
+        Out.print(Tasks[Id].MaxRunTime);
+        Out.println(" us");
+    }
+}
+
+/**
+ * Clear run time statistics of all tasks
+ */
+void taskClearStats(void)
+{
+    for (uint8_t Id=0; Id<TaskCnt; Id++) {
+        Tasks[Id].Runs = 0;
+        Tasks[Id].RunTime = 0;
+        Tasks[Id].MaxRunTime = 0;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file Cooperative task scheduler of Arduino console
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TASKS_H
+#define _TASKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if !defined(TASK_MAX_TASKS)
+#define TASK_MAX_TASKS        8
+#endif
+#define TASK_NONE             0xFF
+
+/**
+ * Task function, it must do a short step of its work and return
+ */
+typedef void (*T_TASK_FUNC)(void);
+
+typedef struct {                          // registered task
+    const char *Name;
+    T_TASK_FUNC Func;
+    uint8_t Enabled;
+    uint32_t Runs;                        // number of runs
+    uint32_t RunTime;                     // total run time in us
+    uint32_t MaxRunTime;                  // longest run in us
+} T_TASK;
+
+extern T_TASK Tasks[TASK_MAX_TASKS];
+extern uint8_t TaskCnt;
+
+/**
+ * Register task
+ * @param Name name of the task
+ * @param Func task function
+ * @param Enabled true = task runs from now
+ * @return identifier of the task, TASK_NONE = task table is full
+ */
+uint8_t taskAdd(const char *Name, T_TASK_FUNC Func, uint8_t Enabled);
+
+/**
+ * Enable or disable task
+ * @param Id identifier of the task
+ * @param Enabled true = task runs in every pass of run-loop
+ */
+void taskEnable(uint8_t Id, uint8_t Enabled);
+
+/**
+ * Run every enabled task once (called from main loop)
+ */
+void taskRun(void);
+
+/**
+ * Print run time statistics of all tasks
+ */
+void taskPrintStats(void);
+
+/**
+ * Clear run time statistics of all tasks
+ */
+void taskClearStats(void);
+
+#endif
@@ -0,0 +1,402 @@
+/**
+ * @file Emulated TR module for IQRF SPI support library host platform port
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFEmu.h"
+
+typedef struct {
+    uint8_t Powered;
+    uint8_t PgmMode;
+    uint64_t EchoTime;                    // start of MOSI to MISO echo after reset (us, 0 = no echo)
+    uint64_t BusyTime;                    // TR module is writing received packet until this time (us)
+    uint64_t DropoutTime;                 // SPI does not work until this time (us)
+    uint16_t EntryTime;                   // time of MOSI to MISO echo needed for actual programming mode entry (ms)
+    uint8_t Corrupted;                    // actual packet is corrupted on MOSI
+    uint8_t PacketCnt;                    // position in actual SPI packet (0 = waiting for command)
+    uint8_t Cmd;
+    uint8_t Ptype;
+    uint8_t Dlen;
+    uint8_t CrcM;                         // CRC of received packet
+    uint8_t CrcS;                         // CRC of transmitted data
+    uint8_t CrcOk;
+    uint8_t RxData[64];                   // data received from master
+    uint8_t TxData[64];                   // data transmitted to master
+    uint8_t ComLength;                    // size of data ready in COM buffer for master
+    uint8_t ComData[64];
+} T_IQRF_EMU_STATE;
+
+/* Function prototypes */
+void iqrfEmuPower(bool On);
+uint8_t iqrfEmuTransfer(uint8_t TxByte);
+void iqrfEmuEnterPgmMode(void);
+uint8_t iqrfEmuStatus(void);
+void iqrfEmuPrepareTxData(void);
+void iqrfEmuProcessPacket(void);
+void iqrfEmuWritePgmPacket(void);
+bool iqrfEmuFault(uint16_t Rate);
+
+/* Public variable declarations */
+const T_IQRF_HOST_SLAVE IqrfEmuSlave = {
+    iqrfEmuPower,
+    iqrfEmuTransfer,
+    iqrfEmuEnterPgmMode
+};
+T_IQRF_EMU_STATS IqrfEmuStats;
+T_IQRF_EMU_MEMORY IqrfEmuMemory;
+T_IQRF_EMU_CONFIG IqrfEmuConfig;
+T_IQRF_EMU_STATE IqrfEmu;
+T_IQRF_EMU_FAULTS IqrfEmuFaults;
+uint32_t IqrfEmuRandom;                   // state of pseudo-random generator of faults
+
+// TR-72D with PIC16LF1938, OS 4.03
+const T_IQRF_EMU_CONFIG IqrfEmuDefaultConfig = {
+    0x8100A72DUL,
+    0x43,
+    (TR_72D << 4) | PIC16LF1938,
+    0x08D7,
+    3000,
+    4000,
+    100
+};
+
+/**
+ * Initialize emulated TR module (erase memory, clear statistics)
+ * @param Config Pointer to configuration of TR module (NULL = default TR-72D module)
+ */
+void iqrfEmuInit(const T_IQRF_EMU_CONFIG *Config)
+{
+    uint16_t Cnt;
+
+    IqrfEmuConfig = Config ? *Config : IqrfEmuDefaultConfig;
+    memset(&IqrfEmu, 0, sizeof(IqrfEmu));
+    memset(&IqrfEmuStats, 0, sizeof(IqrfEmuStats));
+    iqrfEmuSetFaults(NULL);
+    // erased flash contains 0x3FFF, erased EEPROMs 0xFF
+    for (Cnt=0; Cnt<IQRF_EMU_FLASH_SIZE; Cnt++)
+        IqrfEmuMemory.Flash[Cnt] = 0x3FFF;
+    memset(IqrfEmuMemory.SerialEeprom, 0xFF, sizeof(IqrfEmuMemory.SerialEeprom));
+    memset(IqrfEmuMemory.Eeprom, 0xFF, sizeof(IqrfEmuMemory.Eeprom));
+    memset(IqrfEmuMemory.Password, 0, sizeof(IqrfEmuMemory.Password));
+    memset(IqrfEmuMemory.Key, 0, sizeof(IqrfEmuMemory.Key));
+    IqrfEmuMemory.PluginHash = 0x811C9DC5UL;
+}
+
+/**
+ * Set faults injected by emulated TR module
+ * @param Faults Pointer to fault profile (NULL = no faults)
+ */
+void iqrfEmuSetFaults(const T_IQRF_EMU_FAULTS *Faults)
+{
+    if (Faults)
+        IqrfEmuFaults = *Faults;
+    else
+        memset(&IqrfEmuFaults, 0, sizeof(IqrfEmuFaults));
+    // xorshift generator must not start from 0
+    IqrfEmuRandom = IqrfEmuFaults.Seed ? IqrfEmuFaults.Seed : 0x2545F491UL;
+}
+
+/**
+ * Decide, if fault is injected
+ * @param Rate Rate of the fault in per mille
+ * @return true = inject the fault
+ */
+bool iqrfEmuFault(uint16_t Rate)
+{
+    if (Rate == 0)
+        return(false);
+    IqrfEmuRandom ^= IqrfEmuRandom << 13;
+    IqrfEmuRandom ^= IqrfEmuRandom >> 17;
+    IqrfEmuRandom ^= IqrfEmuRandom << 5;
+    return(IqrfEmuRandom % 1000 < Rate);
+}
+
+/**
+ * Put data for master to COM buffer of emulated TR module (packet received from IQRF network)
+ * @param Data Pointer to data
+ * @param Size Size of data (1 - 64 bytes)
+ * @return true = data are ready for master, false = TR module is off, in programming mode or COM buffer is full
+ */
+bool iqrfEmuPutComData(const uint8_t *Data, uint8_t Size)
+{
+    if (!IqrfEmu.Powered || IqrfEmu.PgmMode || IqrfEmu.ComLength || Size == 0 || Size > sizeof(IqrfEmu.ComData))
+        return(false);
+    memcpy(IqrfEmu.ComData, Data, Size);
+    IqrfEmu.ComLength = Size;
+    return(true);
+}
+
+/**
+ * Control power supply of emulated TR module
+ * @param On true = power on, false = power off
+ */
+void iqrfEmuPower(bool On)
+{
+    if (On && !IqrfEmu.Powered)
+        IqrfEmuStats.Resets++;
+    // TR module starts in communication mode with empty buffers
+    IqrfEmu.Powered = On;
+    IqrfEmu.PgmMode = false;
+    IqrfEmu.EchoTime = 0;
+    IqrfEmu.BusyTime = 0;
+    IqrfEmu.DropoutTime = 0;
+    IqrfEmu.PacketCnt = 0;
+    IqrfEmu.ComLength = 0;
+}
+
+/**
+ * MOSI to MISO echo after reset, emulated TR module enters programming mode after PgmModeEntryTime of the echo
+ */
+void iqrfEmuEnterPgmMode(void)
+{
+    if (!IqrfEmu.Powered || IqrfEmu.PgmMode)
+        return;
+    if (!IqrfEmu.EchoTime) {
+        IqrfEmu.EchoTime = iqrfHostTimeUs();
+        IqrfEmu.EntryTime = IqrfEmuConfig.PgmModeEntryTime;
+        if (iqrfEmuFault(IqrfEmuFaults.SlowEntryRate)) {
+            IqrfEmu.EntryTime += IqrfEmuFaults.SlowEntryTime;
+            IqrfEmuStats.SlowEntries++;
+        }
+    }
+    if (iqrfHostTimeUs() - IqrfEmu.EchoTime >= (uint64_t)IqrfEmu.EntryTime * 1000) {
+        IqrfEmu.PgmMode = true;
+        IqrfEmuStats.PgmModeEntries++;
+    }
+}
+
+/**
+ * Get SPI status of emulated TR module
+ * @return SPI status
+ */
+uint8_t iqrfEmuStatus(void)
+{
+    if (!IqrfEmu.Powered)
+        return(SPI_DISABLED);
+    // received packet is being written
+    if (IqrfEmu.BusyTime) {
+        if (iqrfHostTimeUs() < IqrfEmu.BusyTime)
+            return(SPI_CRCM_OK);
+        IqrfEmu.BusyTime = 0;
+    }
+    // data ready in COM buffer (0x40 = 64 bytes)
+    if (IqrfEmu.ComLength)
+        return(0x40 | (IqrfEmu.ComLength & 0x3F));
+    return(IqrfEmu.PgmMode ? PROGRAMMING_MODE : COMMUNICATION_MODE);
+}
+
+/**
+ * Transfer one byte over SPI between master and emulated TR module
+ * @param TxByte byte sent by master (MOSI)
+ * @return byte sent by TR module (MISO)
+ */
+uint8_t iqrfEmuTransfer(uint8_t TxByte)
+{
+    uint8_t Position;
+    uint8_t RxByte;
+
+    IqrfEmuStats.SpiBytes++;
+    if (!IqrfEmu.Powered)
+        return(SPI_DISABLED);
+
+    // SPI does not work, packet in progress is lost
+    if (IqrfEmu.DropoutTime) {
+        if (iqrfHostTimeUs() < IqrfEmu.DropoutTime) {
+            IqrfEmu.PacketCnt = 0;
+            return(NO_MODULE);
+        }
+        IqrfEmu.DropoutTime = 0;
+    }
+
+    // SPI status check or command of new packet
+    if (IqrfEmu.PacketCnt == 0) {
+        if (TxByte == SPI_CHECK && iqrfEmuFault(IqrfEmuFaults.DropoutRate)) {
+            IqrfEmu.DropoutTime = iqrfHostTimeUs() + (uint64_t)IqrfEmuFaults.DropoutTime * 1000;
+            IqrfEmuStats.Dropouts++;
+            return(NO_MODULE);
+        }
+        RxByte = iqrfEmuStatus();
+        if (TxByte != SPI_CHECK) {
+            IqrfEmu.Cmd = TxByte;
+            IqrfEmu.CrcM = 0x5F ^ TxByte;
+            IqrfEmu.Corrupted = iqrfEmuFault(IqrfEmuFaults.CrcErrorRate);
+            IqrfEmu.PacketCnt = 1;
+        }
+        return(RxByte);
+    }
+
+    Position = IqrfEmu.PacketCnt++;
+    // packet type, size of data and direction
+    if (Position == 1) {
+        IqrfEmu.Ptype = TxByte;
+        IqrfEmu.Dlen = TxByte & 0x7F;
+        if (IqrfEmu.Dlen == 0 || IqrfEmu.Dlen > 64)
+            IqrfEmu.Dlen = 64;
+        IqrfEmu.CrcM ^= TxByte;
+        IqrfEmu.CrcS = 0x5F ^ TxByte;
+        iqrfEmuPrepareTxData();
+        return(0);
+    }
+    // packet data
+    if (Position < IqrfEmu.Dlen + 2) {
+        IqrfEmu.RxData[Position - 2] = TxByte;
+        IqrfEmu.CrcM ^= TxByte;
+        RxByte = IqrfEmu.TxData[Position - 2];
+        IqrfEmu.CrcS ^= RxByte;
+        return(RxByte);
+    }
+    // CRC of master packet, TR module sends CRC of its data
+    if (Position == IqrfEmu.Dlen + 2) {
+        IqrfEmu.CrcOk = (TxByte == IqrfEmu.CrcM);
+        if (IqrfEmu.Corrupted) {
+            IqrfEmu.CrcOk = false;
+            IqrfEmuStats.CrcFaults++;
+        }
+        return(IqrfEmu.CrcS);
+    }
+    // last byte of packet, TR module sends result of CRC check
+    IqrfEmu.PacketCnt = 0;
+    if (!IqrfEmu.CrcOk) {
+        IqrfEmuStats.CrcErrors++;
+        return(SPI_CRCM_ERR);
+    }
+    iqrfEmuProcessPacket();
+    // written packet is followed by longer time of full buffer
+    if (IqrfEmu.BusyTime && iqrfEmuFault(IqrfEmuFaults.BusyBurstRate)) {
+        IqrfEmu.BusyTime += (uint64_t)IqrfEmuFaults.BusyBurstTime * 1000;
+        IqrfEmuStats.BusyBursts++;
+    }
+    return(SPI_CRCM_OK);
+}
+
+/**
+ * Prepare data sent by emulated TR module during actual packet
+ */
+void iqrfEmuPrepareTxData(void)
+{
+    memset(IqrfEmu.TxData, 0, sizeof(IqrfEmu.TxData));
+    // master writes data
+    if (IqrfEmu.Ptype & 0x80)
+        return;
+    if (IqrfEmu.Cmd == SPI_MODULE_INFO) {
+        // extended module info, IBK is in second half
+        IqrfEmu.TxData[0] = IqrfEmuConfig.ModuleId >> 24;
+        IqrfEmu.TxData[1] = IqrfEmuConfig.ModuleId >> 16;
+        IqrfEmu.TxData[2] = IqrfEmuConfig.ModuleId >> 8;
+        IqrfEmu.TxData[3] = IqrfEmuConfig.ModuleId;
+        for (uint8_t Cnt=0; Cnt<16; Cnt++)
+            IqrfEmu.TxData[16 + Cnt] = IqrfEmu.TxData[Cnt % 4] ^ (0xA5 + Cnt);
+    } else {
+        // master reads COM buffer
+        memcpy(IqrfEmu.TxData, IqrfEmu.ComData, IqrfEmu.ComLength);
+    }
+}
+
+/**
+ * Process packet received by emulated TR module
+ */
+void iqrfEmuProcessPacket(void)
+{
+    // master has read COM buffer
+    if (!(IqrfEmu.Ptype & 0x80)) {
+        if (IqrfEmu.Cmd == SPI_WR_RD)
+            IqrfEmu.ComLength = 0;
+        return;
+    }
+
+    switch (IqrfEmu.Cmd) {
+    case SPI_MODULE_INFO:
+        // basic module info is returned in COM buffer
+        IqrfEmu.ComData[0] = IqrfEmuConfig.ModuleId >> 24;
+        IqrfEmu.ComData[1] = IqrfEmuConfig.ModuleId >> 16;
+        IqrfEmu.ComData[2] = IqrfEmuConfig.ModuleId >> 8;
+        IqrfEmu.ComData[3] = IqrfEmuConfig.ModuleId;
+        IqrfEmu.ComData[4] = IqrfEmuConfig.OsVersion;
+        IqrfEmu.ComData[5] = IqrfEmuConfig.ModuleInfo;
+        IqrfEmu.ComData[6] = IqrfEmuConfig.OsBuild & 0x00FF;
+        IqrfEmu.ComData[7] = IqrfEmuConfig.OsBuild >> 8;
+        IqrfEmu.ComLength = 8;
+        break;
+
+    case SPI_FLASH_PGM:
+    case SPI_EEPROM_PGM:
+    case SPI_PLUGIN_PGM:
+        if (IqrfEmu.PgmMode)
+            iqrfEmuWritePgmPacket();
+        break;
+
+    default:
+        // data for application in communication mode are accepted and dropped
+        IqrfEmu.BusyTime = iqrfHostTimeUs() + IqrfEmuConfig.EepromWriteTime;
+        break;
+    }
+}
+
+/**
+ * Write programming packet to memory of emulated TR module
+ */
+void iqrfEmuWritePgmPacket(void)
+{
+    uint8_t *Data = IqrfEmu.RxData;
+    uint16_t Address;
+    uint8_t Cnt;
+
+    switch (IqrfEmu.Cmd) {
+    case SPI_FLASH_PGM:
+        if (IqrfEmu.Dlen != 32 + 2)
+            return;
+        Address = ((uint16_t)Data[1] << 8) | Data[0];
+        if (Address < IQRF_EMU_SERIAL_EEPROM_SIZE / 32) {
+            // serial EEPROM block (block index instead of address)
+            memcpy(&IqrfEmuMemory.SerialEeprom[Address * 32], &Data[2], 32);
+        } else {
+            // 16 words of flash memory
+            for (Cnt=0; Cnt<16; Cnt++)
+                IqrfEmuMemory.Flash[(Address + Cnt) % IQRF_EMU_FLASH_SIZE] = ((uint16_t)Data[2*Cnt+3] << 8) | Data[2*Cnt+2];
+        }
+        IqrfEmuStats.FlashPackets++;
+        IqrfEmu.BusyTime = iqrfHostTimeUs() + IqrfEmuConfig.FlashWriteTime;
+        break;
+
+    case SPI_EEPROM_PGM:
+        if (Data[1] > 32 || Data[1] + 2 > IqrfEmu.Dlen)
+            return;
+        if (Data[0] == ACCESS_PASSWORD_CFG_ADR)
+            memcpy(IqrfEmuMemory.Password, &Data[2], 16);
+        else if (Data[0] == USER_KEY_CFG_ADR)
+            memcpy(IqrfEmuMemory.Key, &Data[2], 16);
+        else
+            for (Cnt=0; Cnt<Data[1]; Cnt++)
+                IqrfEmuMemory.Eeprom[(uint8_t)(Data[0] + Cnt)] = Data[Cnt + 2];
+        IqrfEmuStats.EepromPackets++;
+        IqrfEmu.BusyTime = iqrfHostTimeUs() + IqrfEmuConfig.EepromWriteTime;
+        break;
+
+    case SPI_PLUGIN_PGM:
+        if (IqrfEmu.Dlen != 20)
+            return;
+        for (Cnt=0; Cnt<20; Cnt++) {
+            IqrfEmuMemory.PluginHash ^= Data[Cnt];
+            IqrfEmuMemory.PluginHash *= 16777619UL;
+        }
+        IqrfEmuStats.PluginPackets++;
+        IqrfEmu.BusyTime = iqrfHostTimeUs() + IqrfEmuConfig.FlashWriteTime;
+        break;
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file Emulated TR module for IQRF SPI support library host platform port
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _IQRF_EMU_H
+#define _IQRF_EMU_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "IQRFHost.h"
+
+#define IQRF_EMU_FLASH_SIZE           0x4000    // size of program flash in words
+#define IQRF_EMU_SERIAL_EEPROM_SIZE   0x0800    // size of serial EEPROM in bytes
+#define IQRF_EMU_EEPROM_SIZE          0x0100    // size of internal EEPROM in bytes
+
+typedef struct {                          // configuration of emulated TR module
+    uint32_t ModuleId;
+    uint8_t OsVersion;                    // OS version (0x43 = 4.03)
+    uint8_t ModuleInfo;                   // MCU type, FCC flag and TR module type (byte 5 of module info)
+    uint16_t OsBuild;
+    uint16_t FlashWriteTime;              // time of flash or plugin packet write in us
+    uint16_t EepromWriteTime;             // time of EEPROM packet write in us
+    uint16_t PgmModeEntryTime;            // time of MOSI to MISO echo needed to enter programming mode in ms
+} T_IQRF_EMU_CONFIG;
+
+typedef struct {                          // faults injected by emulated TR module, rates are in per mille
+    uint32_t Seed;                        // seed of pseudo-random faults (the same seed = the same faults)
+    uint16_t CrcErrorRate;                // packets corrupted on MOSI, TR module rejects them by SPI_CRCM_ERR
+    uint16_t BusyBurstRate;               // accepted packets followed by burst of full buffer
+    uint16_t BusyBurstTime;               // length of full buffer burst in ms
+    uint16_t DropoutRate;                 // SPI status checks starting dropout of SPI (TR module answers NO_MODULE)
+    uint16_t DropoutTime;                 // length of dropout in ms
+    uint16_t SlowEntryRate;               // programming mode entries, which take SlowEntryTime longer
+    uint16_t SlowEntryTime;               // additional time of MOSI to MISO echo in ms
+} T_IQRF_EMU_FAULTS;
+
+typedef struct {                          // statistics of emulated TR module
+    uint32_t SpiBytes;                    // number of bytes transferred over SPI
+    uint16_t FlashPackets;                // number of written flash packets (including serial EEPROM)
+    uint16_t EepromPackets;               // number of written EEPROM packets
+    uint16_t PluginPackets;               // number of written plugin packets
+    uint16_t CrcErrors;                   // number of packets rejected due to CRCM error
+    uint16_t Resets;                      // number of power-on resets
+    uint16_t PgmModeEntries;              // number of programming mode entries
+    uint16_t CrcFaults;                   // number of injected CRC errors
+    uint16_t BusyBursts;                  // number of injected full buffer bursts
+    uint16_t Dropouts;                    // number of injected SPI dropouts
+    uint16_t SlowEntries;                 // number of injected slow programming mode entries
+} T_IQRF_EMU_STATS;
+
+typedef struct {                          // memory of emulated TR module
+    uint16_t Flash[IQRF_EMU_FLASH_SIZE];
+    uint8_t SerialEeprom[IQRF_EMU_SERIAL_EEPROM_SIZE];
+    uint8_t Eeprom[IQRF_EMU_EEPROM_SIZE];
+    uint8_t Password[16];
+    uint8_t Key[16];
+    uint32_t PluginHash;                  // FNV-1a hash of all written plugin packets
+} T_IQRF_EMU_MEMORY;
+
+extern const T_IQRF_HOST_SLAVE IqrfEmuSlave;
+extern T_IQRF_EMU_STATS IqrfEmuStats;
+extern T_IQRF_EMU_MEMORY IqrfEmuMemory;
+
+/**
+ * Initialize emulated TR module (erase memory, clear statistics)
+ * @param Config Pointer to configuration of TR module (NULL = default TR-72D module)
+ * @note Emulated module is connected to host port by iqrfHostAttachSlave(&IqrfEmuSlave)
+ */
+void iqrfEmuInit(const T_IQRF_EMU_CONFIG *Config);
+
+/**
+ * Set faults injected by emulated TR module
+ * @param Faults Pointer to fault profile (NULL = no faults)
+ * @note Faults are cleared by iqrfEmuInit()
+ */
+void iqrfEmuSetFaults(const T_IQRF_EMU_FAULTS *Faults);
+
+/**
+ * Put data for master to COM buffer of emulated TR module (packet received from IQRF network)
+ * @param Data Pointer to data
+ * @param Size Size of data (1 - 64 bytes)
+ * @return true = data are ready for master, false = TR module is off, in programming mode or COM buffer is full
+ */
+bool iqrfEmuPutComData(const uint8_t *Data, uint8_t Size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file IQRF SPI support library (host platform port)
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _IQRF_HOST_H
+#define _IQRF_HOST_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "IQRFPort.h"
+
+typedef struct {                          // SPI slave (TR module) connected to host port
+    void (*Power)(bool On);               // TR module power supply control
+    uint8_t (*Transfer)(uint8_t TxByte);  // one byte SPI transfer
+    void (*EnterPgmMode)(void);           // step of programming mode entry sequence (MOSI to MISO echo),
+                                          // called until TR module reports programming mode
+} T_IQRF_HOST_SLAVE;
+
+/**
+ * Get monotonic time in us
+ * @return time in us
+ */
+uint64_t iqrfHostTimeUs(void);
+
+/**
+ * Run IQRF driver and sleep until its next tick (called from main loops of host programs)
+ * @note In virtual time the time jumps to next driver tick without sleeping
+ */
+void iqrfHostIdle(void);
+
+/**
+ * Switch host port to virtual time, time of the port, IQRF driver and emulated TR module is advanced
+ * only by delays, idle calls (to next driver tick) and busy-wait polls (IQRF_HOST_POLL_TIME),
+ * so timing of the program does not depend on the host and runs much faster than real time
+ * @param On true = time is virtual, false = real time
+ */
+void iqrfHostSetVirtualTime(bool On);
+
+/**
+ * Start capture of SPI traffic, text file with one line per event ('#' = comment):
+ *   time F tx bytes : rx bytes  - SPI frame (status check or whole packet), hexadecimal bytes
+ *   time P 1|0                  - power of TR module on / off
+ *   time E 1|0                  - start / end of programming mode entry
+ * time is in us from the start of capture (start of the frame)
+ * @param File file for the capture (NULL = stop capture)
+ */
+void iqrfHostCapture(FILE *File);
+
+/**
+ * Connect SPI slave to host port
+ * @param Slave Pointer to SPI slave interface (NULL = no TR module connected)
+ */
+void iqrfHostAttachSlave(const T_IQRF_HOST_SLAVE *Slave);
+
+/**
+ * Set directory of programmer persistent storage
+ * @param Path path to directory (NULL = current directory)
+ */
+void iqrfHostSetStorageDir(const char *Path);
+
+/**
+ * Open code file for programmer
+ * @param FileName Name of code file
+ * @param FileType Type of code file (IQRF_PGM_HEX_FILE_TYPE ...)
+ * @return true = file opened, false = file not found or too big
+ */
+bool iqrfHostOpenCodeFile(const char *FileName, uint8_t FileType);
+
+/**
+ * Rewind code file to the beginning
+ */
+void iqrfHostRewindCodeFile(void);
+
+/**
+ * Close code file
+ */
+void iqrfHostCloseCodeFile(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,538 @@
+/**
+ * @file IQRF SPI support library (host platform port)
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFHost.h"
+
+// virtual time of busy-wait poll (iqrfPollDriver(), iqrfGetSysTick()) in us
+#if !defined(IQRF_HOST_POLL_TIME)
+#define IQRF_HOST_POLL_TIME       10
+#endif
+// start of virtual time in us (0 is used as "not set" by time stamps)
+#define HOST_VIRTUAL_START_TIME   1000000
+// maximal size of captured SPI frame (longest IQRF SPI packet)
+#define HOST_FRAME_SIZE           68
+
+void iqrfDriver(void);
+void hostRunDriver(void);
+void hostAdvanceTime(uint64_t Time);
+void hostCaptureEvent(char Type, uint8_t Value);
+
+FILE *CodeFile;
+#if defined(__linux__)
+const uint8_t *CodeFileMap;               // code file mapped to memory
+size_t CodeFileMapSize;                   // size of mapping (file info may describe decompressed code file)
+#endif
+IQRF_PGM_FILE_INFO  CodeFileInfo;
+T_IQRF_CONTROL IqrfControl;
+
+const T_IQRF_HOST_SLAVE *HostSlave;
+uint64_t HostStartTime;                   // start of the program in us
+uint64_t HostDriverTime;                  // time of last IQRF driver tick in us
+uint32_t HostDriverPeriod;                // IQRF driver period in us (0 = driver not running)
+uint8_t HostInDriver;
+const char *HostStorageDir;
+uint8_t HostVirtualTime;                  // time is virtual, it is advanced only by waits of the program
+uint64_t HostVirtualNow;                  // virtual time in us
+FILE *HostCapture;                        // capture of SPI traffic (NULL = no capture)
+uint64_t HostCaptureStart;
+uint64_t HostFrameTime;                   // start of captured SPI frame
+uint8_t HostFrameTx[HOST_FRAME_SIZE];     // bytes of SPI frame sent to TR module
+uint8_t HostFrameRx[HOST_FRAME_SIZE];     // bytes of SPI frame received from TR module
+uint8_t HostFrameLen;
+
+/**
+ * Get monotonic time in us
+ * @return time in us
+ */
+uint64_t iqrfHostTimeUs(void)
+{
+    struct timespec Ts;
+
+    if (HostVirtualTime)
+        return(HostVirtualNow);
+    clock_gettime(CLOCK_MONOTONIC, &Ts);
+    return((uint64_t)Ts.tv_sec * 1000000 + Ts.tv_nsec / 1000);
+}
+
+/**
+ * Delay on host platform
+ * @param Time delay in ms
+ */
+void iqrfHostDelayMs(uint32_t Time)
+{
+    uint64_t EndTime = iqrfHostTimeUs() + (uint64_t)Time * 1000;
+    struct timespec Ts = {0, 100000};
+
+    if (HostVirtualTime) {
+        hostAdvanceTime((uint64_t)Time * 1000);
+        return;
+    }
+    // IQRF driver keeps running during delay, same as in timer interrupt
+    while (iqrfHostTimeUs() < EndTime) {
+        iqrfHostPollDriver();
+        nanosleep(&Ts, NULL);
+    }
+}
+
+/**
+ * Get system timer value on host platform
+ * @return number of ms from start of the program
+ */
+uint32_t iqrfHostGetSysTick(void)
+{
+    if (!HostStartTime)
+        HostStartTime = iqrfHostTimeUs();
+    iqrfHostPollDriver();
+    return((uint32_t)((iqrfHostTimeUs() - HostStartTime) / 1000));
+}
+
+/**
+ * Run IQRF driver ticks elapsed since last call (called from busy-wait loops)
+ */
+void iqrfHostPollDriver(void)
+{
+    // busy-wait loop takes time also in virtual time
+    if (HostVirtualTime)
+        HostVirtualNow += IQRF_HOST_POLL_TIME;
+    hostRunDriver();
+}
+
+/**
+ * Run IQRF driver ticks elapsed since last run
+ */
+void hostRunDriver(void)
+{
+    uint64_t Now;
+
+    // driver not initialized yet or called from RX handler
+    if (!HostDriverPeriod || HostInDriver)
+        return;
+    HostInDriver = true;
+    Now = iqrfHostTimeUs();
+    // do not try to catch up after long stop of the program
+    if (Now - HostDriverTime > 100000)
+        HostDriverTime = Now - 100000;
+    while (Now - HostDriverTime >= HostDriverPeriod) {
+        HostDriverTime += HostDriverPeriod;
+        iqrfDriver();
+    }
+    HostInDriver = false;
+}
+
+/**
+ * Run IQRF driver and sleep until its next tick (called from main loops of host programs)
+ */
+void iqrfHostIdle(void)
+{
+    uint64_t Now;
+    struct timespec Ts = {0, 0};
+
+    if (HostVirtualTime) {
+        // nothing to do until next driver tick, virtual time jumps to it
+        hostRunDriver();
+        if (HostDriverPeriod && HostDriverTime + HostDriverPeriod > HostVirtualNow)
+            HostVirtualNow = HostDriverTime + HostDriverPeriod;
+        else if (!HostDriverPeriod)
+            HostVirtualNow += 1000;
+        hostRunDriver();
+        return;
+    }
+    hostRunDriver();
+    Now = iqrfHostTimeUs();
+    if (HostDriverPeriod && HostDriverTime + HostDriverPeriod > Now) {
+        Ts.tv_nsec = (long)(HostDriverTime + HostDriverPeriod - Now) * 1000;
+        nanosleep(&Ts, NULL);
+    }
+}
+
+/**
+ * Switch host port to virtual time
+ * @param On true = time is virtual, false = real time
+ */
+void iqrfHostSetVirtualTime(bool On)
+{
+    HostVirtualNow = HOST_VIRTUAL_START_TIME;
+    HostVirtualTime = On;
+    // time stamps of previous time base are not valid
+    HostStartTime = 0;
+    HostDriverTime = iqrfHostTimeUs();
+}
+
+/**
+ * Advance virtual time, IQRF driver runs in every tick of the interval
+ * @param Time interval in us
+ */
+void hostAdvanceTime(uint64_t Time)
+{
+    uint64_t EndTime = HostVirtualNow + Time;
+    uint64_t NextTick;
+
+    while (HostVirtualNow < EndTime) {
+        // driver does not run during delay in RX handler (called from the driver)
+        NextTick = (HostDriverPeriod && !HostInDriver) ? HostDriverTime + HostDriverPeriod : EndTime;
+        if (NextTick > HostVirtualNow)
+            HostVirtualNow = NextTick < EndTime ? NextTick : EndTime;
+        hostRunDriver();
+    }
+}
+
+/**
+ * initialize IQRF SPI kernel timing
+ */
+void iqrfKernelTimingInit(void)
+{
+    HostDriverTime = iqrfHostTimeUs();
+    HostDriverPeriod = 1000;                            // call IQRF driver every 1000us
+}
+
+/**
+ * switch IQRF SPI kernel timing to fast mode
+ */
+void iqrfKernelTimingFastMode(void)
+{
+    IqrfControl.FastSPI = true;                         // set FastSPI flag
+    HostDriverPeriod = 200;                             // call IQRF driver every 200us
+}
+
+/**
+ * turn OFF power supply of TR module
+ */
+void iqrfTrPowerOff(void)
+{
+    hostCaptureEvent('P', 0);
+    if (HostSlave)
+        HostSlave->Power(false);
+}
+
+/**
+ * turn ON power supply of TR module
+ */
+void iqrfTrPowerOn(void)
+{
+    hostCaptureEvent('P', 1);
+    if (HostSlave)
+        HostSlave->Power(true);
+}
+
+/**
+ * switch TR module to programming mode
+ */
+void iqrfTrEnterPgmMode(void)
+{
+    uint32_t SysTickTime;
+    uint32_t CheckTime;
+    uint8_t SpiStatus;
+
+    iqrfDelayMs(200);
+    iqrfSuspendDriver();
+    iqrfTrReset();
+    hostCaptureEvent('E', 1);
+    SysTickTime = iqrfGetSysTick();
+    do {
+        // TR module echoes MOSI to MISO => TR into programming mode
+        CheckTime = iqrfGetSysTick();
+        do {
+            if (HostSlave)
+                HostSlave->EnterPgmMode();
+            iqrfDelayMs(1);
+        } while ((iqrfGetSysTick() - CheckTime) < IQRF_PGM_MODE_CHECK_PERIOD);
+        // stop the echo as soon as TR module reports programming mode
+        SpiStatus = iqrfSendSpiByte(SPI_CHECK);
+        iqrfDeselectTRmodule();
+    } while (SpiStatus != PROGRAMMING_MODE && (iqrfGetSysTick() - SysTickTime) < IQRF_PGM_MODE_ENTRY_TIMEOUT);
+    hostCaptureEvent('E', 0);
+    iqrfRunDriver();
+}
+
+/**
+ * Deselect TR module
+ */
+void iqrfDeselectTRmodule(void)
+{
+    IqrfControl.TRmoduleSelected = false;
+    // end of SPI frame (status check or whole packet)
+    if (HostCapture && HostFrameLen) {
+        fprintf(HostCapture, "%llu F", (unsigned long long)(HostFrameTime - HostCaptureStart));
+        for (uint8_t Cnt=0; Cnt<HostFrameLen; Cnt++)
+            fprintf(HostCapture, " %02X", HostFrameTx[Cnt]);
+        fprintf(HostCapture, " :");
+        for (uint8_t Cnt=0; Cnt<HostFrameLen; Cnt++)
+            fprintf(HostCapture, " %02X", HostFrameRx[Cnt]);
+        fprintf(HostCapture, "\n");
+    }
+    HostFrameLen = 0;
+}
+
+/**
+ * Send byte over SPI
+ *
+ * @param Tx_Byte to send
+ * @return Received Rx_Byte
+ *
+ */
+uint8_t iqrfSendSpiByte(uint8_t Tx_Byte)
+{
+    uint8_t Rx_Byte;
+
+    IqrfControl.TRmoduleSelected = true;
+    // MISO is pulled up, if no TR module is connected
+    Rx_Byte = HostSlave ? HostSlave->Transfer(Tx_Byte) : NO_MODULE;
+    if (HostCapture && HostFrameLen < HOST_FRAME_SIZE) {
+        if (HostFrameLen == 0)
+            HostFrameTime = iqrfHostTimeUs();
+        HostFrameTx[HostFrameLen] = Tx_Byte;
+        HostFrameRx[HostFrameLen++] = Rx_Byte;
+    }
+    // byte by byte transfer in slow mode, the frame ends by iqrfDeselectTRmodule() of the driver
+    if (IqrfControl.FastSPI == false)
+        IqrfControl.TRmoduleSelected = false;
+
+    return (Rx_Byte);
+}
+
+/**
+ * Read byte from code file
+ *
+ * @param - none
+ * @return - byte from firmware file or 0 = end of file
+ *
+ */
+uint8_t iqrfReadByteFromFile(void)
+{
+    int Byte;
+
+    if (CodeFile && (Byte = fgetc(CodeFile)) != EOF) {
+        CodeFileInfo.FileByteCnt++;
+        return ((uint8_t)Byte);
+    } else {
+        return(0);
+    }
+}
+
+/**
+ * Read block of data from code file
+ *
+ * @param Buffer pointer to destination buffer
+ * @param Size maximal number of bytes to read
+ * @return number of bytes read, 0 = end of file
+ *
+ */
+uint16_t iqrfReadBlockFromFile(uint8_t *Buffer, uint16_t Size)
+{
+    size_t Count;
+
+    if (!CodeFile)
+        return(0);
+    Count = fread(Buffer, 1, Size, CodeFile);
+    return((uint16_t)Count);
+}
+
+/**
+ * Set position of next read from code file
+ *
+ * @param Offset position in code file
+ * @return true = position changed, false = error
+ *
+ */
+uint8_t iqrfSeekFile(uint32_t Offset)
+{
+    return(CodeFile && fseek(CodeFile, Offset, SEEK_SET) == 0);
+}
+
+/**
+ * Start capture of SPI traffic
+ * @param File file for the capture (NULL = stop capture), times are relative to the start of capture
+ */
+void iqrfHostCapture(FILE *File)
+{
+    if (HostCapture)
+        fflush(HostCapture);
+    HostCapture = File;
+    HostCaptureStart = iqrfHostTimeUs();
+    HostFrameLen = 0;
+    if (HostCapture)
+        fprintf(HostCapture, "# IQRF SPI capture\n");
+}
+
+/**
+ * Write event of TR module control to SPI capture
+ * @param Type type of event ('P' = power, 'E' = programming mode entry)
+ * @param Value 1 = on / start, 0 = off / end
+ */
+void hostCaptureEvent(char Type, uint8_t Value)
+{
+    if (HostCapture)
+        fprintf(HostCapture, "%llu %c %u\n", (unsigned long long)(iqrfHostTimeUs() - HostCaptureStart), Type, Value);
+}
+
+/**
+ * Connect SPI slave to host port
+ * @param Slave Pointer to SPI slave interface (NULL = no TR module connected)
+ */
+void iqrfHostAttachSlave(const T_IQRF_HOST_SLAVE *Slave)
+{
+    HostSlave = Slave;
+}
+
+/**
+ * Open code file for programmer
+ * @param FileName Name of code file
+ * @param FileType Type of code file (IQRF_PGM_HEX_FILE_TYPE ...)
+ * @return true = file opened, false = file not found or too big
+ */
+bool iqrfHostOpenCodeFile(const char *FileName, uint8_t FileType)
+{
+    long Size;
+
+    iqrfHostCloseCodeFile();
+    if ((CodeFile = fopen(FileName, "rb")) == NULL)
+        return(false);
+    fseek(CodeFile, 0, SEEK_END);
+    Size = ftell(CodeFile);
+    rewind(CodeFile);
+    // size of code file is limited by IQRF_PGM_FILE_INFO structure
+    if (Size <= 0 || (unsigned long)Size > 0xFFFFFFFFUL) {
+        iqrfHostCloseCodeFile();
+        return(false);
+    }
+    CodeFileInfo.FileSize = (uint32_t)Size;
+    CodeFileInfo.FileByteCnt = 0;
+    CodeFileInfo.FileType = FileType;
+#if defined(__linux__)
+    // programmer reads mapped code file in place, without copying
+    CodeFileMap = mmap(NULL, (size_t)Size, PROT_READ, MAP_PRIVATE, fileno(CodeFile), 0);
+    if (CodeFileMap == MAP_FAILED) {
+        CodeFileMap = NULL;
+    } else {
+        CodeFileMapSize = (size_t)Size;
+        iqrfPgmSetMemoryStream(CodeFileMap, (uint32_t)Size);
+    }
+#endif
+    return(true);
+}
+
+/**
+ * Rewind code file to the beginning
+ */
+void iqrfHostRewindCodeFile(void)
+{
+    if (CodeFile)
+        rewind(CodeFile);
+    CodeFileInfo.FileByteCnt = 0;
+}
+
+/**
+ * Close code file
+ */
+void iqrfHostCloseCodeFile(void)
+{
+#if defined(__linux__)
+    if (CodeFileMap) {
+        munmap((void *)CodeFileMap, CodeFileMapSize);
+        iqrfPgmSetStream(NULL, NULL);
+    }
+    CodeFileMap = NULL;
+#endif
+    if (CodeFile)
+        fclose(CodeFile);
+    CodeFile = NULL;
+}
+
+/**
+ * Set directory of programmer persistent storage
+ * @param Path path to directory (NULL = current directory)
+ */
+void iqrfHostSetStorageDir(const char *Path)
+{
+    HostStorageDir = Path;
+}
+
+/**
+ * Open record of programmer persistent storage
+ * @param Name name of the storage record
+ * @param Create true = create record, if does not exist
+ * @return file handle or NULL
+ */
+FILE *iqrfHostOpenStorage(const char *Name, bool Create)
+{
+    char Path[512];
+    FILE *Record;
+
+    snprintf(Path, sizeof(Path), "%s/%s", HostStorageDir ? HostStorageDir : ".", Name);
+    if ((Record = fopen(Path, "r+b")) == NULL && Create)
+        Record = fopen(Path, "w+b");
+    return(Record);
+}
+
+/**
+ * Read data from persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name)
+ * @param Offset position of data in the record
+ * @param Buffer pointer to destination buffer
+ * @param Size number of bytes to read
+ * @return number of bytes read, 0 = record or data does not exist
+ *
+ */
+uint16_t iqrfReadStorage(const char *Name, uint32_t Offset, uint8_t *Buffer, uint16_t Size)
+{
+    FILE *Record;
+    size_t Count = 0;
+
+    if ((Record = iqrfHostOpenStorage(Name, false)) != NULL) {
+        if (fseek(Record, Offset, SEEK_SET) == 0)
+            Count = fread(Buffer, 1, Size, Record);
+        fclose(Record);
+    }
+    return((uint16_t)Count);
+}
+
+/**
+ * Write data to persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name), record is created if does not exist
+ * @param Offset position of data in the record
+ * @param Buffer pointer to source buffer
+ * @param Size number of bytes to write
+ * @return number of bytes written
+ *
+ */
+uint16_t iqrfWriteStorage(const char *Name, uint32_t Offset, const uint8_t *Buffer, uint16_t Size)
+{
+    FILE *Record;
+    size_t Count = 0;
+
+    if ((Record = iqrfHostOpenStorage(Name, true)) != NULL) {
+        // gap before required position is filled by zeros
+        if (fseek(Record, Offset, SEEK_SET) == 0)
+            Count = fwrite(Buffer, 1, Size, Record);
+        fclose(Record);
+    }
+    return((uint16_t)Count);
+}
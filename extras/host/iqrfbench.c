@@ -0,0 +1,664 @@
+/**
+ * @file Microbenchmarks of IQRF library and console functions on host
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "ccptab.h"
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFHost.h"
+#include "IQRFEmu.h"
+
+// minimal run time of one measurement in ns
+#define BENCH_MIN_TIME    200000000ULL
+// number of commands in synthetic command table
+#define SYNTH_COMMANDS    128
+// packets sent in communication mode under every fault profile
+#define FAULT_PACKETS     200
+// period of packets received by TR module from IQRF network in us
+#define FAULT_READ_PERIOD 50000
+// limit of one scenario in virtual time (us)
+#define FAULT_TIMEOUT     60000000ULL
+// failed programming is resumed up to this number of attempts
+#define FAULT_PGM_ATTEMPTS 5
+// main flash memory written by synthetic HEX file (words)
+#define BENCH_FLASH_START IQRF_MAIN_MEM_MIN_ADR
+#define BENCH_FLASH_END   0x3FF0
+// lines of synthetic plugin file
+#define BENCH_PLUGIN_LINES 1000
+
+typedef struct {                          // registered benchmark
+    const char *Name;
+    void (*Func)(void);
+} BENCH;
+
+typedef struct {                          // fault profile of emulated TR module
+    const char *Name;
+    T_IQRF_EMU_FAULTS Faults;
+} FAULT_PROFILE;
+
+/* Functions and variables of IQRF.c without public prototype */
+uint8_t iqrfCrcCalculate(uint8_t *Buffer, uint8_t DataLength);
+bool iqrfCrcCheck(uint8_t *Buffer, uint8_t DataLength, uint8_t Ptype);
+void iqrfSpiDriver(void);
+void iqrfTrInfoProcess(uint8_t *DataBuffer, uint8_t DataSize);
+extern volatile uint8_t IqrfTrInfoReading;
+
+/* Function prototypes */
+uint64_t benchNow(void);
+void benchReport(const char *Name, uint64_t Time, uint64_t Ops);
+const COM *linearFind(const COM *Table, uint8_t Count, const char *Word, uint8_t Size);
+void benchCmdTable(const char *Name, const COM *Table, uint8_t Count);
+void benchCmd(void);
+void cmdDummy(uint16_t Param);
+uint16_t benchFlashWord(uint16_t Address);
+uint32_t benchBuildHex(char *Buffer);
+uint32_t benchBuildPlugin(char *Buffer);
+void benchCrc(void);
+void benchFrameRxHandler(uint8_t *DataBuffer, uint8_t DataSize);
+void benchFrame(void);
+void benchInfo(void);
+void benchParseFile(const char *Name, const char *Data, uint32_t Size, uint8_t FileType);
+void benchParse(void);
+void faultRxHandler(uint8_t *DataBuffer, uint8_t DataSize);
+void faultComm(void);
+uint8_t faultPgm(const char *Hex, uint32_t HexSize);
+void benchFaults(void);
+
+/* Global variables */
+const BENCH Benchmarks[] = {
+    {"cmd", benchCmd},
+    {"crc", benchCrc},
+    {"frame", benchFrame},
+    {"info", benchInfo},
+    {"parse", benchParse},
+    {"faults", benchFaults},
+};
+volatile uintptr_t BenchSink;             // results are stored here, so the compiler cannot drop the work
+uint32_t FaultRxPackets;
+uint32_t BenchRxPackets;
+uint8_t BenchFailed;                      // any verification failed, exit status is not zero
+uint8_t BenchBlockMap[IQRF_PGM_MAP_SIZE]; // block map of HEX files in RAM, as on host programmer
+
+// the same seed in every profile, results are repeatable
+const FAULT_PROFILE FaultProfiles[] = {
+    // name       seed  crc  busy rate/ms  dropout rate/ms  slow entry rate/ms
+    {"none",    {1,     0,   0,   0,       0,   0,          0,   0}},
+    {"crc",     {1,     50,  0,   0,       0,   0,          0,   0}},
+    {"busy",    {1,     0,   100, 50,      0,   0,          0,   0}},
+    {"dropout", {1,     0,   0,   0,       5,   200,        0,   0}},
+    {"slowpgm", {1,     0,   0,   0,       0,   0,          500, 600}},
+    {"mixed",   {1,     20,  50,  50,      1,   200,        250, 600}},
+};
+
+// command table of the console example (ccp.cpp), service functions of the console are not linked
+#define BENCH_COMMAND_ITEM(Name, Func, Param)   {Name, cmdDummy, Param},
+const COM ConsoleCommands[] = {
+    CCP_CONSOLE_COMMANDS(BENCH_COMMAND_ITEM)
+};
+
+/**
+ * Get monotonic time
+ * @return time in ns
+ */
+uint64_t benchNow(void)
+{
+    struct timespec Time;
+
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return((uint64_t)Time.tv_sec * 1000000000ULL + Time.tv_nsec);
+}
+
+/**
+ * Print result of one measurement
+ * @param Name name of the measurement
+ * @param Time run time in ns
+ * @param Ops number of operations
+ */
+void benchReport(const char *Name, uint64_t Time, uint64_t Ops)
+{
+    printf("%-40s %10.1f ns/op %12llu ops\n", Name, (double)Time / Ops, (unsigned long long)Ops);
+}
+
+/**
+ * Dummy command service function
+ * @param Param parameter from command table
+ */
+void cmdDummy(uint16_t Param)
+{
+    (void)Param;
+}
+
+/**
+ * Find command by linear scan, every item is copied from flash (previous find_command() of the console)
+ * @param Table pointer to command table
+ * @param Count number of items in the table
+ * @param Word command name (without terminating zero)
+ * @param Size size of command name
+ * @return pointer to table item, NULL = command not found
+ */
+const COM *linearFind(const COM *Table, uint8_t Count, const char *Word, uint8_t Size)
+{
+    COM WorkCopy;
+    uint8_t Cnt;
+
+    for (Cnt=0; Cnt<Count; Cnt++) {
+        memcpy(&WorkCopy, &Table[Cnt], sizeof(WorkCopy));
+        if (strncmp(WorkCopy.Com, Word, Size) == 0 && WorkCopy.Com[Size] == 0)
+            return(&Table[Cnt]);
+    }
+    return(NULL);
+}
+
+/**
+ * Measure lookup of all commands of the table and of unknown command
+ * @param Name name of the table
+ * @param Table pointer to command table
+ * @param Count number of items in the table
+ */
+void benchCmdTable(const char *Name, const COM *Table, uint8_t Count)
+{
+    const COM *(*Find[2])(const COM *, uint8_t, const char *, uint8_t) = {linearFind, ccpTabFind};
+    const char *FindName[2] = {"linear", "binary"};
+    char Title[64];
+    uint64_t Start, Time, Ops;
+    uint8_t Cnt;
+
+    for (uint8_t Method=0; Method<2; Method++) {
+        Ops = 0;
+        Start = benchNow();
+        do {
+            for (Cnt=0; Cnt<Count; Cnt++)
+                BenchSink += (uintptr_t)Find[Method](Table, Count, Table[Cnt].Com, strlen(Table[Cnt].Com));
+            BenchSink += (uintptr_t)Find[Method](Table, Count, "unknown", 7);
+            Ops += Count + 1;
+        } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+        snprintf(Title, sizeof(Title), "cmd %s %s (%u)", Name, FindName[Method], Count);
+        benchReport(Title, Time, Ops);
+    }
+}
+
+/**
+ * Command lookup of console command processor
+ */
+void benchCmd(void)
+{
+    static COM Synth[SYNTH_COMMANDS];
+    uint8_t Count = sizeof(ConsoleCommands) / sizeof(COM);
+
+    if (!ccpTabSorted(ConsoleCommands, Count)) {
+        fprintf(stderr, "console command table is not sorted\n");
+        exit(1);
+    }
+    benchCmdTable("console", ConsoleCommands, Count);
+
+    // table with more commands (extensions, scripts ...), names are sorted by number
+    for (uint16_t Cnt=0; Cnt<SYNTH_COMMANDS; Cnt++) {
+        snprintf(Synth[Cnt].Com, sizeof(Synth[Cnt].Com), "cmd%03u", Cnt);
+        Synth[Cnt].Func = cmdDummy;
+    }
+    benchCmdTable("synthetic", Synth, SYNTH_COMMANDS);
+}
+
+/**
+ * CRC of SPI packet with 64 bytes of data (calculation for master packet, check of TR module data)
+ */
+void benchCrc(void)
+{
+    uint8_t Buffer[68];
+    uint64_t Start, Time, Ops;
+
+    Buffer[0] = SPI_WR_RD;
+    Buffer[1] = 0x80 | 64;
+    for (uint8_t Cnt=0; Cnt<64; Cnt++)
+        Buffer[Cnt + 2] = Cnt * 37;
+    Buffer[66] = iqrfCrcCalculate(Buffer, 64) ^ SPI_WR_RD;
+
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<1000; Cnt++) {
+            Buffer[2] = (uint8_t)Cnt;
+            BenchSink += iqrfCrcCalculate(Buffer, 64);
+        }
+        Ops += 1000;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    benchReport("crc calculate (64 B)", Time, Ops);
+
+    Buffer[2] = 0;
+    Buffer[66] = iqrfCrcCalculate(Buffer, 64) ^ SPI_WR_RD;
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<1000; Cnt++)
+            BenchSink += iqrfCrcCheck(Buffer, 64, Buffer[1]);
+        Ops += 1000;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    if (!iqrfCrcCheck(Buffer, 64, Buffer[1])) {
+        fprintf(stderr, "CRC check failed\n");
+        exit(1);
+    }
+    benchReport("crc check (64 B)", Time, Ops);
+}
+
+/**
+ * Receive handler of framing benchmark
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ */
+void benchFrameRxHandler(uint8_t *DataBuffer, uint8_t DataSize)
+{
+    BenchSink += DataBuffer[DataSize - 1];
+    BenchRxPackets++;
+}
+
+/**
+ * Framing of SPI packets by IQRF driver, packets are clocked to emulated TR module (includes cost of the emulator)
+ */
+void benchFrame(void)
+{
+    uint8_t Data[64];
+    uint64_t Start, Time, Ops;
+
+    memset(Data, 0xA5, sizeof(Data));
+    // time does not run, the driver is called directly
+    iqrfHostSetVirtualTime(true);
+    iqrfEmuInit(NULL);
+    iqrfHostAttachSlave(&IqrfEmuSlave);
+    iqrfInit(benchFrameRxHandler);
+    if (iqrfGetMcuType() == MCU_UNKNOWN) {
+        fprintf(stderr, "emulated TR module not found\n");
+        exit(1);
+    }
+
+    // status check and packet written by master
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<100; Cnt++) {
+            iqrfSendPacket(SPI_WR_RD, Data, sizeof(Data));
+            do {
+                iqrfSpiDriver();
+            } while (iqrfGetTxBufferStatus() == IQRF_BUFFER_BUSY || iqrfGetLibraryStatus() != IQRF_READY);
+        }
+        Ops += 100;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    benchReport("frame write (64 B)", Time, Ops);
+
+    // status check and packet read from TR module, reset ends writing of previous packets
+    IqrfEmuSlave.Power(false);
+    IqrfEmuSlave.Power(true);
+    BenchRxPackets = 0;
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<100; Cnt++) {
+            iqrfEmuPutComData(Data, sizeof(Data));
+            do {
+                iqrfSpiDriver();
+            } while (BenchRxPackets == Ops + Cnt);
+        }
+        Ops += 100;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    benchReport("frame read (64 B)", Time, Ops);
+    iqrfHostSetVirtualTime(false);
+}
+
+/**
+ * Decoding of basic and extended TR module info
+ */
+void benchInfo(void)
+{
+    uint8_t Basic[8] = {0x81, 0x00, 0xA7, 0x2D, 0x43, (TR_72D << 4) | PIC16LF1938, 0xD7, 0x08};
+    uint8_t Extended[32];
+    uint64_t Start, Time, Ops;
+
+    memset(Extended, 0x5A, sizeof(Extended));
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<1000; Cnt++) {
+            IqrfTrInfoReading = 4;
+            iqrfTrInfoProcess(Basic, sizeof(Basic));
+            BenchSink += IqrfTrInfoReading;
+        }
+        Ops += 1000;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    if (iqrfGetModuleId() != 0x8100A72DUL || iqrfGetModuleType() != TR_72D || iqrfGetOsBuild() != 0x08D7) {
+        fprintf(stderr, "module info decoded wrong\n");
+        exit(1);
+    }
+    benchReport("info basic (8 B)", Time, Ops);
+
+    Ops = 0;
+    Start = benchNow();
+    do {
+        for (uint16_t Cnt=0; Cnt<1000; Cnt++) {
+            IqrfTrInfoReading = 3;
+            iqrfTrInfoProcess(Extended, sizeof(Extended));
+            BenchSink += IqrfTrInfoReading;
+        }
+        Ops += 1000;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    benchReport("info extended (32 B)", Time, Ops);
+    IqrfTrInfoReading = 0;
+}
+
+/**
+ * Parse code file in memory to programming packets
+ * @param Name name of the file type
+ * @param Data code file
+ * @param Size size of code file
+ * @param FileType type of code file
+ */
+void benchParseFile(const char *Name, const char *Data, uint32_t Size, uint8_t FileType)
+{
+    IQRF_PGM_PACKET Packet;
+    char Title[64];
+    uint64_t Start, Time;
+    uint64_t Packets = 0;
+    uint64_t Files = 0;
+    uint8_t Result;
+
+    CodeFileInfo.FileType = FileType;
+    iqrfPgmSetMemoryStream((const uint8_t *)Data, Size);
+    Start = benchNow();
+    do {
+        iqrfPgmInitPacketReader();
+        while ((Result = iqrfPgmPreparePacket(&Packet)) == IQRF_PGM_FILE_DATA_READY)
+            Packets++;
+        if (Result != IQRF_PGM_END_OF_FILE) {
+            fprintf(stderr, "%s file format error\n", Name);
+            exit(1);
+        }
+        Files++;
+    } while ((Time = benchNow() - Start) < BENCH_MIN_TIME);
+    iqrfPgmSetStream(NULL, NULL);
+
+    snprintf(Title, sizeof(Title), "parse %s packet (%lu B, %.1f MB/s)", Name, (unsigned long)Size, Size * Files * 1000.0 / Time);
+    benchReport(Title, Time, Packets);
+}
+
+/**
+ * HEX and plugin parsers of the programmer (code files in memory)
+ */
+void benchParse(void)
+{
+    uint32_t HexSize = benchBuildHex(NULL);
+    uint32_t PluginSize = benchBuildPlugin(NULL);
+    char *Hex = malloc(HexSize);
+    char *Plugin = malloc(PluginSize);
+
+    if (Hex == NULL || Plugin == NULL) {
+        fprintf(stderr, "cannot prepare code files\n");
+        exit(1);
+    }
+    benchBuildHex(Hex);
+    benchBuildPlugin(Plugin);
+    benchParseFile("hex", Hex, HexSize, IQRF_PGM_HEX_FILE_TYPE);
+    benchParseFile("iqrf", Plugin, PluginSize, IQRF_PGM_PLUGIN_FILE_TYPE);
+    free(Hex);
+    free(Plugin);
+}
+
+/**
+ * Content of flash word written by synthetic HEX file
+ * @param Address word address
+ * @return 14 bit word
+ */
+uint16_t benchFlashWord(uint16_t Address)
+{
+    return((Address * 0x9E37U) & 0x3FFF);
+}
+
+/**
+ * Build Intel HEX code file writing main flash memory from BENCH_FLASH_START to BENCH_FLASH_END
+ * @param Buffer buffer for the file (NULL = compute size only)
+ * @return size of the file
+ */
+uint32_t benchBuildHex(char *Buffer)
+{
+    uint32_t Size = 0;
+    uint16_t Word;
+    uint8_t Sum;
+    char Line[64];
+    int Len;
+
+    Len = sprintf(Line, ":020000040000FA\n");
+    if (Buffer)
+        memcpy(Buffer, Line, Len);
+    Size += Len;
+    // 8 words in line, byte address is double of word address
+    for (uint16_t Address=BENCH_FLASH_START; Address<BENCH_FLASH_END; Address+=8) {
+        Len = sprintf(Line, ":10%04X00", Address * 2);
+        Sum = 0x10 + (uint8_t)(Address * 2 >> 8) + (uint8_t)(Address * 2);
+        for (uint8_t Cnt=0; Cnt<8; Cnt++) {
+            Word = benchFlashWord(Address + Cnt);
+            Len += sprintf(&Line[Len], "%02X%02X", Word & 0xFF, Word >> 8);
+            Sum += (uint8_t)Word + (uint8_t)(Word >> 8);
+        }
+        Len += sprintf(&Line[Len], "%02X\n", (uint8_t)-Sum);
+        if (Buffer)
+            memcpy(&Buffer[Size], Line, Len);
+        Size += Len;
+    }
+    Len = sprintf(Line, ":00000001FF\n");
+    if (Buffer)
+        memcpy(&Buffer[Size], Line, Len);
+    return(Size + Len);
+}
+
+/**
+ * Build plugin (*.iqrf) file with BENCH_PLUGIN_LINES lines of 20 bytes
+ * @param Buffer buffer for the file (NULL = compute size only)
+ * @return size of the file
+ */
+uint32_t benchBuildPlugin(char *Buffer)
+{
+    const char Header[] = "#$Plugin benchmark\r\n#$0001\r\n";
+    uint32_t Size = sizeof(Header) - 1;
+
+    if (Buffer)
+        memcpy(Buffer, Header, Size);
+    for (uint16_t Line=0; Line<BENCH_PLUGIN_LINES; Line++) {
+        for (uint8_t Cnt=0; Cnt<20; Cnt++) {
+            if (Buffer)
+                sprintf(&Buffer[Size], "%02X", (uint8_t)(Line * 20 + Cnt));
+            Size += 2;
+        }
+        if (Buffer)
+            memcpy(&Buffer[Size], "\r\n", 2);
+        Size += 2;
+    }
+    return(Size);
+}
+
+/**
+ * Receive handler of fault benchmark
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ */
+void faultRxHandler(uint8_t *DataBuffer, uint8_t DataSize)
+{
+    (void)DataBuffer;
+    (void)DataSize;
+    FaultRxPackets++;
+}
+
+/**
+ * Send FAULT_PACKETS packets as fast as possible, while TR module receives packets from IQRF network
+ */
+void faultComm(void)
+{
+    uint8_t Data[32];
+    uint64_t Start, Now, PacketStart, NextRead;
+    uint64_t Latency, SumLatency = 0, MaxLatency = 0;
+    uint32_t Sent = 0, Errors = 0, Injected = 0;
+    uint8_t Result;
+
+    memset(Data, 0x55, sizeof(Data));
+    FaultRxPackets = 0;
+    Start = PacketStart = NextRead = iqrfHostTimeUs();
+    while (Sent < FAULT_PACKETS && (Now = iqrfHostTimeUs()) - Start < FAULT_TIMEOUT) {
+        if (Now >= NextRead) {
+            if (iqrfEmuPutComData(Data, 16))
+                Injected++;
+            NextRead += FAULT_READ_PERIOD;
+        }
+        // latency of packet includes retries, busy TR module and dropouts
+        Result = iqrfSendData(Data, sizeof(Data));
+        if (Result == IQRF_OPERATION_OK) {
+            Now = iqrfHostTimeUs();
+            Latency = Now - PacketStart;
+            SumLatency += Latency;
+            if (Latency > MaxLatency)
+                MaxLatency = Latency;
+            PacketStart = Now;
+            Sent++;
+        } else if (Result == IQRF_TR_MODULE_WRITE_ERR) {
+            // the same packet is sent again
+            Errors++;
+        }
+        iqrfHostIdle();
+    }
+    for (uint8_t Cnt=0; Cnt<100; Cnt++)
+        iqrfHostIdle();
+    Now = iqrfHostTimeUs() - Start;
+
+    printf("  comm: %lu packets in %lu ms, %.1f packets/s, latency avg %.1f ms, max %.1f ms, %lu write errors, rx %lu/%lu\n",
+        (unsigned long)Sent, (unsigned long)(Now / 1000), Now ? Sent * 1000000.0 / Now : 0.0,
+        Sent ? SumLatency / 1000.0 / Sent : 0.0, MaxLatency / 1000.0,
+        (unsigned long)Errors, (unsigned long)FaultRxPackets, (unsigned long)Injected);
+}
+
+/**
+ * Write main flash memory of TR module, failed programming is resumed from its checkpoint
+ * @param Hex code file
+ * @param HexSize size of code file
+ * @return true = flash memory contains the code file, false = programming or verification failed
+ */
+uint8_t faultPgm(const char *Hex, uint32_t HexSize)
+{
+    uint64_t Start, Time;
+    uint16_t Wrong = 0;
+    uint16_t Sent = 0;
+    uint8_t Attempt;
+    uint8_t Result;
+
+    CodeFileInfo.FileType = IQRF_PGM_HEX_FILE_TYPE;
+    iqrfPgmSetMemoryStream((const uint8_t *)Hex, HexSize);
+    Start = iqrfHostTimeUs();
+    for (Attempt=1; ; Attempt++) {
+        while ((Result = (Attempt == 1 ? iqrfPgmWriteCodeFile() : iqrfPgmResumeCodeFile())) <= 100
+            && iqrfHostTimeUs() - Start < FAULT_TIMEOUT)
+        {
+            iqrfHostIdle();
+        }
+        Sent += IqrfPgmContext.Stats.PacketsSent;
+        if (Result != IQRF_PGM_ERROR || Attempt == FAULT_PGM_ATTEMPTS || iqrfHostTimeUs() - Start >= FAULT_TIMEOUT)
+            break;
+    }
+    Time = iqrfHostTimeUs() - Start;
+    iqrfPgmSetStream(NULL, NULL);
+
+    // packets rejected by TR module must be reported by the programmer, never lost silently
+    for (uint16_t Address=BENCH_FLASH_START; Address<BENCH_FLASH_END; Address++) {
+        if (IqrfEmuMemory.Flash[Address] != benchFlashWord(Address))
+            Wrong++;
+    }
+    printf("  pgm:  %u packets in %lu ms, entry %u ms, %u written, %u attempts, %s, %u wrong words\n",
+        Sent, (unsigned long)(Time / 1000), IqrfPgmContext.Stats.PgmModeEntryTime, IqrfEmuStats.FlashPackets,
+        Attempt, Wrong ? "VERIFY-FAIL" : (Result == IQRF_PGM_SUCCESS ? "OK" : "ERROR"), Wrong);
+    return(Result == IQRF_PGM_SUCCESS && !Wrong);
+}
+
+/**
+ * Throughput and recovery time of IQRF driver and programmer under fault profiles of emulated TR module (virtual time)
+ */
+void benchFaults(void)
+{
+    char StorageDir[] = "/tmp/iqrfbenchXXXXXX";
+    struct dirent *Entry;
+    char Path[sizeof(StorageDir) + 256];
+    DIR *Dir;
+    char *Hex;
+    uint32_t HexSize = benchBuildHex(NULL);
+    uint64_t Start;
+
+    // checkpoints of programming are not left in current directory
+    if ((Hex = malloc(HexSize)) == NULL || mkdtemp(StorageDir) == NULL) {
+        fprintf(stderr, "cannot prepare fault benchmark\n");
+        exit(1);
+    }
+    benchBuildHex(Hex);
+    iqrfHostSetStorageDir(StorageDir);
+    iqrfHostSetVirtualTime(true);
+
+    for (uint8_t Cnt=0; Cnt<sizeof(FaultProfiles)/sizeof(FAULT_PROFILE); Cnt++) {
+        iqrfEmuInit(NULL);
+        iqrfEmuSetFaults(&FaultProfiles[Cnt].Faults);
+        iqrfHostAttachSlave(&IqrfEmuSlave);
+        Start = iqrfHostTimeUs();
+        iqrfInit(faultRxHandler);
+        printf("faults %s: init %lu ms%s\n", FaultProfiles[Cnt].Name, (unsigned long)((iqrfHostTimeUs() - Start) / 1000),
+            iqrfGetMcuType() == MCU_UNKNOWN ? ", TR module not found" : "");
+        faultComm();
+        if (!faultPgm(Hex, HexSize))
+            BenchFailed = true;
+        printf("  injected: %u crc errors, %u busy bursts, %u dropouts, %u slow entries\n",
+            IqrfEmuStats.CrcFaults, IqrfEmuStats.BusyBursts, IqrfEmuStats.Dropouts, IqrfEmuStats.SlowEntries);
+    }
+
+    iqrfHostSetVirtualTime(false);
+    iqrfHostSetStorageDir(NULL);
+    if ((Dir = opendir(StorageDir)) != NULL) {
+        while ((Entry = readdir(Dir)) != NULL) {
+            snprintf(Path, sizeof(Path), "%s/%s", StorageDir, Entry->d_name);
+            if (Entry->d_name[0] != '.')
+                remove(Path);
+        }
+        closedir(Dir);
+    }
+    rmdir(StorageDir);
+    free(Hex);
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t Found = false;
+
+    iqrfPgmSetBlockMap(BenchBlockMap);
+    for (uint8_t Cnt=0; Cnt<sizeof(Benchmarks)/sizeof(BENCH); Cnt++) {
+        // without arguments all benchmarks are run
+        if (argc > 1 && strcmp(argv[1], Benchmarks[Cnt].Name) != 0)
+            continue;
+        Benchmarks[Cnt].Func();
+        Found = true;
+    }
+    if (!Found) {
+        fprintf(stderr, "usage: %s [benchmark]\n", argv[0]);
+        return(2);
+    }
+    return(BenchFailed ? 1 : 0);
+}
@@ -0,0 +1,246 @@
+/**
+ * @file Converter of code files to IQRF binary block image or compressed code file
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFHost.h"
+
+// maximal size of image file (header + records + trailer), much more than TR module memory
+#define MAX_IMAGE_SIZE    0xFFFF
+// maximal length of LZ match (length - IQRF_PGM_LZ_MIN_MATCH is stored in one byte)
+#define LZ_MAX_MATCH      (0xFF + IQRF_PGM_LZ_MIN_MATCH)
+
+uint8_t BlockMap[IQRF_PGM_MAP_SIZE];      // block map of HEX files
+
+/* Functions of IQRFPgm.c without public prototype */
+uint32_t iqrfPgmHash(uint32_t Hash, const uint8_t *Data, uint16_t Size);
+
+/* Function prototypes */
+uint8_t fileTypeFromName(const char *Name, uint8_t Compress);
+uint32_t lzCompress(const uint8_t *Data, uint32_t Size, uint8_t *Output);
+int compressCodeFile(const char *Name, const char *InputName, const char *OutputName, uint8_t FileType);
+
+/**
+ * Convert file type name to file type code
+ * @param Name file type name (hex, iqrf, trcnfg, img)
+ * @param Compress true = file is compressed, block image is accepted too
+ * @return file type code or 0 = unknown file type
+ */
+uint8_t fileTypeFromName(const char *Name, uint8_t Compress)
+{
+    if (strcmp(Name, "hex") == 0)
+        return(IQRF_PGM_HEX_FILE_TYPE);
+    if (strcmp(Name, "iqrf") == 0)
+        return(IQRF_PGM_PLUGIN_FILE_TYPE);
+    if (strcmp(Name, "trcnfg") == 0)
+        return(IQRF_PGM_CFG_FILE_TYPE);
+    if (Compress && strcmp(Name, "img") == 0)
+        return(IQRF_PGM_IMAGE_FILE_TYPE);
+    return(0);
+}
+
+/**
+ * Compress data by LZ tokens read by the programmer (see iqrfPgmCtxSetCompressedStream())
+ * @param Data pointer to data to be compressed
+ * @param Size size of data
+ * @param Output pointer to output buffer (at least Size + Size / 8 + 1 bytes)
+ * @return size of compressed data
+ */
+uint32_t lzCompress(const uint8_t *Data, uint32_t Size, uint8_t *Output)
+{
+    uint32_t Pos = 0;
+    uint32_t OutSize = 0;
+    uint32_t FlagsPos = 0;
+    uint32_t Distance;
+    uint32_t BestDistance;
+    uint32_t Length;
+    uint32_t BestLength;
+    uint8_t TokenCnt = 8;
+
+    while (Pos < Size) {
+        // every group of eight tokens starts by byte with token flags
+        if (TokenCnt == 8) {
+            FlagsPos = OutSize++;
+            Output[FlagsPos] = 0;
+            TokenCnt = 0;
+        }
+        // longest match in window, greedy parsing
+        BestLength = 0;
+        BestDistance = 0;
+        for (Distance = 1; Distance <= IQRF_PGM_LZ_WINDOW_SIZE && Distance <= Pos; Distance++) {
+            for (Length = 0; Length < LZ_MAX_MATCH && Pos + Length < Size
+                && Data[Pos + Length] == Data[Pos + Length - Distance]; Length++)
+                ;   /* void */
+            if (Length > BestLength) {
+                BestLength = Length;
+                BestDistance = Distance;
+            }
+        }
+        if (BestLength >= IQRF_PGM_LZ_MIN_MATCH) {
+            Output[OutSize++] = (uint8_t)(BestDistance - 1);
+            Output[OutSize++] = (uint8_t)(BestLength - IQRF_PGM_LZ_MIN_MATCH);
+            Pos += BestLength;
+        } else {
+            Output[FlagsPos] |= 1 << TokenCnt;
+            Output[OutSize++] = Data[Pos++];
+        }
+        TokenCnt++;
+    }
+    return(OutSize);
+}
+
+/**
+ * Write compressed code file (header, LZ tokens)
+ * @param Name name of the program
+ * @param InputName name of checked code file
+ * @param OutputName name of compressed file
+ * @param FileType type of code file
+ * @return exit code of the program
+ */
+int compressCodeFile(const char *Name, const char *InputName, const char *OutputName, uint8_t FileType)
+{
+    uint8_t *Data = NULL;
+    uint8_t *Compressed = NULL;
+    uint32_t Size = 0;
+    uint32_t CompressedSize = 0;
+    FILE *File;
+    int ExitCode = 1;
+
+    if ((File = fopen(InputName, "rb")) != NULL) {
+        fseek(File, 0, SEEK_END);
+        Size = (uint32_t)ftell(File);
+        rewind(File);
+        if ((Data = malloc(Size)) != NULL && (Compressed = malloc(IQRF_PGM_LZ_HEADER_SIZE + Size + Size / 8 + 1)) != NULL
+            && fread(Data, 1, Size, File) == Size)
+        {
+            // header: magic, format version, source file type, size of decompressed file
+            memcpy(Compressed, IQRF_PGM_LZ_MAGIC, 4);
+            Compressed[4] = IQRF_PGM_LZ_VERSION;
+            Compressed[5] = FileType;
+            Compressed[6] = Size & 0xFF;
+            Compressed[7] = (Size >> 8) & 0xFF;
+            Compressed[8] = (Size >> 16) & 0xFF;
+            Compressed[9] = (Size >> 24) & 0xFF;
+            CompressedSize = IQRF_PGM_LZ_HEADER_SIZE + lzCompress(Data, Size, &Compressed[IQRF_PGM_LZ_HEADER_SIZE]);
+            ExitCode = 0;
+        }
+        fclose(File);
+    }
+    if (ExitCode) {
+        fprintf(stderr, "%s: cannot read %s\n", Name, InputName);
+    } else if ((File = fopen(OutputName, "wb")) == NULL
+        || fwrite(Compressed, 1, CompressedSize, File) != CompressedSize
+        || fclose(File) != 0)
+    {
+        fprintf(stderr, "%s: cannot write %s\n", Name, OutputName);
+        ExitCode = 1;
+    } else {
+        printf("%s: %lu -> %lu bytes (%.1f %%)\n", OutputName, (unsigned long)Size, (unsigned long)CompressedSize,
+            Size ? CompressedSize * 100.0 / Size : 0.0);
+    }
+    free(Data);
+    free(Compressed);
+    return(ExitCode);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t Image[MAX_IMAGE_SIZE];
+    IQRF_PGM_PACKET Packet;
+    uint32_t ImageSize = IQRF_PGM_IMAGE_HEADER_SIZE;
+    uint16_t PacketCnt = 0;
+    uint8_t Compress = false;
+    uint8_t FileType;
+    uint32_t Hash;
+    uint8_t Checksum;
+    uint8_t Result;
+    FILE *Output;
+
+    // -z = compress code file instead of conversion to block image
+    if (argc == 5 && strcmp(argv[1], "-z") == 0) {
+        Compress = true;
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+    }
+    if (argc != 4 || (FileType = fileTypeFromName(argv[1], Compress)) == 0) {
+        fprintf(stderr, "usage: %s [-z] <hex|iqrf|trcnfg> <input file> <output image>\n"
+                        "       -z = write compressed code file instead of image (type img is accepted too)\n", argv[0]);
+        return(2);
+    }
+    if (!iqrfHostOpenCodeFile(argv[2], FileType)) {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[2]);
+        return(1);
+    }
+    if (FileType == IQRF_PGM_CFG_FILE_TYPE && CodeFileInfo.FileSize < 33) {
+        fprintf(stderr, "%s: %s: file format error\n", argv[0], argv[2]);
+        return(1);
+    }
+
+    // convert code file to packets, in the same way as during programming
+    iqrfPgmSetBlockMap(BlockMap);
+    iqrfPgmInitPacketReader();
+    while ((Result = iqrfPgmPreparePacket(&Packet)) == IQRF_PGM_FILE_DATA_READY) {
+        if (ImageSize + Packet.Length + 3 + IQRF_PGM_IMAGE_TRAILER_SIZE > MAX_IMAGE_SIZE) {
+            fprintf(stderr, "%s: %s: image too big\n", argv[0], argv[2]);
+            return(1);
+        }
+        // record: SPI command, size of data, data, checksum
+        Image[ImageSize++] = Packet.SpiCmd;
+        Image[ImageSize++] = Packet.Length;
+        memcpy(&Image[ImageSize], Packet.Data, Packet.Length);
+        ImageSize += Packet.Length;
+        Checksum = Packet.SpiCmd + Packet.Length;
+        for (uint8_t Cnt=0; Cnt<Packet.Length; Cnt++)
+            Checksum += Packet.Data[Cnt];
+        Image[ImageSize++] = (uint8_t)(0x100 - Checksum);
+        PacketCnt++;
+    }
+    iqrfHostCloseCodeFile();
+    if (Result != IQRF_PGM_END_OF_FILE) {
+        fprintf(stderr, "%s: %s: file format error\n", argv[0], argv[2]);
+        return(1);
+    }
+    // only checked code files are compressed
+    if (Compress)
+        return(compressCodeFile(argv[0], argv[2], argv[3], FileType));
+
+    // header: magic, format version, source file type, number of packets
+    memcpy(Image, IQRF_PGM_IMAGE_MAGIC, 4);
+    Image[4] = IQRF_PGM_IMAGE_VERSION;
+    Image[5] = FileType;
+    Image[6] = PacketCnt & 0x00FF;
+    Image[7] = PacketCnt >> 8;
+    // trailer: FNV-1a hash of header and all records, little-endian
+    Hash = iqrfPgmHash(0x811C9DC5UL, Image, (uint16_t)ImageSize);
+    for (uint8_t Cnt=0; Cnt<IQRF_PGM_IMAGE_TRAILER_SIZE; Cnt++)
+        Image[ImageSize++] = (uint8_t)(Hash >> (8 * Cnt));
+
+    if ((Output = fopen(argv[3], "wb")) == NULL
+        || fwrite(Image, 1, ImageSize, Output) != ImageSize
+        || fclose(Output) != 0)
+    {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[3]);
+        return(1);
+    }
+    printf("%s: %u packets, %lu -> %u bytes\n", argv[3], PacketCnt, (unsigned long)CodeFileInfo.FileSize, ImageSize);
+    return(0);
+}
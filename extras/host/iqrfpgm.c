@@ -0,0 +1,480 @@
+/**
+ * @file Command line programmer of TR modules
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFHost.h"
+#include "IQRFEmu.h"
+
+typedef struct {                          // programming options
+    uint8_t Emulator;                     // use emulated TR module
+    uint8_t SinglePass;                   // do not check code file before programming
+    uint8_t DeltaMode;
+    uint8_t Resume;                       // continue interrupted programming
+    uint8_t Session;                      // write all files in one programming mode session
+    uint8_t VirtualTime;                  // deterministic virtual time instead of real time
+    const char *CaptureName;              // file for capture of SPI traffic (NULL = no capture)
+} T_PGM_OPTIONS;
+
+IQRF_PGM_LZ_STREAM CompressedFile;       // decompressor of compressed code file
+uint8_t BlockMap[IQRF_PGM_MAP_SIZE];      // block map of HEX files is kept in RAM, not in storage directory
+
+/* Function prototypes */
+uint8_t fileTypeFromName(const char *Name);
+void rxHandler(uint8_t *DataBuffer, uint8_t DataSize);
+const char *moduleTypeName(uint8_t ModuleType);
+uint8_t programCodeFile(const char *FileName, uint8_t FileType, const T_PGM_OPTIONS *Options);
+uint8_t programKeyOrPass(const char *FileName, uint8_t FileType);
+uint8_t *loadFile(const char *FileName, uint32_t *Size);
+uint16_t memoryFetch(void *Context, uint32_t Offset, const uint8_t **Chunk);
+uint8_t decompressFile(IQRF_PGM_SESSION_ITEM *Item);
+int programSession(int Count, char *Args[], const T_PGM_OPTIONS *Options);
+void usage(const char *Name);
+
+/**
+ * Convert file type name to file type code
+ * @param Name file type name (hex, iqrf, trcnfg, img, pass, key)
+ * @return file type code or 0 = unknown file type
+ */
+uint8_t fileTypeFromName(const char *Name)
+{
+    if (strcmp(Name, "hex") == 0)
+        return(IQRF_PGM_HEX_FILE_TYPE);
+    if (strcmp(Name, "iqrf") == 0)
+        return(IQRF_PGM_PLUGIN_FILE_TYPE);
+    if (strcmp(Name, "trcnfg") == 0)
+        return(IQRF_PGM_CFG_FILE_TYPE);
+    if (strcmp(Name, "img") == 0)
+        return(IQRF_PGM_IMAGE_FILE_TYPE);
+    if (strcmp(Name, "pass") == 0)
+        return(IQRF_PGM_PASS_FILE_TYPE);
+    if (strcmp(Name, "key") == 0)
+        return(IQRF_PGM_KEY_FILE_TYPE);
+    return(0);
+}
+
+/**
+ * Received packets are not used by the programmer
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ */
+void rxHandler(uint8_t *DataBuffer, uint8_t DataSize)
+{
+    (void)DataBuffer;
+    (void)DataSize;
+}
+
+/**
+ * Get name of TR module type
+ * @param ModuleType TR module type code
+ * @return name of TR module type
+ */
+const char *moduleTypeName(uint8_t ModuleType)
+{
+    switch (ModuleType) {
+    case TR_52D:    return("TR-52D");
+    case TR_58D_RJ: return("TR-58D-RJ");
+    case TR_72D:    return("TR-72D");
+    case TR_53D:    return("TR-53D");
+    case TR_54D:    return("TR-54D");
+    case TR_55D:    return("TR-55D");
+    case TR_56D:    return("TR-56D");
+    case TR_76D:    return("TR-76D");
+    default:        return("unknown");
+    }
+}
+
+/**
+ * Check and write code file to TR module
+ * @param FileName name of code file
+ * @param FileType type of code file (compressed code file provides its own type)
+ * @param Options programming options
+ * @return IQRF_PGM_SUCCESS or error code
+ */
+uint8_t programCodeFile(const char *FileName, uint8_t FileType, const T_PGM_OPTIONS *Options)
+{
+    uint64_t StartTime;
+    uint64_t CheckTime = 0;
+    uint64_t WriteTime;
+    uint32_t BytesRead;
+    uint32_t BytesDecoded;
+    uint8_t Compressed;
+    uint8_t Result;
+
+    if (!iqrfHostOpenCodeFile(FileName, FileType)) {
+        fprintf(stderr, "%s: cannot open file\n", FileName);
+        return(IQRF_PGM_ERROR);
+    }
+    // compressed code file is read from the file and decompressed on the fly, like on SD card
+    Compressed = iqrfPgmSetCompressedStream(&CompressedFile, NULL, NULL);
+
+    // check format of whole file before TR module is touched
+    if (!Options->SinglePass) {
+        StartTime = iqrfHostTimeUs();
+        while ((Result = iqrfPgmCheckCodeFile()) <= 100)
+            ;
+        CheckTime = iqrfHostTimeUs() - StartTime;
+        if (Result != IQRF_PGM_SUCCESS) {
+            fprintf(stderr, "%s: file format error\n", FileName);
+            iqrfHostCloseCodeFile();
+            iqrfPgmSetStream(NULL, NULL);
+            return(Result);
+        }
+        iqrfHostRewindCodeFile();
+    }
+
+    // write the file, IQRF driver is run from the loop
+    iqrfPgmSetDeltaMode(Options->DeltaMode);
+    BytesRead = CompressedFile.BytesRead;
+    BytesDecoded = CompressedFile.BytesDecoded;
+    StartTime = iqrfHostTimeUs();
+    while ((Result = Options->Resume ? iqrfPgmResumeCodeFile() : iqrfPgmWriteCodeFile()) <= 100)
+        iqrfHostIdle();
+    WriteTime = iqrfHostTimeUs() - StartTime;
+    iqrfHostCloseCodeFile();
+    iqrfPgmSetStream(NULL, NULL);
+
+    printf("%s: check %.1f ms%s, write %lu ms (pgm mode entry %u ms), %u packets (%u skipped, %u resumed), %lu B, %.1f kB/s, %.0f packets/s\n",
+        FileName,
+        CheckTime / 1000.0,
+        IqrfPgmContext.Stats.CheckCached ? " (cached)" : "",
+        (unsigned long)(WriteTime / 1000),
+        IqrfPgmContext.Stats.PgmModeEntryTime,
+        IqrfPgmContext.Stats.PacketsSent, IqrfPgmContext.Stats.PacketsSkipped, IqrfPgmContext.Stats.PacketsResumed,
+        (unsigned long)CodeFileInfo.FileSize,
+        WriteTime ? CodeFileInfo.FileSize * 1000.0 / WriteTime : 0.0,
+        WriteTime ? IqrfPgmContext.Stats.PacketsSent * 1000000.0 / WriteTime : 0.0);
+    if (Compressed) {
+        // I/O of the upload, compressed file is read instead of decompressed code file
+        BytesRead = CompressedFile.BytesRead - BytesRead;
+        BytesDecoded = CompressedFile.BytesDecoded - BytesDecoded;
+        printf("%s: compressed, %lu B read for %lu B of code file, %ld B saved\n", FileName,
+            (unsigned long)BytesRead, (unsigned long)BytesDecoded, (long)BytesDecoded - (long)BytesRead);
+    }
+    if (Result == IQRF_PGM_FORMAT_ERROR)
+        fprintf(stderr, "%s: file format error\n", FileName);
+    else if (Result != IQRF_PGM_SUCCESS)
+        fprintf(stderr, "%s: programming error\n", FileName);
+    return(Result);
+}
+
+/**
+ * Write user password or user key to TR module
+ * @param FileName name of file with 16 bytes of password or key
+ * @param FileType IQRF_PGM_PASS_FILE_TYPE or IQRF_PGM_KEY_FILE_TYPE
+ * @return IQRF_PGM_SUCCESS or error code
+ */
+uint8_t programKeyOrPass(const char *FileName, uint8_t FileType)
+{
+    uint8_t Buffer[16];
+    uint64_t StartTime;
+    uint8_t Result;
+    FILE *File;
+
+    if ((File = fopen(FileName, "rb")) == NULL
+        || fread(Buffer, 1, sizeof(Buffer), File) != sizeof(Buffer)
+        || fgetc(File) != EOF)
+    {
+        fprintf(stderr, "%s: cannot read 16 bytes file\n", FileName);
+        if (File)
+            fclose(File);
+        return(IQRF_PGM_ERROR);
+    }
+    fclose(File);
+
+    StartTime = iqrfHostTimeUs();
+    while ((Result = iqrfPgmWriteKeyOrPass(FileType, Buffer)) == 0)
+        iqrfHostIdle();
+    printf("%s: write %lu ms (pgm mode entry %u ms)\n", FileName, (unsigned long)((iqrfHostTimeUs() - StartTime) / 1000),
+        IqrfPgmContext.Stats.PgmModeEntryTime);
+    if (Result != IQRF_PGM_SUCCESS)
+        fprintf(stderr, "%s: programming error\n", FileName);
+    return(Result);
+}
+
+/**
+ * Read whole file to memory
+ * @param FileName name of file
+ * @param Size pointer to variable, where size of file will be stored
+ * @return pointer to allocated buffer with file content or NULL
+ */
+uint8_t *loadFile(const char *FileName, uint32_t *Size)
+{
+    uint8_t *Data = NULL;
+    long FileSize;
+    FILE *File;
+
+    if ((File = fopen(FileName, "rb")) == NULL)
+        return(NULL);
+    fseek(File, 0, SEEK_END);
+    FileSize = ftell(File);
+    rewind(File);
+    if (FileSize > 0 && (Data = malloc(FileSize)) != NULL) {
+        if (fread(Data, 1, FileSize, File) != (size_t)FileSize) {
+            free(Data);
+            Data = NULL;
+        }
+        *Size = (uint32_t)FileSize;
+    }
+    fclose(File);
+    return(Data);
+}
+
+/**
+ * Provide chunks of compressed file loaded to memory
+ * @param Context pointer to session item with the file
+ * @param Offset position of requested chunk
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+uint16_t memoryFetch(void *Context, uint32_t Offset, const uint8_t **Chunk)
+{
+    IQRF_PGM_SESSION_ITEM *Item = (IQRF_PGM_SESSION_ITEM *)Context;
+    uint32_t Size;
+
+    if (Offset >= Item->FileInfo.FileSize)
+        return(0);
+    Size = Item->FileInfo.FileSize - Offset;
+    *Chunk = Item->Data + Offset;
+    return(Size > 0x8000 ? 0x8000 : (uint16_t)Size);
+}
+
+/**
+ * Replace compressed file of session item by decompressed code file (session items are read from memory)
+ * @param Item session item with loaded file
+ * @return true = item is ready, false = compressed file is damaged
+ */
+uint8_t decompressFile(IQRF_PGM_SESSION_ITEM *Item)
+{
+    static IQRF_PGM_CONTEXT Ctx;
+    IQRF_PGM_FILE_INFO FileInfo;
+    const uint8_t *Chunk;
+    uint8_t *Data;
+    uint32_t Offset = 0;
+    uint16_t Size;
+
+    iqrfPgmInit(&Ctx, &FileInfo);
+    if (!iqrfPgmCtxSetCompressedStream(&Ctx, &CompressedFile, memoryFetch, Item))
+        return(true);
+    if ((Data = malloc(FileInfo.FileSize ? FileInfo.FileSize : 1)) == NULL)
+        return(false);
+    while ((Size = Ctx.StreamFetch(Ctx.StreamContext, Offset, &Chunk)) != 0 && Offset + Size <= FileInfo.FileSize) {
+        memcpy(&Data[Offset], Chunk, Size);
+        Offset += Size;
+    }
+    if (Size != 0 || Offset != FileInfo.FileSize) {
+        free(Data);
+        return(false);
+    }
+    free((void *)Item->Data);
+    Item->Data = Data;
+    Item->FileInfo = FileInfo;
+    return(true);
+}
+
+/**
+ * Write all files to TR module in one programming mode session
+ * @param Count number of command line arguments with file types and names
+ * @param Args command line arguments with file types and names
+ * @param Options programming options
+ * @return number of failed files
+ */
+int programSession(int Count, char *Args[], const T_PGM_OPTIONS *Options)
+{
+    IQRF_PGM_SESSION_ITEM Items[32];
+    const char *ItemNames[32];              // file name of every item, files which cannot be read have no item
+    uint8_t ItemCnt = 0;
+    uint64_t StartTime;
+    uint64_t WriteTime;
+    uint32_t TotalSize = 0;
+    uint8_t Result;
+    int Failed = 0;
+
+    if (Count / 2 > (int)(sizeof(Items) / sizeof(Items[0]))) {
+        fprintf(stderr, "too many files in session\n");
+        return(Count / 2);
+    }
+    memset(Items, 0, sizeof(Items));
+    for (int Cnt=0; Cnt<Count; Cnt+=2) {
+        Items[ItemCnt].FileInfo.FileType = fileTypeFromName(Args[Cnt]);
+        if ((Items[ItemCnt].Data = loadFile(Args[Cnt + 1], &Items[ItemCnt].FileInfo.FileSize)) == NULL) {
+            fprintf(stderr, "%s: cannot open file\n", Args[Cnt + 1]);
+            Failed++;
+            continue;
+        }
+        // compressed code file provides its own type, like in single file programming
+        if (!decompressFile(&Items[ItemCnt])) {
+            fprintf(stderr, "%s: damaged compressed file\n", Args[Cnt + 1]);
+            free((void *)Items[ItemCnt].Data);
+            Failed++;
+            continue;
+        }
+        ItemNames[ItemCnt] = Args[Cnt + 1];
+        TotalSize += Items[ItemCnt].FileInfo.FileSize;
+        ItemCnt++;
+    }
+
+    // every record is validated before it is written, so the session is always single pass
+    iqrfPgmSetDeltaMode(Options->DeltaMode);
+    StartTime = iqrfHostTimeUs();
+    while ((Result = iqrfPgmWriteSession(Items, ItemCnt)) <= 100)
+        iqrfHostIdle();
+    WriteTime = iqrfHostTimeUs() - StartTime;
+
+    printf("session: write %lu ms (pgm mode entry %u ms), %u files, %u packets (%u skipped), %lu B, %.1f kB/s, %.0f packets/s\n",
+        (unsigned long)(WriteTime / 1000), IqrfPgmContext.Stats.PgmModeEntryTime, ItemCnt,
+        IqrfPgmContext.Stats.PacketsSent, IqrfPgmContext.Stats.PacketsSkipped,
+        (unsigned long)TotalSize,
+        WriteTime ? TotalSize * 1000.0 / WriteTime : 0.0,
+        WriteTime ? IqrfPgmContext.Stats.PacketsSent * 1000000.0 / WriteTime : 0.0);
+    for (uint8_t Item=0; Item<ItemCnt; Item++) {
+        if (Items[Item].Result == IQRF_PGM_FORMAT_ERROR)
+            fprintf(stderr, "%s: file format error\n", ItemNames[Item]);
+        else if (Items[Item].Result != IQRF_PGM_SUCCESS)
+            fprintf(stderr, "%s: programming error\n", ItemNames[Item]);
+        if (Items[Item].Result != IQRF_PGM_SUCCESS)
+            Failed++;
+        free((void *)Items[Item].Data);
+    }
+    return(Failed);
+}
+
+/**
+ * Print usage of the program
+ * @param Name name of the program
+ */
+void usage(const char *Name)
+{
+    fprintf(stderr,
+        "usage: %s [-e] [-t] [-c file] [-1] [-r] [-S] [-d off|on|force] [-s dir] <type> <file> [<type> <file> ...]\n"
+        "  type  hex, iqrf, trcnfg, img, pass or key (type of compressed code file is stored in the file)\n"
+        "  -e    program emulated TR module\n"
+        "  -t    virtual time, times are exact and repeatable (with -e), program runs faster than real time\n"
+        "  -c    capture SPI traffic to the file (see iqrfreplay)\n"
+        "  -1    single pass, do not check code files before programming\n"
+        "  -r    resume interrupted programming of code files\n"
+        "  -S    write all files in one programming mode session\n"
+        "  -d    delta programming mode (default off)\n"
+        "  -s    directory of programmer persistent storage (default .)\n",
+        Name);
+}
+
+int main(int argc, char *argv[])
+{
+    T_PGM_OPTIONS Options = {false, false, IQRF_PGM_DELTA_OFF, false, false, false, NULL};
+    uint64_t StartTime;
+    uint64_t InitTime;
+    uint8_t FileType;
+    FILE *Capture = NULL;
+    int Failed = 0;
+    int Arg;
+
+    for (Arg=1; Arg<argc && argv[Arg][0] == '-'; Arg++) {
+        if (strcmp(argv[Arg], "-e") == 0) {
+            Options.Emulator = true;
+        } else if (strcmp(argv[Arg], "-t") == 0) {
+            Options.VirtualTime = true;
+        } else if (strcmp(argv[Arg], "-c") == 0 && Arg + 1 < argc) {
+            Options.CaptureName = argv[++Arg];
+        } else if (strcmp(argv[Arg], "-1") == 0) {
+            Options.SinglePass = true;
+        } else if (strcmp(argv[Arg], "-r") == 0) {
+            Options.Resume = true;
+        } else if (strcmp(argv[Arg], "-S") == 0) {
+            Options.Session = true;
+        } else if (strcmp(argv[Arg], "-d") == 0 && Arg + 1 < argc) {
+            Arg++;
+            if (strcmp(argv[Arg], "off") == 0)
+                Options.DeltaMode = IQRF_PGM_DELTA_OFF;
+            else if (strcmp(argv[Arg], "on") == 0)
+                Options.DeltaMode = IQRF_PGM_DELTA_ON;
+            else if (strcmp(argv[Arg], "force") == 0)
+                Options.DeltaMode = IQRF_PGM_DELTA_FORCE;
+            else {
+                usage(argv[0]);
+                return(2);
+            }
+        } else if (strcmp(argv[Arg], "-s") == 0 && Arg + 1 < argc) {
+            iqrfHostSetStorageDir(argv[++Arg]);
+        } else {
+            usage(argv[0]);
+            return(2);
+        }
+    }
+    if (Arg >= argc || (argc - Arg) % 2) {
+        usage(argv[0]);
+        return(2);
+    }
+    for (int Cnt=Arg; Cnt<argc; Cnt+=2) {
+        if (fileTypeFromName(argv[Cnt]) == 0) {
+            usage(argv[0]);
+            return(2);
+        }
+    }
+
+    if (Options.CaptureName && (Capture = fopen(Options.CaptureName, "w")) == NULL) {
+        fprintf(stderr, "cannot create %s\n", Options.CaptureName);
+        return(2);
+    }
+
+    iqrfHostSetVirtualTime(Options.VirtualTime);
+    iqrfHostCapture(Capture);
+    StartTime = iqrfHostTimeUs();
+
+    // connect TR module and read its identification
+    if (Options.Emulator) {
+        iqrfEmuInit(NULL);
+        iqrfHostAttachSlave(&IqrfEmuSlave);
+    }
+    iqrfInit(rxHandler);
+    iqrfPgmSetBlockMap(BlockMap);
+    InitTime = iqrfHostTimeUs() - StartTime;
+    if (iqrfGetMcuType() == MCU_UNKNOWN) {
+        fprintf(stderr, "TR module not found\n");
+        return(1);
+    }
+    printf("TR module: ID %08lX, OS %u.%02u (%04X), %s, init %lu ms\n",
+        (unsigned long)iqrfGetModuleId(),
+        iqrfGetOsVersion() >> 8, iqrfGetOsVersion() & 0x00FF, iqrfGetOsBuild(),
+        moduleTypeName(iqrfGetModuleType()),
+        (unsigned long)(InitTime / 1000));
+
+    // program files in the order of command line
+    if (Options.Session)
+        Failed = programSession(argc - Arg, &argv[Arg], &Options);
+    for (; !Options.Session && Arg<argc; Arg+=2) {
+        FileType = fileTypeFromName(argv[Arg]);
+        if (FileType == IQRF_PGM_PASS_FILE_TYPE || FileType == IQRF_PGM_KEY_FILE_TYPE) {
+            if (programKeyOrPass(argv[Arg + 1], FileType) != IQRF_PGM_SUCCESS)
+                Failed++;
+        } else {
+            if (programCodeFile(argv[Arg + 1], FileType, &Options) != IQRF_PGM_SUCCESS)
+                Failed++;
+        }
+    }
+
+    printf("total %lu ms, %d failed\n", (unsigned long)((iqrfHostTimeUs() - StartTime) / 1000), Failed);
+    if (Capture) {
+        iqrfHostCapture(NULL);
+        fclose(Capture);
+    }
+    return(Failed ? 1 : 0);
+}
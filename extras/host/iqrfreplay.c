@@ -0,0 +1,358 @@
+/**
+ * @file Replayer of captured SPI traffic for performance regression tests
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "IQRF.h"
+#include "IQRFHost.h"
+#include "IQRFEmu.h"
+
+// maximal length of capture line (frame of 68 bytes in both directions)
+#define MAX_LINE_SIZE         1024
+// replay is stopped, if it takes longer than the recorded session + this time (us)
+#define REPLAY_TIMEOUT        10000000ULL
+// default limit of session duration increase in percent
+#define DEFAULT_TIME_LIMIT    5
+
+typedef struct {                          // application packet of captured session
+    uint64_t Time;                        // start of SPI frame in us from the first packet
+    uint8_t Write;                        // true = master -> TR module, false = TR module -> master
+    uint8_t Result;                       // true = TR module confirmed the packet (SPI_CRCM_OK)
+    uint8_t Size;
+    uint8_t Data[64];
+} T_REPLAY_PACKET;
+
+typedef struct {                          // packets of captured session
+    T_REPLAY_PACKET *Packets;
+    uint32_t Count;
+    uint32_t Writes;
+    uint32_t Reads;
+} T_REPLAY_SESSION;
+
+/* Function prototypes */
+uint8_t parseHex(char **Text, uint8_t *Buffer, uint8_t MaxSize);
+int loadCapture(FILE *File, T_REPLAY_SESSION *Session);
+void replayRxHandler(uint8_t *DataBuffer, uint8_t DataSize);
+int replaySession(const T_REPLAY_SESSION *Recorded, FILE *Capture);
+const T_REPLAY_PACKET *nextPacket(const T_REPLAY_SESSION *Session, uint32_t *Index, uint8_t Write);
+int compareSessions(const T_REPLAY_SESSION *Recorded, const T_REPLAY_SESSION *Replayed, int TimeLimit);
+
+/**
+ * Parse hexadecimal bytes separated by spaces
+ * @param Text pointer to text pointer, it is moved after parsed bytes
+ * @param Buffer buffer for bytes
+ * @param MaxSize size of the buffer
+ * @return number of parsed bytes
+ */
+uint8_t parseHex(char **Text, uint8_t *Buffer, uint8_t MaxSize)
+{
+    char *End;
+    unsigned long Byte;
+    uint8_t Size = 0;
+
+    while (Size < MaxSize) {
+        Byte = strtoul(*Text, &End, 16);
+        if (End == *Text)
+            break;
+        Buffer[Size++] = (uint8_t)Byte;
+        *Text = End;
+    }
+    return(Size);
+}
+
+/**
+ * Load application packets (SPI_WR_RD frames) from SPI capture (see iqrfHostCapture())
+ * @param File capture file
+ * @param Session loaded session, times are relative to the first packet
+ * @return 0 = OK, -1 = format error
+ */
+int loadCapture(FILE *File, T_REPLAY_SESSION *Session)
+{
+    char Line[MAX_LINE_SIZE];
+    char *Text;
+    uint8_t Tx[68];
+    uint8_t Rx[68];
+    uint8_t TxSize, RxSize, Dlen;
+    unsigned long long Time;
+    T_REPLAY_PACKET *Packet;
+    T_REPLAY_PACKET *Last;
+    uint32_t Allocated = 0;
+    uint8_t PgmMode = false;
+
+    memset(Session, 0, sizeof(*Session));
+    while (fgets(Line, sizeof(Line), File)) {
+        if (Line[0] == '#' || Line[0] == '\n')
+            continue;
+        if (sscanf(Line, "%llu", &Time) != 1)
+            return(-1);
+        // TR module is in programming mode from its entry to the next reset (power off)
+        if (strstr(Line, " E "))
+            PgmMode = true;
+        else if (strstr(Line, " P 0"))
+            PgmMode = false;
+        // only SPI frames of communication mode are replayed
+        if (PgmMode || (Text = strstr(Line, " F ")) == NULL)
+            continue;
+        Text += 3;
+        TxSize = parseHex(&Text, Tx, sizeof(Tx));
+        if ((Text = strchr(Text, ':')) == NULL)
+            return(-1);
+        Text++;
+        RxSize = parseHex(&Text, Rx, sizeof(Rx));
+        if (TxSize != RxSize)
+            return(-1);
+
+        // packet: command, PTYPE, data, CRCM, 0
+        if (TxSize < 5 || Tx[0] != SPI_WR_RD)
+            continue;
+        Dlen = Tx[1] & 0x7F;
+        if (Dlen == 0 || Dlen > 64 || TxSize != Dlen + 4)
+            continue;
+
+        // driver repeats rejected write of the same data, it is one packet of the application
+        Last = Session->Count ? &Session->Packets[Session->Count - 1] : NULL;
+        if (Last && Last->Write && !Last->Result && (Tx[1] & 0x80) && Last->Size == Dlen
+            && memcmp(Last->Data, &Tx[2], Dlen) == 0) {
+            Last->Result = (Rx[Dlen + 3] == SPI_CRCM_OK);
+            continue;
+        }
+
+        if (Session->Count == Allocated) {
+            Allocated = Allocated ? Allocated * 2 : 256;
+            if ((Session->Packets = realloc(Session->Packets, Allocated * sizeof(T_REPLAY_PACKET))) == NULL)
+                return(-1);
+        }
+        Packet = &Session->Packets[Session->Count++];
+        Packet->Time = Time;
+        Packet->Write = (Tx[1] & 0x80) != 0;
+        Packet->Result = (Rx[Dlen + 3] == SPI_CRCM_OK);
+        Packet->Size = Dlen;
+        memcpy(Packet->Data, Packet->Write ? &Tx[2] : &Rx[2], Dlen);
+        if (Packet->Write)
+            Session->Writes++;
+        else
+            Session->Reads++;
+    }
+
+    // times relative to the first packet
+    for (uint32_t Cnt=Session->Count; Cnt>0; Cnt--)
+        Session->Packets[Cnt - 1].Time -= Session->Packets[0].Time;
+    return(0);
+}
+
+/**
+ * Receive handler of replayed session (received data are checked from the capture)
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ */
+void replayRxHandler(uint8_t *DataBuffer, uint8_t DataSize)
+{
+    (void)DataBuffer;
+    (void)DataSize;
+}
+
+/**
+ * Find next write or read packet of the session
+ * @param Session captured session
+ * @param Index index of next packet to search from, it is moved after found packet
+ * @param Write true = write packet, false = read packet
+ * @return found packet or NULL
+ */
+const T_REPLAY_PACKET *nextPacket(const T_REPLAY_SESSION *Session, uint32_t *Index, uint8_t Write)
+{
+    while (*Index < Session->Count) {
+        if (Session->Packets[(*Index)++].Write == Write)
+            return(&Session->Packets[*Index - 1]);
+    }
+    return(NULL);
+}
+
+/**
+ * Replay recorded session by current library build against emulated TR module in virtual time:
+ * written packets are sent by iqrfSendData() and read packets are put to COM buffer of emulated
+ * TR module at their recorded times
+ * @param Recorded recorded session
+ * @param Capture file for capture of replayed session
+ * @return 0 = OK, -1 = TR module not found or replay timeout
+ */
+int replaySession(const T_REPLAY_SESSION *Recorded, FILE *Capture)
+{
+    const T_REPLAY_PACKET *Write;
+    const T_REPLAY_PACKET *Read;
+    uint32_t WriteIndex = 0;
+    uint32_t ReadIndex = 0;
+    uint64_t EndTime;
+    uint64_t StartTime;
+    uint64_t Now;
+    uint8_t Result;
+
+    iqrfHostSetVirtualTime(true);
+    iqrfEmuInit(NULL);
+    iqrfHostAttachSlave(&IqrfEmuSlave);
+    iqrfInit(replayRxHandler);
+    if (iqrfGetMcuType() == MCU_UNKNOWN)
+        return(-1);
+
+    iqrfHostCapture(Capture);
+    StartTime = iqrfHostTimeUs();
+    EndTime = StartTime + (Recorded->Count ? Recorded->Packets[Recorded->Count - 1].Time : 0) + REPLAY_TIMEOUT;
+    Write = nextPacket(Recorded, &WriteIndex, true);
+    Read = nextPacket(Recorded, &ReadIndex, false);
+
+    while (Write || Read) {
+        if ((Now = iqrfHostTimeUs()) > EndTime) {
+            iqrfHostCapture(NULL);
+            return(-1);
+        }
+        // data received by TR module from IQRF network, they wait if COM buffer is full
+        if (Read && Now - StartTime >= Read->Time && iqrfEmuPutComData(Read->Data, Read->Size))
+            Read = nextPacket(Recorded, &ReadIndex, false);
+        // packet is sent, when its time has come, the application repeats it while TR module is busy
+        if (Write && Now - StartTime >= Write->Time) {
+            Result = iqrfSendData((uint8_t *)Write->Data, Write->Size);
+            if (Result != IQRF_OPERATION_IN_PROGRESS && Result != IQRF_TR_MODULE_BUSY)
+                Write = nextPacket(Recorded, &WriteIndex, true);
+        }
+        iqrfHostIdle();
+    }
+    // last read packet is read by the driver
+    for (uint8_t Cnt=0; Cnt<100 && (iqrfGetSpiStatus() & 0xC0) != 0x80; Cnt++)
+        iqrfHostIdle();
+    iqrfHostCapture(NULL);
+    return(0);
+}
+
+/**
+ * Compare replayed session with recorded session and print differences
+ * @param Recorded recorded session
+ * @param Replayed replayed session
+ * @param TimeLimit allowed increase of session duration in percent
+ * @return 0 = sessions match, 1 = packets differ or duration increased over the limit
+ */
+int compareSessions(const T_REPLAY_SESSION *Recorded, const T_REPLAY_SESSION *Replayed, int TimeLimit)
+{
+    const T_REPLAY_PACKET *Old;
+    const T_REPLAY_PACKET *New;
+    uint32_t OldIndex, NewIndex;
+    uint32_t Pairs = 0;
+    uint32_t Mismatches = 0;
+    uint32_t ResultDiffs = 0;
+    int64_t Shift;
+    int64_t ShiftSum = 0;
+    int64_t MaxShift = 0;
+    uint64_t OldTime = Recorded->Count ? Recorded->Packets[Recorded->Count - 1].Time : 0;
+    uint64_t NewTime = Replayed->Count ? Replayed->Packets[Replayed->Count - 1].Time : 0;
+    double Change = OldTime ? ((double)NewTime - OldTime) * 100 / OldTime : 0;
+
+    // writes and reads are paired separately in the order of the sessions
+    for (uint8_t Write=0; Write<2; Write++) {
+        OldIndex = NewIndex = 0;
+        for (;;) {
+            Old = nextPacket(Recorded, &OldIndex, Write);
+            New = nextPacket(Replayed, &NewIndex, Write);
+            if (!Old || !New)
+                break;
+            Pairs++;
+            if (Old->Size != New->Size || memcmp(Old->Data, New->Data, Old->Size) != 0) {
+                if (Mismatches++ < 10)
+                    printf("%s packet at %lu us differs\n", Write ? "write" : "read", (unsigned long)Old->Time);
+            }
+            if (Old->Result != New->Result)
+                ResultDiffs++;
+            Shift = (int64_t)New->Time - (int64_t)Old->Time;
+            ShiftSum += Shift;
+            if (llabs(Shift) > llabs(MaxShift))
+                MaxShift = Shift;
+        }
+    }
+
+    printf("recorded: %lu writes, %lu reads, %lu ms\n", (unsigned long)Recorded->Writes, (unsigned long)Recorded->Reads,
+        (unsigned long)(OldTime / 1000));
+    printf("replayed: %lu writes, %lu reads, %lu ms (%+.1f %%)\n", (unsigned long)Replayed->Writes, (unsigned long)Replayed->Reads,
+        (unsigned long)(NewTime / 1000), Change);
+    if (Pairs)
+        printf("time shift: avg %+.2f ms, max %+.2f ms\n", (double)ShiftSum / Pairs / 1000, (double)MaxShift / 1000);
+    printf("%lu packets differ, %lu results differ (errors of real TR module are not emulated)\n",
+        (unsigned long)Mismatches, (unsigned long)ResultDiffs);
+
+    if (Mismatches || Recorded->Writes != Replayed->Writes || Recorded->Reads != Replayed->Reads) {
+        printf("FAIL: replayed packets differ\n");
+        return(1);
+    }
+    if (Change > TimeLimit) {
+        printf("FAIL: session is %.1f %% longer (limit %d %%)\n", Change, TimeLimit);
+        return(1);
+    }
+    printf("OK\n");
+    return(0);
+}
+
+int main(int argc, char *argv[])
+{
+    T_REPLAY_SESSION Recorded;
+    T_REPLAY_SESSION Replayed;
+    const char *OutputName = NULL;
+    int TimeLimit = DEFAULT_TIME_LIMIT;
+    FILE *Input;
+    FILE *Output;
+    int Arg;
+
+    for (Arg=1; Arg<argc && argv[Arg][0] == '-'; Arg++) {
+        if (strcmp(argv[Arg], "-o") == 0 && Arg + 1 < argc)
+            OutputName = argv[++Arg];
+        else if (strcmp(argv[Arg], "-l") == 0 && Arg + 1 < argc)
+            TimeLimit = atoi(argv[++Arg]);
+        else
+            break;
+    }
+    if (Arg + 1 != argc) {
+        fprintf(stderr, "usage: %s [-o capture] [-l percent] <recorded capture>\n"
+                        "  -o  write capture of replayed session\n"
+                        "  -l  allowed increase of session duration (default %d %%)\n", argv[0], DEFAULT_TIME_LIMIT);
+        return(2);
+    }
+
+    if ((Input = fopen(argv[Arg], "r")) == NULL) {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[Arg]);
+        return(2);
+    }
+    if (loadCapture(Input, &Recorded) != 0) {
+        fprintf(stderr, "%s: %s: format error\n", argv[0], argv[Arg]);
+        return(2);
+    }
+    fclose(Input);
+
+    Output = OutputName ? fopen(OutputName, "w+") : tmpfile();
+    if (Output == NULL) {
+        fprintf(stderr, "%s: cannot create capture of replayed session\n", argv[0]);
+        return(2);
+    }
+    if (replaySession(&Recorded, Output) != 0) {
+        fprintf(stderr, "%s: replay failed\n", argv[0]);
+        return(1);
+    }
+    rewind(Output);
+    if (loadCapture(Output, &Replayed) != 0) {
+        fprintf(stderr, "%s: capture of replayed session is corrupted\n", argv[0]);
+        return(2);
+    }
+    fclose(Output);
+
+    return(compareSessions(&Recorded, &Replayed, TimeLimit));
+}
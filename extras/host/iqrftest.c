@@ -0,0 +1,849 @@
+/**
+ * @file Regression tests of IQRF programmer on host (code file fixtures in test directory)
+ *
+ * Copyright 2015-2018 IQRF Tech s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "IQRF.h"
+#include "IQRFPgm.h"
+#include "IQRFHost.h"
+#include "IQRFEmu.h"
+
+/* Functions and variables of IQRF.c without public prototype */
+uint8_t iqrfCrcCalculate(uint8_t *Buffer, uint8_t DataLength);
+bool iqrfCrcCheck(uint8_t *Buffer, uint8_t DataLength, uint8_t Ptype);
+void iqrfTrInfoProcess(uint8_t *DataBuffer, uint8_t DataSize);
+extern volatile uint8_t IqrfTrInfoReading;
+
+// maximal number of packets of one fixture
+#define TEST_MAX_PACKETS  256
+
+typedef struct {                          // registered test
+    const char *Name;
+    void (*Func)(void);
+} TEST;
+
+typedef struct {                          // code file loaded to memory
+    uint8_t *Data;
+    uint32_t Size;
+} TEST_FILE;
+
+typedef struct {                          // expected content of emulated TR module memory
+    uint16_t Flash[IQRF_EMU_FLASH_SIZE];
+    uint8_t SerialEeprom[IQRF_EMU_SERIAL_EEPROM_SIZE];
+    uint8_t Eeprom[IQRF_EMU_EEPROM_SIZE];
+} TEST_MEMORY;
+
+typedef struct {                          // programming packet copied from programmer buffers
+    uint8_t SpiCmd;
+    uint8_t Length;
+    uint8_t Data[68];
+} TEST_PACKET;
+
+/* Function prototypes */
+void testFail(const char *Format, long Value);
+TEST_FILE testLoad(const char *Name);
+uint16_t testFetch(void *Context, uint32_t Offset, const uint8_t **Chunk);
+void testSelect(TEST_FILE *File, uint8_t FileType);
+uint8_t testCheck(TEST_FILE *File, uint8_t FileType);
+uint8_t testCheckStream(TEST_FILE *File, uint8_t FileType);
+uint8_t testWrite(TEST_FILE *File, uint8_t FileType);
+uint16_t testReadPackets(TEST_PACKET *Packets);
+void testHexReference(const TEST_FILE *File, TEST_MEMORY *Memory);
+void testCompareMemory(const TEST_MEMORY *Memory);
+void testPatchHex(TEST_FILE *File, uint16_t Line, uint8_t Valid);
+void testRxHandler(uint8_t *DataBuffer, uint8_t DataSize);
+void testHex(void);
+void testPlugin(void);
+void testConfig(void);
+void testImage(void);
+void testSwapImageRecords(TEST_FILE *Image);
+void testLz(void);
+void testDelta(void);
+void testCache(void);
+void testCrc(void);
+uint8_t testSend(uint8_t *Data, uint8_t Size);
+void testFrame(void);
+void testTrInfo(void);
+
+/* Global variables */
+const TEST Tests[] = {
+    {"hex", testHex},
+    {"iqrf", testPlugin},
+    {"trcnfg", testConfig},
+    {"image", testImage},
+    {"lz", testLz},
+    {"delta", testDelta},
+    {"cache", testCache},
+    {"crc", testCrc},
+    {"frame", testFrame},
+    {"trinfo", testTrInfo},
+};
+const char *TestDir;                      // directory with fixtures
+uint8_t TestFailed;
+uint8_t TestBlockMap[IQRF_PGM_MAP_SIZE];
+TEST_MEMORY TestMemory;
+TEST_PACKET TestPackets[2][TEST_MAX_PACKETS];
+uint8_t TestRxData[64];                   // last packet received from emulated TR module
+uint8_t TestRxSize;
+uint16_t TestRxPackets;
+
+/**
+ * Report failed check of running test
+ * @param Format message, optionally with %ld for Value
+ * @param Value number detail of the message
+ */
+void testFail(const char *Format, long Value)
+{
+    printf("FAIL: ");
+    printf(Format, Value);
+    printf("\n");
+    TestFailed = true;
+}
+
+/**
+ * Load fixture to memory
+ * @param Name file name in fixture directory
+ * @return loaded file, program exits if the file cannot be read
+ */
+TEST_FILE testLoad(const char *Name)
+{
+    char Path[512];
+    TEST_FILE File = {NULL, 0};
+    FILE *Input;
+    long Size;
+
+    snprintf(Path, sizeof(Path), "%s/%s", TestDir, Name);
+    if ((Input = fopen(Path, "rb")) == NULL || fseek(Input, 0, SEEK_END) != 0 || (Size = ftell(Input)) <= 0) {
+        fprintf(stderr, "cannot read fixture %s\n", Path);
+        exit(2);
+    }
+    rewind(Input);
+    File.Data = malloc(Size);
+    if (File.Data == NULL || fread(File.Data, 1, Size, Input) != (size_t)Size) {
+        fprintf(stderr, "cannot read fixture %s\n", Path);
+        exit(2);
+    }
+    fclose(Input);
+    File.Size = (uint32_t)Size;
+    return(File);
+}
+
+/**
+ * Provide chunks of compressed fixture in small pieces (as from file stream)
+ * @param Context pointer to TEST_FILE
+ * @param Offset position of requested chunk
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+uint16_t testFetch(void *Context, uint32_t Offset, const uint8_t **Chunk)
+{
+    TEST_FILE *File = (TEST_FILE *)Context;
+
+    if (Offset >= File->Size)
+        return(0);
+    *Chunk = File->Data + Offset;
+    return(File->Size - Offset > 100 ? 100 : (uint16_t)(File->Size - Offset));
+}
+
+/**
+ * Select fixture as code file of default programmer context
+ * @param File loaded fixture
+ * @param FileType type of code file
+ */
+void testSelect(TEST_FILE *File, uint8_t FileType)
+{
+    CodeFileInfo.FileType = FileType;
+    iqrfPgmSetMemoryStream(File->Data, File->Size);
+}
+
+/**
+ * Check format of code file
+ * @param File loaded fixture
+ * @param FileType type of code file
+ * @return result of check
+ */
+uint8_t testCheck(TEST_FILE *File, uint8_t FileType)
+{
+    uint8_t Result;
+
+    testSelect(File, FileType);
+    while ((Result = iqrfPgmCheckCodeFile()) <= 100)
+        ;   /* void */
+    return(Result);
+}
+
+/**
+ * Check format of code file read in small chunks by stream function
+ * @param File loaded fixture
+ * @param FileType type of code file
+ * @return result of check
+ */
+uint8_t testCheckStream(TEST_FILE *File, uint8_t FileType)
+{
+    uint8_t Result;
+
+    CodeFileInfo.FileType = FileType;
+    CodeFileInfo.FileSize = File->Size;
+    iqrfPgmSetStream(testFetch, File);
+    while ((Result = iqrfPgmCheckCodeFile()) <= 100)
+        ;   /* void */
+    iqrfPgmSetStream(NULL, NULL);
+    return(Result);
+}
+
+/**
+ * Write code file to emulated TR module
+ * @param File loaded fixture
+ * @param FileType type of code file
+ * @return result of programming
+ */
+uint8_t testWrite(TEST_FILE *File, uint8_t FileType)
+{
+    uint8_t Result;
+
+    testSelect(File, FileType);
+    while ((Result = iqrfPgmWriteCodeFile()) <= 100)
+        iqrfHostIdle();
+    return(Result);
+}
+
+/**
+ * Read all programming packets of selected code file
+ * @param Packets array of TEST_MAX_PACKETS packets
+ * @return number of packets, 0 = format error
+ */
+uint16_t testReadPackets(TEST_PACKET *Packets)
+{
+    IQRF_PGM_PACKET Packet;
+    uint16_t Cnt = 0;
+    uint8_t Result;
+
+    iqrfPgmInitPacketReader();
+    while ((Result = iqrfPgmPreparePacket(&Packet)) == IQRF_PGM_FILE_DATA_READY && Cnt < TEST_MAX_PACKETS) {
+        Packets[Cnt].SpiCmd = Packet.SpiCmd;
+        Packets[Cnt].Length = Packet.Length;
+        memcpy(Packets[Cnt].Data, Packet.Data, Packet.Length);
+        Cnt++;
+    }
+    return(Result == IQRF_PGM_END_OF_FILE ? Cnt : 0);
+}
+
+/**
+ * Compute expected memory content of TR module from Intel HEX file (independent of the programmer)
+ * @param File loaded HEX file
+ * @param Memory expected memory content
+ */
+void testHexReference(const TEST_FILE *File, TEST_MEMORY *Memory)
+{
+    uint8_t Touched[IQRF_EMU_SERIAL_EEPROM_SIZE / 32];
+    uint8_t Record[64];
+    uint32_t HiAddress = 0;
+    uint32_t Address;
+    uint32_t Pos = 0;
+    uint8_t Size;
+    unsigned Byte;
+
+    for (uint16_t Cnt=0; Cnt<IQRF_EMU_FLASH_SIZE; Cnt++)
+        Memory->Flash[Cnt] = 0x3FFF;
+    memset(Memory->SerialEeprom, 0xFF, sizeof(Memory->SerialEeprom));
+    memset(Memory->Eeprom, 0xFF, sizeof(Memory->Eeprom));
+    memset(Touched, 0, sizeof(Touched));
+
+    while (Pos < File->Size) {
+        if (File->Data[Pos++] != ':')
+            continue;
+        for (Size=0; Pos + 1 < File->Size && File->Data[Pos] != '\r' && File->Data[Pos] != '\n' && Size < sizeof(Record); Pos += 2) {
+            sscanf((const char *)&File->Data[Pos], "%2x", &Byte);
+            Record[Size++] = (uint8_t)Byte;
+        }
+        if (Record[3] == 4)
+            HiAddress = ((uint32_t)Record[4] << 24) | ((uint32_t)Record[5] << 16);
+        if (Record[3] != 0)
+            continue;
+        for (uint8_t Cnt=0; Cnt<Record[0]; Cnt+=2) {
+            Address = (HiAddress + ((uint32_t)Record[1] << 8) + Record[2] + Cnt) / 2;
+            if (Address >= SERIAL_EEPROM_MIN_ADR && Address <= SERIAL_EEPROM_MAX_ADR) {
+                // serial EEPROM is written by whole blocks of 32 bytes, unused bytes are cleared
+                Address -= SERIAL_EEPROM_MIN_ADR;
+                if (!Touched[Address / 32]) {
+                    Touched[Address / 32] = true;
+                    memset(&Memory->SerialEeprom[Address & ~31UL], 0, 32);
+                }
+                Memory->SerialEeprom[Address] = Record[4 + Cnt];
+            } else if (Address >= PIC16LF1938_EEPROM_MIN && Address <= PIC16LF1938_EEPROM_MAX) {
+                Memory->Eeprom[Address - PIC16LF1938_EEPROM_MIN] = Record[4 + Cnt];
+            } else if (Address < IQRF_EMU_FLASH_SIZE) {
+                Memory->Flash[Address] = ((uint16_t)Record[5 + Cnt] << 8) | Record[4 + Cnt];
+            }
+        }
+    }
+}
+
+/**
+ * Compare memory of emulated TR module with expected content
+ * @param Memory expected memory content
+ */
+void testCompareMemory(const TEST_MEMORY *Memory)
+{
+    for (uint16_t Cnt=0; Cnt<IQRF_EMU_FLASH_SIZE; Cnt++) {
+        if (IqrfEmuMemory.Flash[Cnt] != Memory->Flash[Cnt]) {
+            testFail("flash word 0x%04lX differs", Cnt);
+            return;
+        }
+    }
+    for (uint16_t Cnt=0; Cnt<IQRF_EMU_SERIAL_EEPROM_SIZE; Cnt++) {
+        if (IqrfEmuMemory.SerialEeprom[Cnt] != Memory->SerialEeprom[Cnt]) {
+            testFail("serial EEPROM byte 0x%03lX differs", Cnt);
+            return;
+        }
+    }
+    for (uint16_t Cnt=0; Cnt<IQRF_EMU_EEPROM_SIZE; Cnt++) {
+        if (IqrfEmuMemory.Eeprom[Cnt] != Memory->Eeprom[Cnt]) {
+            testFail("EEPROM byte 0x%02lX differs", Cnt);
+            return;
+        }
+    }
+}
+
+/**
+ * Change first data byte of HEX file line
+ * @param File loaded HEX file
+ * @param Line index of the line
+ * @param Valid true = fix checksum of the line, false = line with wrong checksum
+ */
+void testPatchHex(TEST_FILE *File, uint16_t Line, uint8_t Valid)
+{
+    uint32_t Pos = 0;
+    uint32_t End;
+    uint8_t Sum = 0;
+    unsigned Byte;
+    char Text[3];
+
+    while (Line && Pos < File->Size) {
+        if (File->Data[Pos++] == '\n')
+            Line--;
+    }
+    // first data byte follows count, address and type
+    sscanf((const char *)&File->Data[Pos + 9], "%2x", &Byte);
+    snprintf(Text, sizeof(Text), "%02X", (Byte + 1) & 0xFF);
+    memcpy(&File->Data[Pos + 9], Text, 2);
+    if (!Valid)
+        return;
+    for (End=Pos+1; File->Data[End + 2] != '\r' && File->Data[End + 2] != '\n'; End += 2) {
+        sscanf((const char *)&File->Data[End], "%2x", &Byte);
+        Sum += Byte;
+    }
+    snprintf(Text, sizeof(Text), "%02X", (uint8_t)-Sum);
+    memcpy(&File->Data[End], Text, 2);
+}
+
+/**
+ * Receive handler of emulated TR module, last received packet is kept
+ * @param DataBuffer pointer to received data
+ * @param DataSize size of received data
+ */
+void testRxHandler(uint8_t *DataBuffer, uint8_t DataSize)
+{
+    if (DataSize > sizeof(TestRxData))
+        DataSize = sizeof(TestRxData);
+    memcpy(TestRxData, DataBuffer, DataSize);
+    TestRxSize = DataSize;
+    TestRxPackets++;
+}
+
+/**
+ * HEX file: check pass and content of flash, serial EEPROM and EEPROM written to emulated TR module
+ */
+void testHex(void)
+{
+    TEST_FILE Hex = testLoad("app.hex");
+    uint16_t HalfSent = 0;
+    uint8_t Progress = 0;
+    uint8_t Result;
+
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("check of app.hex failed", 0);
+    // progress follows written blocks, not reading of the file to block map
+    testSelect(&Hex, IQRF_PGM_HEX_FILE_TYPE);
+    while ((Result = iqrfPgmWriteCodeFile()) <= 100) {
+        if (Result < Progress)
+            testFail("progress of app.hex write decreased to %ld %%", Result);
+        if (Progress <= 50 && Result > 50)
+            HalfSent = IqrfPgmContext.Stats.PacketsSent;
+        Progress = Result;
+        iqrfHostIdle();
+    }
+    if (Result != IQRF_PGM_SUCCESS)
+        testFail("write of app.hex failed", 0);
+    if (HalfSent < IqrfPgmContext.Stats.PacketsSent / 4)
+        testFail("app.hex write progress over 50 %% after %ld packets", HalfSent);
+    testHexReference(&Hex, &TestMemory);
+    testCompareMemory(&TestMemory);
+
+    // wrong checksum of a record is found by check pass and by programming
+    testPatchHex(&Hex, 2, false);
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("corrupted app.hex passed check", 0);
+    if (testWrite(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_FORMAT_ERROR)
+        testFail("corrupted app.hex was written", 0);
+    free(Hex.Data);
+}
+
+/**
+ * Plugin file: header and comment lines are skipped, every data line is one packet
+ */
+void testPlugin(void)
+{
+    TEST_FILE Plugin = testLoad("plugin.iqrf");
+    uint32_t Hash = 0x811C9DC5UL;
+    uint16_t Lines = 0;
+    uint32_t Pos = 0;
+    unsigned Byte;
+
+    // reference: FNV-1a hash of data lines in the same way as emulated TR module
+    while (Pos < Plugin.Size) {
+        if (Plugin.Data[Pos] != '#' && Plugin.Data[Pos] != '\r') {
+            for (uint8_t Cnt=0; Cnt<20; Cnt++, Pos+=2) {
+                sscanf((const char *)&Plugin.Data[Pos], "%2x", &Byte);
+                Hash = (Hash ^ Byte) * 16777619UL;
+            }
+            Lines++;
+        }
+        while (Pos < Plugin.Size && Plugin.Data[Pos++] != '\n')
+            ;   /* void */
+    }
+
+    if (testCheck(&Plugin, IQRF_PGM_PLUGIN_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("check of plugin.iqrf failed", 0);
+    if (IqrfPgmContext.Stats.PacketsChecked != Lines)
+        testFail("plugin.iqrf: %ld packets checked", IqrfPgmContext.Stats.PacketsChecked);
+    if (testWrite(&Plugin, IQRF_PGM_PLUGIN_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("write of plugin.iqrf failed", 0);
+    if (IqrfEmuStats.PluginPackets != Lines || IqrfEmuMemory.PluginHash != Hash)
+        testFail("plugin.iqrf: %ld plugin packets written, content differs", IqrfEmuStats.PluginPackets);
+    free(Plugin.Data);
+}
+
+/**
+ * Configuration file: 32 bytes of configuration block in flash and RFPGM byte in EEPROM
+ */
+void testConfig(void)
+{
+    TEST_FILE Config = testLoad("config.trcnfg");
+
+    for (uint16_t Cnt=0; Cnt<IQRF_EMU_FLASH_SIZE; Cnt++)
+        TestMemory.Flash[Cnt] = 0x3FFF;
+    memset(TestMemory.SerialEeprom, 0xFF, sizeof(TestMemory.SerialEeprom));
+    memset(TestMemory.Eeprom, 0xFF, sizeof(TestMemory.Eeprom));
+    for (uint8_t Cnt=0; Cnt<32; Cnt++)
+        TestMemory.Flash[IQRF_CONFIG_MEM_L_ADR + Cnt] = 0x3400 | Config.Data[Cnt];
+    TestMemory.Eeprom[RFPGM_CFG_ADR] = Config.Data[32];
+
+    if (testCheck(&Config, IQRF_PGM_CFG_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("check of config.trcnfg failed", 0);
+    if (testWrite(&Config, IQRF_PGM_CFG_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("write of config.trcnfg failed", 0);
+    testCompareMemory(&TestMemory);
+
+    // configuration file must contain configuration block and RFPGM byte
+    Config.Size = 32;
+    if (testWrite(&Config, IQRF_PGM_CFG_FILE_TYPE) != IQRF_PGM_FORMAT_ERROR)
+        testFail("short config.trcnfg was written", 0);
+    free(Config.Data);
+}
+
+/**
+ * Block image: packets stored in app.img are the same as packets prepared from app.hex, damaged image is rejected
+ */
+void testImage(void)
+{
+    TEST_FILE Hex = testLoad("app.hex");
+    TEST_FILE Image = testLoad("app.img");
+    uint16_t HexPackets, ImagePackets;
+
+    testSelect(&Hex, IQRF_PGM_HEX_FILE_TYPE);
+    HexPackets = testReadPackets(TestPackets[0]);
+    testSelect(&Image, IQRF_PGM_IMAGE_FILE_TYPE);
+    ImagePackets = testReadPackets(TestPackets[1]);
+    if (HexPackets == 0 || HexPackets != ImagePackets)
+        testFail("app.img: %ld packets differ from app.hex", ImagePackets);
+    for (uint16_t Cnt=0; Cnt<HexPackets && Cnt<ImagePackets; Cnt++) {
+        if (memcmp(&TestPackets[0][Cnt], &TestPackets[1][Cnt], 2 + TestPackets[0][Cnt].Length) != 0) {
+            testFail("app.img: packet %ld differs", Cnt);
+            break;
+        }
+    }
+
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("check of app.img failed", 0);
+
+    // wrong checksum of the last record is found
+    Image.Data[Image.Size - IQRF_PGM_IMAGE_TRAILER_SIZE - 1] ^= 0x01;
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("corrupted app.img passed check", 0);
+    Image.Data[Image.Size - IQRF_PGM_IMAGE_TRAILER_SIZE - 1] ^= 0x01;
+
+    // records are valid, but image is incomplete or their order is changed
+    Image.Size -= IQRF_PGM_IMAGE_TRAILER_SIZE;
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("app.img without trailer passed check", 0);
+    Image.Size -= 1;
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("truncated app.img passed check", 0);
+    Image.Size += 1 + IQRF_PGM_IMAGE_TRAILER_SIZE;
+    testSwapImageRecords(&Image);
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("app.img with reordered records passed check", 0);
+    testSwapImageRecords(&Image);
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("check of restored app.img failed", 0);
+
+    // image of version 1 has no trailer
+    Image.Data[4] = 1;
+    if (testCheck(&Image, IQRF_PGM_IMAGE_FILE_TYPE) != IQRF_PGM_ERROR)
+        testFail("app.img of version 1 passed check", 0);
+    free(Hex.Data);
+    free(Image.Data);
+}
+
+/**
+ * Swap the first two records of block image (both must be flash packets of the same size)
+ * @param Image loaded image
+ */
+void testSwapImageRecords(TEST_FILE *Image)
+{
+    uint8_t Record[2 + 64 + 1];
+    uint8_t *First = &Image->Data[IQRF_PGM_IMAGE_HEADER_SIZE];
+    uint16_t Size = 2 + First[1] + 1;
+    uint8_t *Second = First + Size;
+
+    if (First[0] != SPI_FLASH_PGM || Second[0] != SPI_FLASH_PGM || Second[1] != First[1]) {
+        testFail("first records of app.img are not flash packets", 0);
+        return;
+    }
+    memcpy(Record, First, Size);
+    memcpy(First, Second, Size);
+    memcpy(Second, Record, Size);
+}
+
+/**
+ * Compressed file: decompressed app.hlz is byte to byte the same as app.hex
+ */
+void testLz(void)
+{
+    static IQRF_PGM_LZ_STREAM Stream;
+    TEST_FILE Hex = testLoad("app.hex");
+    TEST_FILE Compressed = testLoad("app.hlz");
+    const uint8_t *Chunk;
+    uint32_t Offset = 0;
+    uint16_t Size;
+    uint8_t Result;
+
+    if (!iqrfPgmSetCompressedStream(&Stream, testFetch, &Compressed))
+        testFail("app.hlz header is not accepted", 0);
+    if (CodeFileInfo.FileType != IQRF_PGM_HEX_FILE_TYPE || CodeFileInfo.FileSize != Hex.Size)
+        testFail("app.hlz: wrong type or size %ld", CodeFileInfo.FileSize);
+    while ((Size = IqrfPgmContext.StreamFetch(IqrfPgmContext.StreamContext, Offset, &Chunk)) != 0) {
+        if (Offset + Size > Hex.Size || memcmp(Chunk, &Hex.Data[Offset], Size) != 0) {
+            testFail("app.hlz: content differs at offset %ld", Offset);
+            break;
+        }
+        Offset += Size;
+    }
+    if (Offset != Hex.Size)
+        testFail("app.hlz: %ld bytes decompressed", Offset);
+    // compressed file is read again from the beginning by check pass
+    while ((Result = iqrfPgmCheckCodeFile()) <= 100)
+        ;   /* void */
+    if (Result != IQRF_PGM_SUCCESS)
+        testFail("check of app.hlz failed", 0);
+
+    // file of other format is refused
+    Compressed.Data[4]++;
+    if (iqrfPgmSetCompressedStream(&Stream, testFetch, &Compressed))
+        testFail("app.hlz of other version is accepted", 0);
+    iqrfPgmSetStream(NULL, NULL);
+    free(Hex.Data);
+    free(Compressed.Data);
+}
+
+/**
+ * Delta programming: unchanged blocks are skipped, changed block is written again
+ */
+void testDelta(void)
+{
+    TEST_FILE Hex = testLoad("app.hex");
+    uint16_t Written;
+
+    iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_FORCE);
+    if (testWrite(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("write of app.hex failed", 0);
+    Written = IqrfPgmContext.Stats.PacketsSent;
+
+    iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_ON);
+    if (testWrite(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("delta write of app.hex failed", 0);
+    // only EEPROM packets are not tracked
+    if (IqrfPgmContext.Stats.PacketsSkipped == 0
+        || IqrfPgmContext.Stats.PacketsSent + IqrfPgmContext.Stats.PacketsSkipped != Written)
+    {
+        testFail("unchanged app.hex: %ld packets sent", IqrfPgmContext.Stats.PacketsSent);
+    }
+    Written = IqrfPgmContext.Stats.PacketsSent;
+
+    // first flash record after extended address record
+    testPatchHex(&Hex, 1, true);
+    if (testWrite(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS)
+        testFail("delta write of changed app.hex failed", 0);
+    if (IqrfPgmContext.Stats.PacketsSent != Written + 1)
+        testFail("changed app.hex: %ld packets sent", IqrfPgmContext.Stats.PacketsSent);
+    testHexReference(&Hex, &TestMemory);
+    testCompareMemory(&TestMemory);
+    iqrfPgmSetDeltaMode(IQRF_PGM_DELTA_OFF);
+    free(Hex.Data);
+}
+
+/**
+ * Validated-image cache: checked file is not parsed again, changed file is
+ */
+void testCache(void)
+{
+    TEST_FILE Hex = testLoad("app.hex");
+    uint16_t Packets;
+
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || IqrfPgmContext.Stats.CheckCached)
+        testFail("first check of app.hex failed or cached", 0);
+    Packets = IqrfPgmContext.Stats.PacketsChecked;
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || !IqrfPgmContext.Stats.CheckCached)
+        testFail("second check of app.hex failed or not cached", 0);
+    if (IqrfPgmContext.Stats.PacketsChecked != Packets)
+        testFail("cached check of app.hex: %ld packets", IqrfPgmContext.Stats.PacketsChecked);
+
+    testPatchHex(&Hex, 1, true);
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || IqrfPgmContext.Stats.CheckCached)
+        testFail("check of changed app.hex failed or cached", 0);
+
+    // streamed file is looked up by size and first chunk, it is hashed by check pass
+    testPatchHex(&Hex, 1, true);
+    if (testCheckStream(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || IqrfPgmContext.Stats.CheckCached)
+        testFail("streamed check of app.hex failed or cached", 0);
+    if (testCheckStream(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || !IqrfPgmContext.Stats.CheckCached)
+        testFail("second streamed check of app.hex failed or not cached", 0);
+    if (IqrfPgmContext.Stats.PacketsChecked != Packets)
+        testFail("cached streamed check of app.hex: %ld packets", IqrfPgmContext.Stats.PacketsChecked);
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || !IqrfPgmContext.Stats.CheckCached)
+        testFail("result of streamed check of app.hex is not cached", 0);
+    iqrfPgmSetCacheMode(IQRF_PGM_CACHE_ALWAYS);
+    if (testCheckStream(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || !IqrfPgmContext.Stats.CheckCached)
+        testFail("streamed check of app.hex is not cached with IQRF_PGM_CACHE_ALWAYS", 0);
+    iqrfPgmSetCacheMode(IQRF_PGM_CACHE_MEMORY);
+    testPatchHex(&Hex, 1, true);
+    if (testCheckStream(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_SUCCESS || IqrfPgmContext.Stats.CheckCached)
+        testFail("streamed check of changed app.hex failed or cached", 0);
+
+    // result of wrong file is cached too
+    testPatchHex(&Hex, 2, false);
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_ERROR || IqrfPgmContext.Stats.CheckCached)
+        testFail("first check of corrupted app.hex passed or cached", 0);
+    if (testCheck(&Hex, IQRF_PGM_HEX_FILE_TYPE) != IQRF_PGM_ERROR || !IqrfPgmContext.Stats.CheckCached)
+        testFail("second check of corrupted app.hex passed or not cached", 0);
+    free(Hex.Data);
+}
+
+/**
+ * SPI packet CRC: known vectors of master packet CRC (CRCM) and check of TR module CRC (CRCS)
+ */
+void testCrc(void)
+{
+    uint8_t Packet[68] = {SPI_WR_RD, 0x80 | 3, 'a', 'b', 'c'};
+    uint8_t Slave[6] = {0x00, 0x03, 0x10, 0x20, 0x30, 0x5C};
+
+    if (iqrfCrcCalculate(Packet, 3) != 0x4C)
+        testFail("CRCM of 3 B packet: 0x%02lX", iqrfCrcCalculate(Packet, 3));
+    Packet[1] = 0x80 | 64;
+    for (uint8_t Cnt=0; Cnt<64; Cnt++)
+        Packet[Cnt + 2] = Cnt * 37;
+    if (iqrfCrcCalculate(Packet, 64) != 0x6F)
+        testFail("CRCM of 64 B packet: 0x%02lX", iqrfCrcCalculate(Packet, 64));
+
+    // CRCS covers PTYPE and data, command byte is not included
+    if (!iqrfCrcCheck(Slave, 3, Slave[1]))
+        testFail("valid CRCS rejected", 0);
+    Slave[0] = SPI_WR_RD;
+    if (!iqrfCrcCheck(Slave, 3, Slave[1]))
+        testFail("CRCS depends on command byte", 0);
+    if (iqrfCrcCheck(Slave, 3, 0x83))
+        testFail("CRCS of other PTYPE accepted", 0);
+    Slave[3] ^= 0x01;
+    if (iqrfCrcCheck(Slave, 3, Slave[1]))
+        testFail("CRCS of changed data accepted", 0);
+    Slave[3] ^= 0x01;
+    Slave[5] ^= 0x80;
+    if (iqrfCrcCheck(Slave, 3, Slave[1]))
+        testFail("wrong CRCS accepted", 0);
+}
+
+/**
+ * Send data to emulated TR module in communication mode
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return result of iqrfSendData() (IQRF_OPERATION_IN_PROGRESS = timeout)
+ */
+uint8_t testSend(uint8_t *Data, uint8_t Size)
+{
+    uint32_t Start = iqrfGetSysTick();
+    uint8_t Result;
+
+    // broken framing must fail the test, not hang it
+    while ((Result = iqrfSendData(Data, Size)) == IQRF_OPERATION_IN_PROGRESS && iqrfGetSysTick() - Start < 10 * TICKS_IN_SECOND)
+        iqrfHostIdle();
+    return(Result);
+}
+
+/**
+ * SPI framing: packets written to and read from emulated TR module, rejected CRCM
+ */
+void testFrame(void)
+{
+    const uint8_t Sizes[] = {1, 17, 64};
+    const T_IQRF_EMU_FAULTS CrcFaults = {1, 1000, 0, 0, 0, 0, 0, 0};
+    uint8_t Data[64];
+    uint16_t Packets;
+
+    for (uint8_t Cnt=0; Cnt<sizeof(Data); Cnt++)
+        Data[Cnt] = 0xC3 ^ (Cnt * 11);
+    for (uint8_t Cnt=0; Cnt<sizeof(Sizes); Cnt++) {
+        // master packet, emulated TR module checks its CRCM
+        if (testSend(Data, Sizes[Cnt]) != IQRF_OPERATION_OK || IqrfEmuStats.CrcErrors)
+            testFail("write of %ld B packet failed", Sizes[Cnt]);
+        // packet of TR module, driver checks its CRCS
+        Packets = TestRxPackets;
+        if (!iqrfEmuPutComData(Data, Sizes[Cnt]))
+            testFail("emulated TR module refused %ld B packet", Sizes[Cnt]);
+        for (uint16_t Time=0; Time<1000 && TestRxPackets == Packets; Time++)
+            iqrfHostIdle();
+        if (TestRxPackets != Packets + 1 || TestRxSize != Sizes[Cnt] || memcmp(TestRxData, Data, Sizes[Cnt]) != 0)
+            testFail("read of %ld B packet failed", Sizes[Cnt]);
+    }
+    if (testSend(Data, 0) != IQRF_WRONG_DATA_SIZE || testSend(Data, 65) != IQRF_WRONG_DATA_SIZE)
+        testFail("packet of wrong size accepted", 0);
+
+    // every packet is corrupted on MOSI, TR module rejects it by SPI_CRCM_ERR
+    iqrfEmuSetFaults(&CrcFaults);
+    if (testSend(Data, 8) == IQRF_OPERATION_OK || IqrfEmuStats.CrcErrors == 0)
+        testFail("corrupted packet accepted", 0);
+    iqrfEmuSetFaults(NULL);
+    if (testSend(Data, 8) != IQRF_OPERATION_OK)
+        testFail("write after rejected packet failed", 0);
+}
+
+/**
+ * TR module info: identification read from emulated TR module by iqrfInit() and decoding of known blocks
+ */
+void testTrInfo(void)
+{
+    uint8_t Basic[8] = {0x81, 0x00, 0xA7, 0x2D, 0x43, (TR_72D << 4) | 0x08 | PIC16LF1938, 0xD7, 0x08};
+    uint8_t Extended[32];
+
+    // default emulated module: TR-72D, PIC16LF1938, OS 4.03 build 0x08D7
+    if (iqrfGetModuleId() != 0x8100A72DUL || iqrfGetOsVersion() != 0x0403 || iqrfGetOsBuild() != 0x08D7
+        || iqrfGetMcuType() != PIC16LF1938 || iqrfGetModuleType() != TR_72D || iqrfGetFccStatus() != 0)
+    {
+        testFail("info of emulated TR module decoded wrong", 0);
+    }
+    if (iqrfGetModuleIbk(0) != (0x81 ^ 0xA5) || iqrfGetModuleIbk(15) != (0x2D ^ (0xA5 + 15)))
+        testFail("IBK of emulated TR module decoded wrong", 0);
+
+    // OS 4.03 and newer has extended info
+    IqrfTrInfoReading = 4;
+    iqrfTrInfoProcess(Basic, sizeof(Basic));
+    if (iqrfGetModuleId() != 0x8100A72DUL || iqrfGetOsVersion() != 0x0403 || iqrfGetOsBuild() != 0x08D7
+        || iqrfGetMcuType() != PIC16LF1938 || iqrfGetModuleType() != TR_72D || iqrfGetFccStatus() != 1)
+    {
+        testFail("basic info decoded wrong", 0);
+    }
+    if (memcmp(IqrfTrInfoStruct.ModuleInfoRawData, Basic, sizeof(Basic)) != 0)
+        testFail("raw data of basic info not kept", 0);
+    if (IqrfTrInfoReading != 2)
+        testFail("extended info of OS 4.03 not requested (state %ld)", IqrfTrInfoReading);
+    for (uint8_t Cnt=0; Cnt<sizeof(Extended); Cnt++)
+        Extended[Cnt] = Cnt;
+    IqrfTrInfoReading = 3;
+    iqrfTrInfoProcess(Extended, sizeof(Extended));
+    if (IqrfTrInfoReading != 1 || memcmp(IqrfTrInfoStruct.Ibk, &Extended[16], 16) != 0)
+        testFail("IBK of extended info decoded wrong", 0);
+
+    // OS 3.08 has no extended info
+    Basic[4] = 0x38;
+    IqrfTrInfoReading = 4;
+    iqrfTrInfoProcess(Basic, sizeof(Basic));
+    if (iqrfGetOsVersion() != 0x0308 || IqrfTrInfoReading != 1)
+        testFail("basic info of OS 3.08 decoded wrong", 0);
+    IqrfTrInfoReading = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    char StorageDir[] = "/tmp/iqrftestXXXXXX";
+    char Path[sizeof(StorageDir) + 256];
+    struct dirent *Entry;
+    const TEST *Test = NULL;
+    DIR *Dir;
+
+    for (uint8_t Cnt=0; argc == 3 && Cnt<sizeof(Tests)/sizeof(TEST); Cnt++) {
+        if (strcmp(argv[1], Tests[Cnt].Name) == 0)
+            Test = &Tests[Cnt];
+    }
+    if (Test == NULL) {
+        fprintf(stderr, "usage: %s <test> <fixture directory>\n", argv[0]);
+        return(2);
+    }
+    TestDir = argv[2];
+
+    // delta manifests, checkpoints and cache of every test start empty
+    if (mkdtemp(StorageDir) == NULL) {
+        fprintf(stderr, "cannot create storage directory\n");
+        return(2);
+    }
+    iqrfHostSetStorageDir(StorageDir);
+    iqrfHostSetVirtualTime(true);
+    iqrfEmuInit(NULL);
+    iqrfHostAttachSlave(&IqrfEmuSlave);
+    iqrfInit(testRxHandler);
+    iqrfPgmSetBlockMap(TestBlockMap);
+
+    Test->Func();
+    printf("%s: %s\n", Test->Name, TestFailed ? "FAILED" : "OK");
+
+    iqrfHostSetStorageDir(NULL);
+    if ((Dir = opendir(StorageDir)) != NULL) {
+        while ((Entry = readdir(Dir)) != NULL) {
+            snprintf(Path, sizeof(Path), "%s/%s", StorageDir, Entry->d_name);
+            if (Entry->d_name[0] != '.')
+                remove(Path);
+        }
+        closedir(Dir);
+    }
+    rmdir(StorageDir);
+    return(TestFailed ? 1 : 0);
+}
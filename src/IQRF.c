@@ -19,8 +19,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <Arduino.h>
-#include <ctype.h>
+#include <string.h>
 #include "IQRF.h"
 
 #define IQRF_PKT_SIZE             68
@@ -36,12 +35,15 @@ typedef struct { // SPI interface control structure
     uint8_t PacketLen;
     uint8_t PacketCnt;
     uint8_t PacketRpt;
+    uint8_t UserPacket;
+    uint8_t ModuleBufferFull;
     uint8_t PacketTxBuffer[IQRF_PKT_SIZE];
     uint8_t PacketRxBuffer[IQRF_PKT_SIZE];
 } T_IQRF_SPI_CONTROL;
 
 typedef struct {
     uint8_t BufferFlag;
+    uint8_t Result;
     uint8_t SpiCmd;
     uint8_t *DataBuffer;
     uint8_t DataLength;
@@ -70,6 +72,7 @@ void iqrfTrInfoProcess(uint8_t *DataBuffer, uint8_t DataSize);
 T_IQRF_SPI_CONTROL IqrfSpiControl;
 volatile T_IQRF_PACKET IqrfPacket;
 T_TR_INFO_STRUCT	IqrfTrInfoStruct;
+T_IQRF_READY_HANDLER IqrfReadyHandler;
 
 volatile uint8_t IqrfDataSenderSM = IQRF_SM_PREPARE_REQUEST;
 volatile uint8_t IqrfTrInfoReading;
@@ -86,6 +89,7 @@ void iqrfInit(T_IQRF_RX_HANDLER UserIqrfRxHandler)
     IqrfControl.TimeCnt = SPI_STATUS_POOLING_TIME;
     IqrfControl.IqrfRxHandler = iqrfTrInfoProcess;
     IqrfSpiControl.SpiStat = SPI_DISABLED;
+    IqrfSpiControl.ModuleBufferFull = false;
 
     iqrfTrPowerOn();                                     // turn power on for TR module
 
@@ -93,8 +97,10 @@ void iqrfInit(T_IQRF_RX_HANDLER UserIqrfRxHandler)
 
     // read TR module info
     IqrfTrInfoReading = 4;
-    while(IqrfTrInfoReading)
+    while(IqrfTrInfoReading) {
         iqrfTrInfoTask();
+        iqrfPollDriver();
+    }
 
     // if connected TR module supports fast SPI mode
     if (iqrfGetModuleType() == TR_72D || iqrfGetModuleType() == TR_76D)
@@ -137,6 +143,8 @@ uint8_t iqrfSendData(uint8_t *DataBuffer, uint8_t DataLength)
     case IQRF_SM_PREPARE_REQUEST:
         if (IqrfSpiControl.SpiStat == SPI_DATA_TRANSFER)
             return (IQRF_OPERATION_IN_PROGRESS);
+        if (IqrfSpiControl.SpiStat == SPI_CRCM_OK || IqrfSpiControl.SpiStat == SPI_CRCM_ERR)
+            return(IQRF_TR_MODULE_BUSY);
         if (IqrfSpiControl.SpiStat != COMMUNICATION_MODE)
             return(IQRF_TR_MODULE_NOT_READY);
         if (DataLength == 0 || DataLength > 64)
@@ -187,9 +195,90 @@ void iqrfSendPacket(uint8_t SpiCmd, uint8_t *UserDataBuffer, uint8_t UserDataLen
     IqrfPacket.SpiCmd = SpiCmd;
     IqrfPacket.DataBuffer = UserDataBuffer;
     IqrfPacket.DataLength = UserDataLength;
+    IqrfPacket.Result = IQRF_PACKET_PENDING;
     IqrfPacket.BufferFlag = IQRF_BUFFER_BUSY;
 }
 
+/**
+ * Cancel IQRF packet, which has not been sent to TR module yet
+ * @note Packet being clocked out over SPI is completed first
+ */
+void iqrfCancelPacket(void)
+{
+    iqrfSuspendDriver();
+    if (IqrfPacket.BufferFlag == IQRF_BUFFER_BUSY)
+        IqrfPacket.Result = IQRF_PACKET_ERR;
+    IqrfPacket.BufferFlag = IQRF_BUFFER_FREE;
+    iqrfRunDriver();
+}
+
+/**
+ * Set user call back function, called when TR module is able to accept next packet
+ * @param UserIqrfReadyHandler Pointer to user call back function (NULL = disabled)
+ * @note The function is called from IQRF driver (timer interrupt context)
+ */
+void iqrfSetReadyHandler(T_IQRF_READY_HANDLER UserIqrfReadyHandler)
+{
+    IqrfReadyHandler = UserIqrfReadyHandler;
+}
+
+/**
+ * Get number of packets, which can be sent to TR module right now
+ * @return 0 = TR module or library TX buffer is busy, 1 = packet can be sent
+ */
+uint8_t iqrfGetTxCredits(void)
+{
+    // TR module has only one COM buffer, so only one packet can be accepted
+    if (IqrfSpiControl.SpiStat == COMMUNICATION_MODE
+        && IqrfPacket.BufferFlag == IQRF_BUFFER_FREE
+        && IqrfDataSenderSM == IQRF_SM_PREPARE_REQUEST)
+    {
+        return(1);
+    }
+    return(0);
+}
+
+/**
+ * Initialize token bucket rate limiter
+ * @param Bucket Pointer to token bucket structure
+ * @param Rate Number of packets per second
+ * @param Burst Maximal number of packets sent back to back
+ */
+void iqrfTokenBucketInit(T_IQRF_TOKEN_BUCKET *Bucket, uint16_t Rate, uint16_t Burst)
+{
+    Bucket->Rate = Rate ? Rate : 1;
+    Bucket->Burst = Burst ? Burst : 1;
+    // bucket is full after initialization
+    Bucket->Credit = (uint32_t)Bucket->Burst * TICKS_IN_SECOND;
+    Bucket->LastTick = iqrfGetSysTick();
+}
+
+/**
+ * Take one token from token bucket
+ * @param Bucket Pointer to token bucket structure
+ * @return true = token taken, packet can be sent, false = rate limit reached
+ */
+bool iqrfTokenBucketTake(T_IQRF_TOKEN_BUCKET *Bucket)
+{
+    uint32_t MaxCredit = (uint32_t)Bucket->Burst * TICKS_IN_SECOND;
+    uint32_t SysTickTime = iqrfGetSysTick();
+    uint32_t Elapsed = SysTickTime - Bucket->LastTick;
+
+    Bucket->LastTick = SysTickTime;
+    // refill the bucket, one token per TICKS_IN_SECOND / Rate ticks
+    if (Elapsed > MaxCredit / Bucket->Rate)
+        Bucket->Credit = MaxCredit;
+    else
+        Bucket->Credit += Elapsed * Bucket->Rate;
+    if (Bucket->Credit > MaxCredit)
+        Bucket->Credit = MaxCredit;
+
+    if (Bucket->Credit < TICKS_IN_SECOND)
+        return(false);
+    Bucket->Credit -= TICKS_IN_SECOND;
+    return(true);
+}
+
 /**
  * Temporary suspend IQRF communication driver
  */
@@ -197,7 +286,7 @@ void iqrfSuspendDriver(void)
 {
     // wait until library is ready
     while (IqrfControl.Status == IQRF_READ || IqrfControl.Status == IQRF_WRITE)
-        ; /* void */
+        iqrfPollDriver();
     // set driver suspend flag
     IqrfControl.SuspendFlag = true;
     // set SPI status
@@ -266,6 +355,16 @@ uint8_t iqrfGetTxBufferStatus(void)
 }
 
 
+/**
+ * get result of the last packet sent by iqrfSendPacket()
+ * @return IQRF_PACKET_PENDING, IQRF_PACKET_OK or IQRF_PACKET_ERR (all attempts failed)
+ */
+uint8_t iqrfGetPacketResult(void)
+{
+    return(IqrfPacket.Result);
+}
+
+
 /**
  * Function implements IQRF packet communication over SPI with TR module
  */
@@ -285,6 +384,8 @@ void iqrfSpiDriver(void)
                     IqrfControl.IqrfRxHandler(&IqrfSpiControl.PacketRxBuffer[2], IqrfSpiControl.DLEN);
                 if (IqrfControl.Status==IQRF_WRITE && IqrfDataSenderSM==IQRF_SM_PROCESS_REQUEST)
                     IqrfDataSenderSM = IQRF_SM_REQUEST_OK;
+                if (IqrfSpiControl.UserPacket)
+                    IqrfPacket.Result = IQRF_PACKET_OK;
                 IqrfControl.Status = IQRF_READY;
             } else {
                 if (--IqrfSpiControl.PacketRpt) {
@@ -292,6 +393,8 @@ void iqrfSpiDriver(void)
                 } else {
                     if (IqrfControl.Status == IQRF_WRITE && IqrfDataSenderSM == IQRF_SM_PROCESS_REQUEST)
                         IqrfDataSenderSM = IQRF_SM_REQUEST_ERR;
+                    if (IqrfSpiControl.UserPacket)
+                        IqrfPacket.Result = IQRF_PACKET_ERR;
                     IqrfControl.Status = IQRF_READY;
                 }
             }
@@ -301,6 +404,16 @@ void iqrfSpiDriver(void)
         IqrfSpiControl.SpiStat = iqrfSendSpiByte(SPI_CHECK);
         iqrfDeselectTRmodule();
 
+        // track state of TR module COM buffer
+        if (IqrfSpiControl.SpiStat == SPI_CRCM_OK || IqrfSpiControl.SpiStat == SPI_CRCM_ERR) {
+            IqrfSpiControl.ModuleBufferFull = true;
+        } else if (IqrfSpiControl.SpiStat == COMMUNICATION_MODE && IqrfSpiControl.ModuleBufferFull) {
+            // TR module buffer has been released, signal it to the user
+            IqrfSpiControl.ModuleBufferFull = false;
+            if (IqrfReadyHandler)
+                IqrfReadyHandler();
+        }
+
         // if the status is data ready, prepare packet to read it
         if ((IqrfSpiControl.SpiStat & 0xC0) == 0x40) {
             // clear TX buffer
@@ -323,6 +436,8 @@ void iqrfSpiDriver(void)
             IqrfSpiControl.PacketCnt = 0;
             // number of attempts to send data
             IqrfSpiControl.PacketRpt = 1;
+            // packet is not requested by the user
+            IqrfSpiControl.UserPacket = false;
             // current SPI status must be updated
             IqrfSpiControl.SpiStat = SPI_DATA_TRANSFER;
             // reading from buffer COM of TR module
@@ -359,6 +474,8 @@ void iqrfSpiDriver(void)
             IqrfSpiControl.PacketCnt = 0;
             // number of attempts to send data
             IqrfSpiControl.PacketRpt = 3;
+            // result of the packet will be reported by iqrfGetPacketResult()
+            IqrfSpiControl.UserPacket = true;
             // current SPI status must be updated
             IqrfSpiControl.SpiStat = SPI_DATA_TRANSFER;
 
@@ -483,8 +600,11 @@ void iqrfTrInfoTask(void)
     // the task is finished
     case DONE:
         // if no packet is pending to send to TR module
-        if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE && iqrfGetLibraryStatus() == IQRF_READY)
+        if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE && iqrfGetLibraryStatus() == IQRF_READY) {
             IqrfTrInfoReading = 0;
+            // next iqrfInit() reads the info again
+            TrInfoTaskSM = INIT_TASK;
+        }
         break;
     }
 }
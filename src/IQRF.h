@@ -37,6 +37,7 @@ extern "C" {
 #define IQRF_TR_MODULE_WRITE_ERR      2
 #define IQRF_TR_MODULE_NOT_READY      3
 #define IQRF_WRONG_DATA_SIZE          4
+#define IQRF_TR_MODULE_BUSY           5     // TR module buffer is full, retry later
 
 // MCU type of TR module
 #define MCU_UNKNOWN                   0
@@ -98,6 +99,13 @@ extern "C" {
 #define IQRF_BUFFER_FREE            0x00  // buffer is ready for new packet
 #define IQRF_BUFFER_BUSY            0x01  // buffer is busy
 
+//******************************************************************************
+//		 	result of the last packet sent by iqrfSendPacket()
+//******************************************************************************
+#define IQRF_PACKET_PENDING         0x00  // packet has not been written yet
+#define IQRF_PACKET_OK              0x01  // packet has been accepted by TR module
+#define IQRF_PACKET_ERR             0x02  // packet has been rejected or cancelled
+
 typedef struct{                           // TR module info structure
     uint16_t    OsVersion;
     uint16_t    OsBuild;
@@ -109,6 +117,15 @@ typedef struct{                           // TR module info structure
     uint8_t     ModuleInfoRawData[8];
 } T_TR_INFO_STRUCT;
 
+typedef struct{                           // producer side token bucket rate limiter
+    uint16_t    Rate;                     // tokens per second
+    uint16_t    Burst;                    // maximal number of stored tokens
+    uint32_t    Credit;                   // stored tokens in 1/TICKS_IN_SECOND units
+    uint32_t    LastTick;                 // SysTick of the last refill
+} T_IQRF_TOKEN_BUCKET;
+
+typedef void (*T_IQRF_READY_HANDLER)(void);
+
 extern T_TR_INFO_STRUCT	  IqrfTrInfoStruct;
 
 /**
@@ -133,6 +150,40 @@ uint8_t iqrfSendData(uint8_t *DataBuffer, uint8_t DataLength);
  */
 void iqrfSendPacket(uint8_t SpiCmd, uint8_t *UserDataBuffer, uint8_t UserDataLength);
 
+/**
+ * Cancel IQRF packet, which has not been sent to TR module yet
+ * @note Packet being clocked out over SPI is completed first
+ */
+void iqrfCancelPacket(void);
+
+/**
+ * Set user call back function, called when TR module is able to accept next packet
+ * @param UserIqrfReadyHandler Pointer to user call back function (NULL = disabled)
+ * @note The function is called from IQRF driver (timer interrupt context)
+ */
+void iqrfSetReadyHandler(T_IQRF_READY_HANDLER UserIqrfReadyHandler);
+
+/**
+ * Get number of packets, which can be sent to TR module right now
+ * @return 0 = TR module or library TX buffer is busy, 1 = packet can be sent
+ */
+uint8_t iqrfGetTxCredits(void);
+
+/**
+ * Initialize token bucket rate limiter
+ * @param Bucket Pointer to token bucket structure
+ * @param Rate Number of packets per second
+ * @param Burst Maximal number of packets sent back to back
+ */
+void iqrfTokenBucketInit(T_IQRF_TOKEN_BUCKET *Bucket, uint16_t Rate, uint16_t Burst);
+
+/**
+ * Take one token from token bucket
+ * @param Bucket Pointer to token bucket structure
+ * @return true = token taken, packet can be sent, false = rate limit reached
+ */
+bool iqrfTokenBucketTake(T_IQRF_TOKEN_BUCKET *Bucket);
+
 /**
  * Temporary suspend IQRF communication driver
  */
@@ -171,6 +222,12 @@ uint8_t iqrfGetLibraryStatus(void);
  */
 uint8_t iqrfGetTxBufferStatus(void);
 
+/**
+ * get result of the last packet sent by iqrfSendPacket()
+ * @return IQRF_PACKET_PENDING, IQRF_PACKET_OK or IQRF_PACKET_ERR (all attempts failed)
+ */
+uint8_t iqrfGetPacketResult(void);
+
 /**
  * Macro: return TR module OS version
  */
@@ -20,248 +20,1287 @@
  * limitations under the License.
  */
 
-#include <Arduino.h>
-#include <ctype.h>
+#include <string.h>
 #include "IQRF.h"
 #include "IQRFPgm.h"
 
-#define SIZE_OF_CODE_LINE_BUFFER  32
+// delta manifest (hash of every 16 word half of flash block and every serial EEPROM block)
+#define IQRF_PGM_DELTA_LICENCED_SLOT  0
+#define IQRF_PGM_DELTA_MAIN_SLOT      (IQRF_LICENCED_MEMORY_BLOCKS * 2)
+#define IQRF_PGM_DELTA_EEPROM_SLOT    (IQRF_PGM_DELTA_MAIN_SLOT + IQRF_MAIN_MEMORY_BLOCKS * 2)
+#define IQRF_PGM_DELTA_EEPROM_BLOCKS  ((SERIAL_EEPROM_MAX_ADR - SERIAL_EEPROM_MIN_ADR + 1) / 32)
+#define IQRF_PGM_DELTA_NO_SLOT        0xFFFF
 
-typedef struct {
-    uint32_t  HiAddress;
-    uint16_t  Address;
-    uint16_t  MemoryBlockNumber;
-    uint8_t MemoryBlockProcessState;
-    uint8_t DataInBufferReady;
-    uint8_t DataOverflow;
-    uint8_t MemoryBlock[68];
-} PREPARE_MEM_BLOCK;
+// block map (see IQRF_PGM_BLOCK_MAP)
+#define IQRF_PGM_MAP_LICENCED_BLOCK   (IQRF_LICENCED_MEM_MIN_ADR / 32)
+#define IQRF_PGM_MAP_MAIN_BLOCK       (IQRF_MAIN_MEM_MIN_ADR / 32)
+#define IQRF_PGM_MAP_NO_BLOCK         0xFF
+
+// validated-image cache (see IQRF_PGM_CACHE_ENTRY)
+#define IQRF_PGM_CACHE_NAME           "PGMCACHE.DAT"
+
+#if defined(__AVR__)
+#define IQRF_PGM_HEX_TABLE_MEM    PROGMEM
+#define iqrfPgmHexValue(C)        pgm_read_byte(&IqrfPgmHexTable[(uint8_t)(C)])
+#else
+#define IQRF_PGM_HEX_TABLE_MEM
+#define iqrfPgmHexValue(C)        IqrfPgmHexTable[(uint8_t)(C)]
+#endif
 
 /* Function prototypes */
-uint8_t iqrfPgmWriteKeyOrPass(uint8_t Selector, uint8_t *Buffer);
-uint8_t iqrfPgmProcessCfgFile(void);
-void iqrfPgmMoveOverflowedData(void);
-uint8_t iqrfPgmPrepareMemBlock(void);
-uint8_t iqrfPgmReadIQRFFileLine(void);
-uint8_t iqrfPgmReadHEXFileLine(void);
+IQRF_PGM_CONTEXT *iqrfPgmDefaultContext(void);
+uint8_t iqrfPgmProcessCfgFile(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmMoveOverflowedData(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmPrepareMemBlock(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmPrepareMappedBlock(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmPreparePacketStep(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet);
+uint8_t iqrfPgmWriteProgress(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmBlockMapIndex(uint16_t MemoryBlockNumber);
+uint8_t iqrfPgmBlockMapPut(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmBlockMapGet(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmBlockMapWrite(IQRF_PGM_CONTEXT *Ctx, uint8_t Index, uint8_t Offset, const uint8_t *Data, uint8_t Size);
+uint8_t iqrfPgmReadIQRFFileLine(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmReadHEXFileLine(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmResetFileBuffer(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmReadFileByte(IQRF_PGM_CONTEXT *Ctx);
+uint16_t iqrfPgmFileStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk);
+uint16_t iqrfPgmMemoryStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk);
+uint16_t iqrfPgmLzStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk);
+void iqrfPgmLzReset(IQRF_PGM_LZ_STREAM *Stream);
+uint8_t iqrfPgmLzReadByte(IQRF_PGM_LZ_STREAM *Stream, uint8_t *Byte);
+uint16_t iqrfPgmLzDecode(IQRF_PGM_LZ_STREAM *Stream);
+uint8_t iqrfPgmReadImageRecord(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet);
+uint8_t iqrfPgmReadImageByte(IQRF_PGM_CONTEXT *Ctx);
+uint32_t iqrfPgmHash(uint32_t Hash, const uint8_t *Data, uint16_t Size);
+void iqrfPgmDeltaInit(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmDeltaSkip(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_STAGED_PACKET *Staged);
+void iqrfPgmDeltaCommit(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmConfirmPacket(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmClaimTr(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmReleaseTr(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmModuleRecordName(char *Name, const char *Extension);
+void iqrfPgmCheckpointInit(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmCheckpointSkip(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_STAGED_PACKET *Staged);
+void iqrfPgmCheckpointRestart(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmCheckpointCommit(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmCheckpointSave(IQRF_PGM_CONTEXT *Ctx, uint8_t Valid);
+uint8_t iqrfPgmCheckpointLoad(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmPutLe(uint8_t *Buffer, uint32_t Value, uint8_t Size);
+uint32_t iqrfPgmGetLe(const uint8_t *Buffer, uint8_t Size);
+void iqrfPgmSessionSelect(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmSessionNext(IQRF_PGM_CONTEXT *Ctx);
+void iqrfPgmSessionEnd(IQRF_PGM_CONTEXT *Ctx);
+uint8_t iqrfPgmCacheLookup(IQRF_PGM_CONTEXT *Ctx, uint8_t KeyType, IQRF_PGM_CACHE_ENTRY *Entry);
+void iqrfPgmCacheStore(IQRF_PGM_CONTEXT *Ctx, uint8_t KeyType, uint8_t Result);
+void iqrfPgmCacheStoreAll(IQRF_PGM_CONTEXT *Ctx, uint8_t Result);
+void iqrfPgmHashFileEnd(IQRF_PGM_CONTEXT *Ctx);
 
 /* Public variable declarations */
-uint8_t IqrfPgmCodeLineBuffer[SIZE_OF_CODE_LINE_BUFFER];
-PREPARE_MEM_BLOCK PrepareMemBlock;
+IQRF_PGM_CONTEXT IqrfPgmContext;
+IQRF_PGM_CONTEXT *IqrfPgmTrOwner;         // context using TR module, see iqrfPgmClaimTr()
+uint8_t IqrfPgmContextCnt;                // number of initialized contexts, names scratch records of block maps
+
+// value of hexadecimal ASCII char ('0'-'9', 'a'-'f', 'A'-'F'), other chars are converted to 0
+const uint8_t IqrfPgmHexTable[256] IQRF_PGM_HEX_TABLE_MEM = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/**
+ * Initialize programmer context
+ * @param FileInfo pointer to information about code file of the context
+ */
+void iqrfPgmInit(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_FILE_INFO *FileInfo)
+{
+    memset(Ctx, 0, sizeof(IQRF_PGM_CONTEXT));
+    Ctx->FileInfo = FileInfo;
+    Ctx->DeltaSlot = IQRF_PGM_DELTA_NO_SLOT;
+    // contexts interleaving HEX files do not share scratch record of block map
+    strcpy(Ctx->BlockMap.ScratchName, "PGMMAP00.TMP");
+    Ctx->BlockMap.ScratchName[6] = "0123456789ABCDEF"[IqrfPgmContextCnt >> 4];
+    Ctx->BlockMap.ScratchName[7] = "0123456789ABCDEF"[IqrfPgmContextCnt & 0x0F];
+    IqrfPgmContextCnt++;
+    iqrfPgmCtxSetStream(Ctx, NULL, NULL);
+}
+
+/**
+ * Claim TR module for operation of programmer context
+ * @return true = TR module is owned by the context, false = other context uses TR module
+ * @note Test and set of the owner are not atomic, programmer contexts must be run cooperatively
+ *       from one thread (main loop), never from interrupts or other threads
+ */
+uint8_t iqrfPgmClaimTr(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (IqrfPgmTrOwner && IqrfPgmTrOwner != Ctx)
+        return(false);
+    IqrfPgmTrOwner = Ctx;
+    return(true);
+}
+
+/**
+ * Release TR module owned by programmer context
+ */
+void iqrfPgmReleaseTr(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (IqrfPgmTrOwner == Ctx)
+        IqrfPgmTrOwner = NULL;
+}
+
+/**
+ * Abort running operation of programmer context
+ */
+void iqrfPgmAbort(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (IqrfPgmTrOwner == Ctx) {
+        // packet waiting in library TX buffer belongs to aborted operation
+        iqrfCancelPacket();
+        // TR module returns to communication mode after reset
+        iqrfTrEndPgmMode();
+        iqrfPgmReleaseTr(Ctx);
+        // aborted programming can be resumed later
+        if (Ctx->Checkpoint.Packets)
+            iqrfPgmCheckpointSave(Ctx, true);
+    }
+    Ctx->TaskSM = 0;
+    Ctx->Resume = false;
+    iqrfPgmSessionEnd(Ctx);
+    Ctx->NextPacket.Ready = false;
+    Ctx->DeltaSlot = IQRF_PGM_DELTA_NO_SLOT;
+    iqrfPgmResetFileBuffer(Ctx);
+}
+
+/**
+ * Get default programmer context, it is initialized on first use
+ * @return pointer to IqrfPgmContext
+ */
+IQRF_PGM_CONTEXT *iqrfPgmDefaultContext(void)
+{
+    if (IqrfPgmContext.FileInfo == NULL)
+        iqrfPgmInit(&IqrfPgmContext, &CodeFileInfo);
+    return(&IqrfPgmContext);
+}
+
+uint8_t iqrfPgmCheckCodeFile(void)
+{
+    return(iqrfPgmCtxCheckCodeFile(iqrfPgmDefaultContext()));
+}
+
+uint8_t iqrfPgmWriteCodeFile(void)
+{
+    return(iqrfPgmCtxWriteCodeFile(iqrfPgmDefaultContext()));
+}
+
+uint8_t iqrfPgmResumeCodeFile(void)
+{
+    return(iqrfPgmCtxResumeCodeFile(iqrfPgmDefaultContext()));
+}
+
+uint8_t iqrfPgmWriteSession(IQRF_PGM_SESSION_ITEM *Items, uint8_t Count)
+{
+    return(iqrfPgmCtxWriteSession(iqrfPgmDefaultContext(), Items, Count));
+}
+
+uint8_t iqrfPgmWriteKeyOrPass(uint8_t BufferContent, uint8_t *Buffer)
+{
+    return(iqrfPgmCtxWriteKeyOrPass(iqrfPgmDefaultContext(), BufferContent, Buffer));
+}
+
+void iqrfPgmSetDeltaMode(uint8_t Mode)
+{
+    iqrfPgmCtxSetDeltaMode(iqrfPgmDefaultContext(), Mode);
+}
+
+void iqrfPgmSetBlockMap(uint8_t *Buffer)
+{
+    iqrfPgmCtxSetBlockMap(iqrfPgmDefaultContext(), Buffer);
+}
+
+void iqrfPgmSetCacheMode(uint8_t Mode)
+{
+    iqrfPgmCtxSetCacheMode(iqrfPgmDefaultContext(), Mode);
+}
+
+void iqrfPgmSetStream(T_IQRF_PGM_STREAM_FETCH Fetch, void *Context)
+{
+    iqrfPgmCtxSetStream(iqrfPgmDefaultContext(), Fetch, Context);
+}
+
+void iqrfPgmSetMemoryStream(const uint8_t *Data, uint32_t Size)
+{
+    iqrfPgmCtxSetMemoryStream(iqrfPgmDefaultContext(), Data, Size);
+}
+
+uint8_t iqrfPgmSetCompressedStream(IQRF_PGM_LZ_STREAM *Stream, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context)
+{
+    return(iqrfPgmCtxSetCompressedStream(iqrfPgmDefaultContext(), Stream, Fetch, Context));
+}
+
+void iqrfPgmInitPacketReader(void)
+{
+    iqrfPgmCtxInitPacketReader(iqrfPgmDefaultContext());
+}
+
+uint8_t iqrfPgmPreparePacket(IQRF_PGM_PACKET *Packet)
+{
+    return(iqrfPgmCtxPreparePacket(iqrfPgmDefaultContext(), Packet));
+}
 
 /**
  * Checking the format accuracy of the programming file
  * @return result of partial checking operation
  */
-uint8_t iqrfPgmCheckCodeFile(void)
+uint8_t iqrfPgmCtxCheckCodeFile(IQRF_PGM_CONTEXT *Ctx)
 {
-    static enum {
+    enum {
         INIT_TASK = 0,
-        CHECK_PLUGIN_CODE,
-        CHECK_HEX_CODE,
-        CHECK_CFG_CODE,
-    } CheckCodeTaskSM = INIT_TASK;
+        HASH_FILE,
+        PROBE_FILE,
+        CHECK_CODE,
+    };
 
-    uint8_t OperationResult;
+    IQRF_PGM_PACKET Packet;
+#if IQRF_PGM_CACHE_ENTRIES
+    IQRF_PGM_CACHE_ENTRY Entry;
+    const uint8_t *Chunk;
+    uint16_t Size;
+    uint8_t FileSize[4];
+#endif
 
-    switch (CheckCodeTaskSM) {
+    switch (Ctx->TaskSM) {
     // initialize the checking process
     case INIT_TASK:
-        CodeFileInfo.FileByteCnt = 0;
-        if (CodeFileInfo.FileType == IQRF_PGM_PLUGIN_FILE_TYPE) {
-            CheckCodeTaskSM = CHECK_PLUGIN_CODE;
-        } else {
-            PrepareMemBlock.DataInBufferReady = 0;
-            PrepareMemBlock.DataOverflow = 0;
-            if (CodeFileInfo.FileType == IQRF_PGM_HEX_FILE_TYPE) {
-                CheckCodeTaskSM = CHECK_HEX_CODE;
-            } else {
-                if (CodeFileInfo.FileSize < 33)
-                    return(IQRF_PGM_ERROR);
-                CheckCodeTaskSM = CHECK_CFG_CODE;
-            }
+        if (Ctx->FileInfo->FileType == IQRF_PGM_CFG_FILE_TYPE && Ctx->FileInfo->FileSize < 33)
+            return(IQRF_PGM_ERROR);
+        Ctx->Stats.PacketsChecked = 0;
+        Ctx->Stats.CheckCached = false;
+        iqrfPgmCtxInitPacketReader(Ctx);
+        // records are only validated, so blocks are not collected in block map
+        Ctx->BlockMap.Active = false;
+        Ctx->FileHash = 0x811C9DC5UL;
+#if IQRF_PGM_CACHE_ENTRIES
+        // chunks of file in memory are not copied, so it is hashed before parsing cheaply
+        if (Ctx->StreamFetch == iqrfPgmMemoryStreamFetch || Ctx->CacheMode == IQRF_PGM_CACHE_ALWAYS) {
+            Ctx->TaskSM = HASH_FILE;
+            break;
         }
+        // other streams are hashed while they are checked
+        Ctx->FileHashing = true;
+        Ctx->TaskSM = PROBE_FILE;
+        break;
+#else
+        Ctx->TaskSM = CHECK_CODE;
         break;
+#endif
 
-    // check if format of *.IQRF file is correct
-    case CHECK_PLUGIN_CODE:
-        // read one line from *.IQRF file
-        iqrfSuspendDriver();
-        OperationResult = iqrfPgmReadIQRFFileLine();
-        iqrfRunDriver();
-        // if any error in line format
-        if (OperationResult == IQRF_PGM_FILE_DATA_ERROR) {
-            CheckCodeTaskSM = INIT_TASK;               // initialize state machine
-            return(IQRF_PGM_ERROR);                    // return error code
-        } else {
-            // if end of file
-            if (OperationResult == IQRF_PGM_END_OF_FILE) {
-                CheckCodeTaskSM = INIT_TASK;          // initialize state machine
-                return(IQRF_PGM_SUCCESS);             // file format is correct
-            }
+#if IQRF_PGM_CACHE_ENTRIES
+    // hash content of code file, one chunk per call
+    case HASH_FILE:
+        if ((Size = Ctx->StreamFetch(Ctx->StreamContext, Ctx->FileBuffer.Offset, &Chunk)) != 0) {
+            Ctx->FileHash = iqrfPgmHash(Ctx->FileHash, Chunk, Size);
+            Ctx->FileBuffer.Offset += Size;
+            Ctx->FileInfo->FileByteCnt = Ctx->FileBuffer.Offset;
+            break;
+        }
+        iqrfPgmCtxInitPacketReader(Ctx);
+        Ctx->BlockMap.Active = false;
+        // the same code file has already been checked
+        if (iqrfPgmCacheLookup(Ctx, IQRF_PGM_CACHE_KEY_CONTENT, &Entry)) {
+            Ctx->Stats.PacketsChecked = Entry.Packets;
+            Ctx->Stats.CheckCached = true;
+            Ctx->TaskSM = INIT_TASK;
+            return(Entry.Result);
         }
+        Ctx->TaskSM = CHECK_CODE;
         break;
 
-        // check if format of *.HEX of *.trcnfg file is correct
-    case CHECK_HEX_CODE:
-    case CHECK_CFG_CODE:
-        if (CodeFileInfo.FileType == IQRF_PGM_HEX_FILE_TYPE)
-            OperationResult = iqrfPgmPrepareMemBlock();
-        else
-            OperationResult = iqrfPgmProcessCfgFile();
-        if (OperationResult != IQRF_PGM_FLASH_BLOCK_READY && OperationResult != IQRF_PGM_EEPROM_BLOCK_READY) {
-            CheckCodeTaskSM = INIT_TASK;
-            return(OperationResult);
+    // look up streamed code file by its size and first chunk, the chunk stays in file buffer for the check
+    case PROBE_FILE:
+        iqrfPgmReadFileByte(Ctx);
+        Ctx->FileBuffer.Ptr = 0;
+        Ctx->FileInfo->FileByteCnt = 0;
+        iqrfPgmPutLe(FileSize, Ctx->FileInfo->FileSize, 4);
+        Ctx->FileProbeHash = iqrfPgmHash(iqrfPgmHash(0x811C9DC5UL, FileSize, 4), Ctx->FileBuffer.Chunk, Ctx->FileBuffer.Length);
+        if (iqrfPgmCacheLookup(Ctx, IQRF_PGM_CACHE_KEY_PROBE, &Entry)) {
+            Ctx->FileHashing = false;
+            Ctx->Stats.PacketsChecked = Entry.Packets;
+            Ctx->Stats.CheckCached = true;
+            Ctx->TaskSM = INIT_TASK;
+            return(Entry.Result);
+        }
+        Ctx->TaskSM = CHECK_CODE;
+        break;
+#endif
+
+    // check if format of code file is correct
+    case CHECK_CODE:
+        switch (iqrfPgmCtxPreparePacket(Ctx, &Packet)) {
+        case IQRF_PGM_FILE_DATA_READY:
+            Ctx->Stats.PacketsChecked++;
+            break;
+        // if any error in file format
+        case IQRF_PGM_FILE_DATA_ERROR:
+            iqrfPgmHashFileEnd(Ctx);
+            iqrfPgmCacheStoreAll(Ctx, IQRF_PGM_ERROR);
+            Ctx->TaskSM = INIT_TASK;               // initialize state machine
+            return(IQRF_PGM_ERROR);                    // return error code
+        // if end of file
+        case IQRF_PGM_END_OF_FILE:
+            iqrfPgmHashFileEnd(Ctx);
+            iqrfPgmCacheStoreAll(Ctx, IQRF_PGM_SUCCESS);
+            Ctx->TaskSM = INIT_TASK;               // initialize state machine
+            return(IQRF_PGM_SUCCESS);                  // file format is correct
         }
         break;
     }
 
     // return file processing status in percent
-    return(((uint32_t) CodeFileInfo.FileByteCnt * 100) / CodeFileInfo.FileSize);
+    return(((uint32_t) Ctx->FileInfo->FileByteCnt * 100) / Ctx->FileInfo->FileSize);
+}
+
+/**
+ * Finish hash of code file accumulated by check pass, the rest of file behind the last parsed record is hashed
+ */
+void iqrfPgmHashFileEnd(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (!Ctx->FileHashing)
+        return;
+    while (iqrfPgmReadFileByte(Ctx) != 0 || Ctx->FileBuffer.Length != 0)
+        Ctx->FileBuffer.Ptr = Ctx->FileBuffer.Length;
+    Ctx->FileHashing = false;
+}
+
+/**
+ * Look for result of previous check of code file in validated-image cache
+ * @param KeyType IQRF_PGM_CACHE_KEY_CONTENT (Ctx->FileHash) or IQRF_PGM_CACHE_KEY_PROBE (Ctx->FileProbeHash)
+ * @param Entry pointer to structure, where cache entry will be stored
+ * @return true = code file has already been checked, false = code file is not in the cache
+ * @note Entry with other header (e.g. stored by other version of the library) is not used
+ */
+uint8_t iqrfPgmCacheLookup(IQRF_PGM_CONTEXT *Ctx, uint8_t KeyType, IQRF_PGM_CACHE_ENTRY *Entry)
+{
+#if IQRF_PGM_CACHE_ENTRIES
+    uint8_t Record[IQRF_PGM_CACHE_HEADER_SIZE + IQRF_PGM_CACHE_DATA_SIZE];
+    uint8_t *Data = &Record[IQRF_PGM_CACHE_HEADER_SIZE];
+    uint32_t Hash = KeyType == IQRF_PGM_CACHE_KEY_PROBE ? Ctx->FileProbeHash : Ctx->FileHash;
+    uint16_t Size;
+
+    iqrfSuspendDriver();
+    Size = iqrfReadStorage(IQRF_PGM_CACHE_NAME, (Hash % IQRF_PGM_CACHE_ENTRIES) * sizeof(Record), Record, sizeof(Record));
+    iqrfRunDriver();
+    if (Size != sizeof(Record)
+        || memcmp(Record, IQRF_PGM_CACHE_MAGIC, 4) != 0
+        || Record[4] != IQRF_PGM_CACHE_VERSION
+        || Record[5] != IQRF_PGM_CACHE_DATA_SIZE)
+    {
+        return(false);
+    }
+    Entry->FileSize = iqrfPgmGetLe(&Data[0], 4);
+    Entry->Hash = iqrfPgmGetLe(&Data[4], 4);
+    Entry->FileType = Data[8];
+    Entry->Result = Data[9];
+    Entry->Packets = (uint16_t)iqrfPgmGetLe(&Data[10], 2);
+    Entry->KeyType = Data[12];
+    return(Entry->Result != 0
+        && Entry->KeyType == KeyType
+        && Entry->Hash == Hash
+        && Entry->FileSize == Ctx->FileInfo->FileSize
+        && Entry->FileType == Ctx->FileInfo->FileType);
+#else
+    (void)Ctx;
+    (void)KeyType;
+    (void)Entry;
+    return(false);
+#endif
+}
+
+/**
+ * Store result of code file check to validated-image cache
+ * @param KeyType IQRF_PGM_CACHE_KEY_CONTENT (Ctx->FileHash) or IQRF_PGM_CACHE_KEY_PROBE (Ctx->FileProbeHash)
+ * @param Result result of the check
+ * @note Record of the entry contains header (magic, version, size of data) and little-endian fields of
+ *       IQRF_PGM_CACHE_ENTRY, so the cache can be moved between platforms
+ */
+void iqrfPgmCacheStore(IQRF_PGM_CONTEXT *Ctx, uint8_t KeyType, uint8_t Result)
+{
+#if IQRF_PGM_CACHE_ENTRIES
+    uint8_t Record[IQRF_PGM_CACHE_HEADER_SIZE + IQRF_PGM_CACHE_DATA_SIZE];
+    uint8_t *Data = &Record[IQRF_PGM_CACHE_HEADER_SIZE];
+    uint32_t Hash = KeyType == IQRF_PGM_CACHE_KEY_PROBE ? Ctx->FileProbeHash : Ctx->FileHash;
+
+    // entry is addressed by its key
+    memcpy(Record, IQRF_PGM_CACHE_MAGIC, 4);
+    Record[4] = IQRF_PGM_CACHE_VERSION;
+    Record[5] = IQRF_PGM_CACHE_DATA_SIZE;
+    iqrfPgmPutLe(&Data[0], Ctx->FileInfo->FileSize, 4);
+    iqrfPgmPutLe(&Data[4], Hash, 4);
+    Data[8] = Ctx->FileInfo->FileType;
+    Data[9] = Result;
+    iqrfPgmPutLe(&Data[10], Ctx->Stats.PacketsChecked, 2);
+    Data[12] = KeyType;
+    iqrfSuspendDriver();
+    iqrfWriteStorage(IQRF_PGM_CACHE_NAME, (Hash % IQRF_PGM_CACHE_ENTRIES) * sizeof(Record), Record, sizeof(Record));
+    iqrfRunDriver();
+#else
+    (void)Ctx;
+    (void)KeyType;
+    (void)Result;
+#endif
+}
+
+/**
+ * Store result of finished check of code file to validated-image cache under all keys of the file
+ * @param Result result of the check
+ * @note Streamed file is stored also by hash of its content, so the same file in memory is found in the cache
+ */
+void iqrfPgmCacheStoreAll(IQRF_PGM_CONTEXT *Ctx, uint8_t Result)
+{
+    iqrfPgmCacheStore(Ctx, IQRF_PGM_CACHE_KEY_CONTENT, Result);
+    if (Ctx->StreamFetch != iqrfPgmMemoryStreamFetch && Ctx->CacheMode == IQRF_PGM_CACHE_MEMORY)
+        iqrfPgmCacheStore(Ctx, IQRF_PGM_CACHE_KEY_PROBE, Result);
 }
 
 /**
  * Core programming function
  * @return result of partial programming operation
+ * @note Every record of the code file is validated before the memory block it belongs to is written
+ *       to TR module, so the function can be used without previous iqrfPgmCtxCheckCodeFile(Ctx) pass.
+ *       In that case the function returns IQRF_PGM_FORMAT_ERROR if a wrong record is found.
  */
-uint8_t iqrfPgmWriteCodeFile(void)
+uint8_t iqrfPgmCtxWriteCodeFile(IQRF_PGM_CONTEXT *Ctx)
 {
-    static enum {
+    enum {
         INIT_TASK = 0,
         ENTER_PROG_MODE,
         WAIT_PROG_MODE,
-        WRITE_PLUGIN,
-        WRITE_HEX,
+        WRITE_DATA,
         WAIT_PROG_END,
         PROG_END,
-    } WriteCodeTaskSM = INIT_TASK;
-
-    static uint8_t Attempts;
-    static uint8_t OperationResult;
-    static uint32_t SysTickTime;
+    };
 
-   	switch (WriteCodeTaskSM) {
+   	switch (Ctx->TaskSM) {
     case INIT_TASK:     // initialize programming state machine
-        Attempts = 1;
-        CodeFileInfo.FileByteCnt = 0;
-        WriteCodeTaskSM = ENTER_PROG_MODE;
+        // configuration file is not validated record by record, check its size now
+        if (!Ctx->Session && Ctx->FileInfo->FileType == IQRF_PGM_CFG_FILE_TYPE && Ctx->FileInfo->FileSize < 33)
+            return(IQRF_PGM_FORMAT_ERROR);
+        // wait until other context releases TR module
+        if (!iqrfPgmClaimTr(Ctx))
+            break;
+        Ctx->Attempts = 1;
+        Ctx->NextPacket.Ready = false;
+        iqrfPgmCtxInitPacketReader(Ctx);
+        iqrfPgmDeltaInit(Ctx);
+        iqrfPgmCheckpointInit(Ctx);
+        // checkpoint describes one code file
+        if (Ctx->Session)
+            Ctx->CheckpointName[0] = 0;
+        Ctx->PacketPending = false;
+        Ctx->TaskSM = ENTER_PROG_MODE;
         break;
 
     case ENTER_PROG_MODE:
+        // entry time includes repeated attempts
+        if (Ctx->Attempts)
+            Ctx->PgmModeStartTime = iqrfGetSysTick();
         iqrfTrEnterPgmMode();
-        SysTickTime = iqrfGetSysTick();
-        WriteCodeTaskSM = WAIT_PROG_MODE;
+        Ctx->SysTickTime = iqrfGetSysTick();
+        Ctx->TaskSM = WAIT_PROG_MODE;
         break;
 
     case WAIT_PROG_MODE:      // wait for TR module programming mode
         if (iqrfGetSpiStatus() == PROGRAMMING_MODE && iqrfGetLibraryStatus() == IQRF_READY) {
-            SysTickTime = iqrfGetSysTick();
-            if (CodeFileInfo.FileType == IQRF_PGM_PLUGIN_FILE_TYPE){
-                WriteCodeTaskSM = WRITE_PLUGIN;
-            } else {
-                PrepareMemBlock.DataInBufferReady = 0;
-                PrepareMemBlock.DataOverflow = 0;
-                PrepareMemBlock.MemoryBlockProcessState = 0;
-                WriteCodeTaskSM = WRITE_HEX;
-            }
+            Ctx->SysTickTime = iqrfGetSysTick();
+            Ctx->Stats.PgmModeEntryTime = (uint32_t)(Ctx->SysTickTime - Ctx->PgmModeStartTime) * 1000 / TICKS_IN_SECOND;
+            Ctx->TaskSM = WRITE_DATA;
         } else {
-            if (iqrfGetSysTick() - SysTickTime >= (TICKS_IN_SECOND / 2)) {
+            if (iqrfGetSysTick() - Ctx->SysTickTime >= IQRF_PGM_MODE_WAIT_TIMEOUT) {
                 // in a case, try it twice to enter programming mode
-                if (Attempts) {
-                    Attempts--;
-                    WriteCodeTaskSM = ENTER_PROG_MODE;
+                if (Ctx->Attempts) {
+                    Ctx->Attempts--;
+                    Ctx->TaskSM = ENTER_PROG_MODE;
                 } else {
                     // TR module probably does not work
-                    OperationResult = IQRF_PGM_ERROR;
-                    WriteCodeTaskSM = PROG_END;
+                    Ctx->OperationResult = IQRF_PGM_ERROR;
+                    Ctx->TaskSM = PROG_END;
                 }
             }
         }
         break;
 
-    case WRITE_PLUGIN:      // write plugin to TR module
-        // if no packet is pending to send to TR module
-        if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE
-            && iqrfGetSpiStatus() == PROGRAMMING_MODE
-            && iqrfGetLibraryStatus() == IQRF_READY)
-        {
-            iqrfSuspendDriver();
-            Attempts = iqrfPgmReadIQRFFileLine();
-            iqrfRunDriver();
-            if (Attempts == IQRF_PGM_FILE_DATA_ERROR) {
-                OperationResult = IQRF_PGM_ERROR;
-                WriteCodeTaskSM = WAIT_PROG_END;                // go to end programming mode
-            } else {
-                if (Attempts == IQRF_PGM_END_OF_FILE) {
-                    OperationResult = IQRF_PGM_SUCCESS;
-                    WriteCodeTaskSM = WAIT_PROG_END;            // go to end programming mode
-                } else {
-                    // send plugin PGM packet
-                    iqrfSendPacket(SPI_PLUGIN_PGM, IqrfPgmCodeLineBuffer, 20);
-                    SysTickTime = iqrfGetSysTick();
+    case WRITE_DATA:      // write code file to TR module
+        // prepare next packet, while previous one is clocked out by IQRF driver and written by TR module
+        // (data of previous packet are already copied to driver TX buffer, if library TX buffer is free)
+        if (!Ctx->NextPacket.Ready && iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE) {
+            switch (iqrfPgmPreparePacketStep(Ctx, &Ctx->NextPacket.Packet)) {
+            case IQRF_PGM_FILE_DATA_PENDING:
+                // HEX file is being read to block map, continue in next step
+                break;
+            case IQRF_PGM_FILE_DATA_READY:
+                // skip packet written before interruption of programming
+                if (iqrfPgmCheckpointSkip(Ctx, &Ctx->NextPacket))
+                    Ctx->Stats.PacketsResumed++;
+                // skip packet, if TR module already contains the same data
+                else if (iqrfPgmDeltaSkip(Ctx, &Ctx->NextPacket))
+                    Ctx->Stats.PacketsSkipped++;
+                else
+                    Ctx->NextPacket.Ready = true;
+                break;
+            case IQRF_PGM_END_OF_FILE:
+                // code file is shorter than interrupted one
+                if (Ctx->ResumePoint.Packets) {
+                    iqrfPgmCheckpointRestart(Ctx);
+                    break;
                 }
+                Ctx->OperationResult = IQRF_PGM_SUCCESS;
+                Ctx->TaskSM = WAIT_PROG_END;            // go to end programming mode
+                break;
+            default:
+                // wrong record found, image of actual memory block is not written
+                Ctx->OperationResult = IQRF_PGM_FORMAT_ERROR;
+                Ctx->TaskSM = WAIT_PROG_END;            // go to end programming mode
+                break;
             }
-        } else {
-            if (iqrfGetSysTick() - SysTickTime >= (TICKS_IN_SECOND / 2)) {
-                iqrfTrReset();
-                OperationResult = IQRF_PGM_ERROR;
-                WriteCodeTaskSM = PROG_END;                       // go to end programming mode
-            }
+            if (Ctx->TaskSM != WRITE_DATA)
+                break;
         }
-        break;
-
-    case WRITE_HEX:      // write HEX file to TR module
         // if no packet is pending to send to TR module
         if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE
             && iqrfGetSpiStatus() == PROGRAMMING_MODE
             && iqrfGetLibraryStatus() == IQRF_READY)
         {
-            if (PrepareMemBlock.MemoryBlockProcessState == 0) {
-                if (CodeFileInfo.FileType == IQRF_PGM_HEX_FILE_TYPE)
-                    OperationResult = iqrfPgmPrepareMemBlock();
-                else
-                    OperationResult = iqrfPgmProcessCfgFile();
-                if (OperationResult != IQRF_PGM_FLASH_BLOCK_READY && OperationResult != IQRF_PGM_EEPROM_BLOCK_READY)
-                    WriteCodeTaskSM = WAIT_PROG_END;            // go to end programming mode
-            } else {
-                if (OperationResult == IQRF_PGM_FLASH_BLOCK_READY) {
-                    if (PrepareMemBlock.MemoryBlockProcessState == 2)
-                        iqrfSendPacket(SPI_FLASH_PGM, (uint8_t *)&PrepareMemBlock.MemoryBlock[0], 32 + 2);
-                    else
-                        iqrfSendPacket(SPI_FLASH_PGM, (uint8_t *)&PrepareMemBlock.MemoryBlock[34], 32 + 2);
-                } else {
-                    iqrfSendPacket(SPI_EEPROM_PGM, (uint8_t *)&PrepareMemBlock.MemoryBlock[0], PrepareMemBlock.MemoryBlock[1] + 2);
-                }
-                SysTickTime = iqrfGetSysTick();
-                PrepareMemBlock.MemoryBlockProcessState--;
+            // previous packet has been processed, remember its content if TR module accepted it
+            if (!iqrfPgmConfirmPacket(Ctx)) {
+                iqrfTrReset();
+                Ctx->OperationResult = IQRF_PGM_ERROR;
+                Ctx->TaskSM = PROG_END;                       // go to end programming mode
+                break;
+            }
+            if (Ctx->NextPacket.Ready) {
+                // send prepared programming packet
+                iqrfSendPacket(Ctx->NextPacket.Packet.SpiCmd, Ctx->NextPacket.Packet.Data, Ctx->NextPacket.Packet.Length);
+                Ctx->DeltaSlot = Ctx->NextPacket.DeltaSlot;
+                Ctx->DeltaHash = Ctx->NextPacket.DeltaHash;
+                Ctx->SentProgress = Ctx->NextPacket.Progress;
+                Ctx->PacketPending = true;
+                Ctx->NextPacket.Ready = false;
+                Ctx->Stats.PacketsSent++;
+                Ctx->SysTickTime = iqrfGetSysTick();
             }
         } else {
-            if (iqrfGetSysTick() - SysTickTime >= (TICKS_IN_SECOND / 2)) {
+            if (iqrfGetSysTick() - Ctx->SysTickTime >= (TICKS_IN_SECOND / 2)) {
                 iqrfTrReset();
-                OperationResult = IQRF_PGM_ERROR;
-                WriteCodeTaskSM = PROG_END;                       // go to end programming mode
+                Ctx->OperationResult = IQRF_PGM_ERROR;
+                Ctx->TaskSM = PROG_END;                       // go to end programming mode
             }
         }
         break;
 
     case WAIT_PROG_END:     // wait until last packet is written to TR module
         if (iqrfGetSpiStatus() == PROGRAMMING_MODE && iqrfGetLibraryStatus() == IQRF_READY) {
+            if (!iqrfPgmConfirmPacket(Ctx)) {
+                iqrfTrReset();
+                Ctx->OperationResult = IQRF_PGM_ERROR;
+                Ctx->TaskSM = PROG_END;                       // go to end programming mode
+                break;
+            }
+            // continue by next item of programming session in the same programming mode
+            if (iqrfPgmSessionNext(Ctx)) {
+                Ctx->SysTickTime = iqrfGetSysTick();
+                Ctx->TaskSM = WRITE_DATA;
+                break;
+            }
             iqrfTrEndPgmMode();
-            WriteCodeTaskSM = PROG_END;                           // go to end programming mode
+            Ctx->TaskSM = PROG_END;                           // go to end programming mode
         }
         break;
 
     case PROG_END:
         // if no packet is pending to send to TR module
         if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE && iqrfGetLibraryStatus() == IQRF_READY) {
-            WriteCodeTaskSM = INIT_TASK;
-            return(OperationResult);
+            // keep checkpoint of interrupted programming, remove it when the file is written or wrong
+            if (Ctx->OperationResult != IQRF_PGM_ERROR)
+                iqrfPgmCheckpointSave(Ctx, false);
+            else if (Ctx->Checkpoint.Packets)
+                iqrfPgmCheckpointSave(Ctx, true);
+            iqrfPgmReleaseTr(Ctx);
+            Ctx->TaskSM = INIT_TASK;
+            return(Ctx->OperationResult);
         }
         break;
     }
 
     // return TR module programming state in %
-    return(((uint32_t) CodeFileInfo.FileByteCnt * 100) / CodeFileInfo.FileSize);
+    return(iqrfPgmWriteProgress(Ctx));
+}
+
+/**
+ * Compute progress of programming
+ * @return programming state in percent
+ * @note HEX file with block map is written after the whole file has been read, so the progress
+ *       is based on blocks prepared from the map and reading of the file is only a small part of it
+ */
+uint8_t iqrfPgmWriteProgress(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (Ctx->FileInfo->FileType != IQRF_PGM_HEX_FILE_TYPE || !Ctx->BlockMap.Active)
+        return(((uint32_t) Ctx->FileInfo->FileByteCnt * 100) / Ctx->FileInfo->FileSize);
+    if (!Ctx->BlockMap.Flushing)
+        return(((uint32_t) Ctx->FileInfo->FileByteCnt * IQRF_PGM_MAP_READ_PROGRESS) / Ctx->FileInfo->FileSize);
+    if (Ctx->BlockMap.Blocks == 0)
+        return(100);
+    return(IQRF_PGM_MAP_READ_PROGRESS
+        + ((uint16_t)Ctx->BlockMap.Flushed * (100 - IQRF_PGM_MAP_READ_PROGRESS)) / Ctx->BlockMap.Blocks);
+}
+
+/**
+ * Continue interrupted programming of code file
+ * @return result of partial programming operation
+ */
+uint8_t iqrfPgmCtxResumeCodeFile(IQRF_PGM_CONTEXT *Ctx)
+{
+    // checkpoint is read in the first step of programming
+    if (Ctx->TaskSM == 0)
+        Ctx->Resume = true;
+    return(iqrfPgmCtxWriteCodeFile(Ctx));
+}
+
+/**
+ * Write several code files, passwords and keys to TR module in one programming mode session
+ * @param Items pointer to array of session items, result of every item is stored to its Result
+ * @param Count number of items
+ * @return result of partial programming operation
+ */
+uint8_t iqrfPgmCtxWriteSession(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_SESSION_ITEM *Items, uint8_t Count)
+{
+    uint8_t Result;
+    uint8_t Cnt;
+
+    if (Ctx->TaskSM == 0) {
+        if (Count == 0)
+            return(IQRF_PGM_SUCCESS);
+        // items, which are not reached, are not written
+        for (Cnt=0; Cnt<Count; Cnt++)
+            Items[Cnt].Result = IQRF_PGM_ERROR;
+        if (!Ctx->Session)
+            Ctx->SessionFileInfo = Ctx->FileInfo;
+        Ctx->Session = Items;
+        Ctx->SessionCount = Count;
+        Ctx->SessionIndex = 0;
+        iqrfPgmSessionSelect(Ctx);
+    }
+
+    Result = iqrfPgmCtxWriteCodeFile(Ctx);
+    if (Result <= 100)
+        return(((uint16_t)Ctx->SessionIndex * 100 + Result) / Count);
+
+    iqrfPgmSessionEnd(Ctx);
+    for (Cnt=0; Cnt<Count; Cnt++) {
+        if (Items[Cnt].Result != IQRF_PGM_SUCCESS)
+            return(IQRF_PGM_ERROR);
+    }
+    return(IQRF_PGM_SUCCESS);
+}
+
+/**
+ * Select code file of actual item of programming session
+ */
+void iqrfPgmSessionSelect(IQRF_PGM_CONTEXT *Ctx)
+{
+    IQRF_PGM_SESSION_ITEM *Item = &Ctx->Session[Ctx->SessionIndex];
+
+    Ctx->FileInfo = &Item->FileInfo;
+    if (Item->Fetch)
+        iqrfPgmCtxSetStream(Ctx, Item->Fetch, Item->Context);
+    else
+        iqrfPgmCtxSetMemoryStream(Ctx, Item->Data, Item->FileInfo.FileSize);
+}
+
+/**
+ * Store result of actual item of programming session and select next one
+ * @return true = next item is ready to be written, false = end of session or no session
+ */
+uint8_t iqrfPgmSessionNext(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (!Ctx->Session)
+        return(false);
+    Ctx->Session[Ctx->SessionIndex].Result = Ctx->OperationResult;
+    if (Ctx->SessionIndex + 1 >= Ctx->SessionCount)
+        return(false);
+    Ctx->SessionIndex++;
+    iqrfPgmSessionSelect(Ctx);
+    iqrfPgmCtxInitPacketReader(Ctx);
+    return(true);
+}
+
+/**
+ * Restore file info and default stream of the context after programming session
+ */
+void iqrfPgmSessionEnd(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (!Ctx->Session)
+        return;
+    Ctx->FileInfo = Ctx->SessionFileInfo;
+    Ctx->Session = NULL;
+    iqrfPgmCtxSetStream(Ctx, NULL, NULL);
+}
+
+/**
+ * Select delta programming mode of iqrfPgmCtxWriteCodeFile(Ctx)
+ * @param Mode IQRF_PGM_DELTA_OFF, IQRF_PGM_DELTA_ON or IQRF_PGM_DELTA_FORCE
+ * @note Hashes of written flash blocks are stored in persistent storage record named by TR module ID
+ */
+void iqrfPgmCtxSetDeltaMode(IQRF_PGM_CONTEXT *Ctx, uint8_t Mode)
+{
+    Ctx->DeltaMode = Mode;
+}
+
+/**
+ * Select storage of block map of iqrfPgmCtxWriteCodeFile(Ctx)
+ * @param Buffer RAM buffer of IQRF_PGM_MAP_SIZE bytes (NULL = scratch storage record of the context)
+ */
+void iqrfPgmCtxSetBlockMap(IQRF_PGM_CONTEXT *Ctx, uint8_t *Buffer)
+{
+    Ctx->BlockMap.Data = Buffer;
+}
+
+/**
+ * Select lookup of validated-image cache by iqrfPgmCtxCheckCodeFile(Ctx)
+ * @param Mode IQRF_PGM_CACHE_MEMORY or IQRF_PGM_CACHE_ALWAYS
+ */
+void iqrfPgmCtxSetCacheMode(IQRF_PGM_CONTEXT *Ctx, uint8_t Mode)
+{
+    Ctx->CacheMode = Mode;
+}
+
+/**
+ * Calculate FNV-1a hash of data block
+ * @param Hash initial value (0x811C9DC5) or hash of previous data
+ * @param Data pointer to data
+ * @param Size size of data
+ * @return hash of data
+ */
+uint32_t iqrfPgmHash(uint32_t Hash, const uint8_t *Data, uint16_t Size)
+{
+    while (Size--) {
+        Hash ^= *Data++;
+        Hash *= 16777619UL;
+    }
+    return(Hash);
+}
+
+/**
+ * Initialize delta programming for connected TR module
+ */
+void iqrfPgmDeltaInit(IQRF_PGM_CONTEXT *Ctx)
+{
+    Ctx->Stats.PacketsSent = 0;
+    Ctx->Stats.PacketsSkipped = 0;
+    Ctx->DeltaSlot = IQRF_PGM_DELTA_NO_SLOT;
+    Ctx->DeltaName[0] = 0;
+    // delta manifest is identified by TR module ID
+    if (Ctx->DeltaMode != IQRF_PGM_DELTA_OFF)
+        iqrfPgmModuleRecordName(Ctx->DeltaName, ".DLT");
+}
+
+/**
+ * Make name of persistent storage record of connected TR module
+ * @param Name pointer to 13 byte buffer for the name (empty string, if TR module ID is unknown)
+ * @param Extension extension of the name (including dot)
+ * @return true = name created, false = TR module ID is unknown
+ */
+uint8_t iqrfPgmModuleRecordName(char *Name, const char *Extension)
+{
+    uint32_t ModuleId = iqrfGetModuleId();
+    uint8_t Cnt;
+
+    Name[0] = 0;
+    if (ModuleId == 0)
+        return(false);
+    for (Cnt=0; Cnt<8; Cnt++) {
+        Name[Cnt] = "0123456789ABCDEF"[ModuleId >> 28];
+        ModuleId <<= 4;
+    }
+    strcpy(&Name[8], Extension);
+    return(true);
+}
+
+/**
+ * Check if TR module already contains data of programming packet
+ * @param Staged pointer to prepared programming packet
+ * @return true = packet can be skipped, false = packet must be written
+ */
+uint8_t iqrfPgmDeltaSkip(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_STAGED_PACKET *Staged)
+{
+    IQRF_PGM_PACKET *Packet = &Staged->Packet;
+    uint16_t Address;
+    uint16_t Slot;
+    uint8_t StoredHash[4];
+
+    Staged->DeltaSlot = IQRF_PGM_DELTA_NO_SLOT;
+    if (!Ctx->DeltaName[0] || Packet->SpiCmd != SPI_FLASH_PGM)
+        return(false);
+
+    // find slot of delta manifest for destination address of the packet
+    Address = ((uint16_t)Packet->Data[1] << 8) | Packet->Data[0];
+    if (Address >= IQRF_LICENCED_MEM_MIN_ADR && Address <= IQRF_LICENCED_MEM_MAX_ADR)
+        Slot = IQRF_PGM_DELTA_LICENCED_SLOT + (Address - IQRF_LICENCED_MEM_MIN_ADR) / 16;
+    else if (Address >= IQRF_MAIN_MEM_MIN_ADR && Address <= IQRF_MAIN_MEM_MAX_ADR)
+        Slot = IQRF_PGM_DELTA_MAIN_SLOT + (Address - IQRF_MAIN_MEM_MIN_ADR) / 16;
+    else if (Address < IQRF_PGM_DELTA_EEPROM_BLOCKS)
+        Slot = IQRF_PGM_DELTA_EEPROM_SLOT + Address;
+    else
+        return(false);
+
+    // hash 0 is reserved for unknown content
+    Staged->DeltaHash = iqrfPgmHash(0x811C9DC5UL, Packet->Data, Packet->Length);
+    if (Staged->DeltaHash == 0)
+        Staged->DeltaHash = 1;
+
+    if (Ctx->DeltaMode == IQRF_PGM_DELTA_ON) {
+        // hashes are stored little-endian, the manifest can be moved between platforms
+        iqrfSuspendDriver();
+        if (iqrfReadStorage(Ctx->DeltaName, (uint32_t)Slot * 4, StoredHash, 4) != 4)
+            memset(StoredHash, 0, sizeof(StoredHash));
+        iqrfRunDriver();
+        if (iqrfPgmGetLe(StoredHash, 4) == Staged->DeltaHash)
+            return(true);
+    }
+    // hash will be stored after the packet is written
+    Staged->DeltaSlot = Slot;
+    return(false);
+}
+
+/**
+ * Store hash of written packet to delta manifest
+ */
+void iqrfPgmDeltaCommit(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint8_t Hash[4];
+
+    if (Ctx->DeltaSlot == IQRF_PGM_DELTA_NO_SLOT)
+        return;
+    iqrfPgmPutLe(Hash, Ctx->DeltaHash, 4);
+    iqrfSuspendDriver();
+    iqrfWriteStorage(Ctx->DeltaName, (uint32_t)Ctx->DeltaSlot * 4, Hash, 4);
+    iqrfRunDriver();
+    Ctx->DeltaSlot = IQRF_PGM_DELTA_NO_SLOT;
+}
+
+/**
+ * Check result of the packet sent to TR module, remember its content if it has been written
+ * @return true = packet has been written or no packet is pending, false = TR module rejected the packet
+ */
+uint8_t iqrfPgmConfirmPacket(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (!Ctx->PacketPending)
+        return(true);
+    Ctx->PacketPending = false;
+    if (iqrfGetPacketResult() != IQRF_PACKET_OK) {
+        // content of the flash block is unknown, it must be written next time
+        Ctx->DeltaHash = 0;
+        iqrfPgmDeltaCommit(Ctx);
+        // checkpoint keeps the last packet accepted by TR module
+        Ctx->SentProgress.Packets = 0;
+        return(false);
+    }
+    iqrfPgmDeltaCommit(Ctx);
+    iqrfPgmCheckpointCommit(Ctx);
+    return(true);
+}
+
+/**
+ * Initialize checkpoint of programming for connected TR module
+ * @note Checkpoint of interrupted programming is read, if resume of programming is requested
+ */
+void iqrfPgmCheckpointInit(IQRF_PGM_CONTEXT *Ctx)
+{
+    memset(&Ctx->Checkpoint, 0, sizeof(IQRF_PGM_CHECKPOINT));
+    memset(&Ctx->SentProgress, 0, sizeof(IQRF_PGM_CHECKPOINT));
+    memset(&Ctx->ResumePoint, 0, sizeof(IQRF_PGM_CHECKPOINT));
+    Ctx->CheckpointSaved = 0;
+    Ctx->PacketCnt = 0;
+    Ctx->PacketHash = 0x811C9DC5UL;
+    Ctx->Stats.PacketsResumed = 0;
+
+    if (iqrfPgmModuleRecordName(Ctx->CheckpointName, ".CKP") && Ctx->Resume) {
+        // checkpoint is missing, removed, from other version or belongs to other code file
+        if (!iqrfPgmCheckpointLoad(Ctx)
+            || Ctx->ResumePoint.FileType != Ctx->FileInfo->FileType
+            || Ctx->ResumePoint.FileSize != Ctx->FileInfo->FileSize)
+        {
+            memset(&Ctx->ResumePoint, 0, sizeof(IQRF_PGM_CHECKPOINT));
+        }
+    }
+    Ctx->Resume = false;
+}
+
+/**
+ * Track progress of programming and check if packet has been written before interruption of programming
+ * @param Staged pointer to prepared programming packet
+ * @return true = packet is not sent to TR module, false = packet must be written
+ */
+uint8_t iqrfPgmCheckpointSkip(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_STAGED_PACKET *Staged)
+{
+    IQRF_PGM_PACKET *Packet = &Staged->Packet;
+
+    Ctx->PacketCnt++;
+    Ctx->PacketHash = iqrfPgmHash(Ctx->PacketHash, &Packet->SpiCmd, 1);
+    Ctx->PacketHash = iqrfPgmHash(Ctx->PacketHash, Packet->Data, Packet->Length);
+
+    Staged->Progress.FileSize = Ctx->FileInfo->FileSize;
+    Staged->Progress.FileType = Ctx->FileInfo->FileType;
+    Staged->Progress.Packets = Ctx->PacketCnt;
+    if (Packet->SpiCmd == SPI_FLASH_PGM)
+        Staged->Progress.Address = ((uint16_t)Packet->Data[1] << 8) | Packet->Data[0];
+    else if (Packet->SpiCmd == SPI_EEPROM_PGM)
+        Staged->Progress.Address = Packet->Data[0];
+    else
+        Staged->Progress.Address = 0;
+    Staged->Progress.FileOffset = Ctx->FileInfo->FileByteCnt;
+    Staged->Progress.Hash = Ctx->PacketHash;
+
+    if (!Ctx->ResumePoint.Packets)
+        return(false);
+    if (Ctx->PacketCnt < Ctx->ResumePoint.Packets)
+        return(true);
+
+    if (Staged->Progress.Hash == Ctx->ResumePoint.Hash && Staged->Progress.FileOffset == Ctx->ResumePoint.FileOffset) {
+        // all packets written before interruption has been read, continue by next packet
+        Ctx->Checkpoint = Staged->Progress;
+        Ctx->CheckpointSaved = Ctx->PacketCnt;
+        Ctx->ResumePoint.Packets = 0;
+    } else {
+        iqrfPgmCheckpointRestart(Ctx);
+    }
+    return(true);
+}
+
+/**
+ * Code file differs from interrupted one, write it from the beginning
+ */
+void iqrfPgmCheckpointRestart(IQRF_PGM_CONTEXT *Ctx)
+{
+    iqrfPgmCtxInitPacketReader(Ctx);
+    Ctx->PacketCnt = 0;
+    Ctx->PacketHash = 0x811C9DC5UL;
+    Ctx->Stats.PacketsResumed = 0;
+    Ctx->ResumePoint.Packets = 0;
+}
+
+/**
+ * Remember progress of programming after the packet sent to TR module has been written
+ */
+void iqrfPgmCheckpointCommit(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (!Ctx->SentProgress.Packets)
+        return;
+    Ctx->Checkpoint = Ctx->SentProgress;
+    Ctx->SentProgress.Packets = 0;
+#if IQRF_PGM_CHECKPOINT_INTERVAL
+    if (Ctx->Checkpoint.Packets - Ctx->CheckpointSaved >= IQRF_PGM_CHECKPOINT_INTERVAL)
+        iqrfPgmCheckpointSave(Ctx, true);
+#endif
+}
+
+/**
+ * Store checkpoint of programming to persistent storage
+ * @param Valid true = store progress of programming, false = remove checkpoint
+ * @note Record contains header (magic, version, size of data) and little-endian fields of checkpoint,
+ *       removed checkpoint is a record of zeros
+ */
+void iqrfPgmCheckpointSave(IQRF_PGM_CONTEXT *Ctx, uint8_t Valid)
+{
+    uint8_t Record[IQRF_PGM_CHECKPOINT_HEADER_SIZE + IQRF_PGM_CHECKPOINT_DATA_SIZE];
+    uint8_t *Data = &Record[IQRF_PGM_CHECKPOINT_HEADER_SIZE];
+
+    if (!Ctx->CheckpointName[0])
+        return;
+    memset(Record, 0, sizeof(Record));
+    if (Valid) {
+        memcpy(Record, IQRF_PGM_CHECKPOINT_MAGIC, 4);
+        Record[4] = IQRF_PGM_CHECKPOINT_VERSION;
+        Record[5] = IQRF_PGM_CHECKPOINT_DATA_SIZE;
+        iqrfPgmPutLe(&Data[0], Ctx->Checkpoint.FileSize, 4);
+        Data[4] = Ctx->Checkpoint.FileType;
+        iqrfPgmPutLe(&Data[5], Ctx->Checkpoint.Packets, 2);
+        iqrfPgmPutLe(&Data[7], Ctx->Checkpoint.Address, 2);
+        iqrfPgmPutLe(&Data[9], Ctx->Checkpoint.FileOffset, 4);
+        iqrfPgmPutLe(&Data[13], Ctx->Checkpoint.Hash, 4);
+    }
+    iqrfSuspendDriver();
+    iqrfWriteStorage(Ctx->CheckpointName, 0, Record, sizeof(Record));
+    iqrfRunDriver();
+    Ctx->CheckpointSaved = Valid ? Ctx->Checkpoint.Packets : 0;
+}
+
+/**
+ * Read checkpoint of interrupted programming from persistent storage to Ctx->ResumePoint
+ * @return true = valid checkpoint read, false = no checkpoint or record of other format
+ */
+uint8_t iqrfPgmCheckpointLoad(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint8_t Record[IQRF_PGM_CHECKPOINT_HEADER_SIZE + IQRF_PGM_CHECKPOINT_DATA_SIZE];
+    uint8_t *Data = &Record[IQRF_PGM_CHECKPOINT_HEADER_SIZE];
+    uint16_t Size;
+
+    iqrfSuspendDriver();
+    Size = iqrfReadStorage(Ctx->CheckpointName, 0, Record, sizeof(Record));
+    iqrfRunDriver();
+    if (Size != sizeof(Record)
+        || memcmp(Record, IQRF_PGM_CHECKPOINT_MAGIC, 4) != 0
+        || Record[4] != IQRF_PGM_CHECKPOINT_VERSION
+        || Record[5] != IQRF_PGM_CHECKPOINT_DATA_SIZE)
+    {
+        return(false);
+    }
+    Ctx->ResumePoint.FileSize = iqrfPgmGetLe(&Data[0], 4);
+    Ctx->ResumePoint.FileType = Data[4];
+    Ctx->ResumePoint.Packets = (uint16_t)iqrfPgmGetLe(&Data[5], 2);
+    Ctx->ResumePoint.Address = (uint16_t)iqrfPgmGetLe(&Data[7], 2);
+    Ctx->ResumePoint.FileOffset = iqrfPgmGetLe(&Data[9], 4);
+    Ctx->ResumePoint.Hash = iqrfPgmGetLe(&Data[13], 4);
+    return(true);
+}
+
+/**
+ * Store number to buffer in little-endian byte order
+ * @param Buffer pointer to destination buffer
+ * @param Value stored number
+ * @param Size number of bytes (1 to 4)
+ */
+void iqrfPgmPutLe(uint8_t *Buffer, uint32_t Value, uint8_t Size)
+{
+    for (uint8_t Cnt=0; Cnt<Size; Cnt++) {
+        Buffer[Cnt] = Value & 0xFF;
+        Value >>= 8;
+    }
+}
+
+/**
+ * Read number stored in little-endian byte order
+ * @param Buffer pointer to source buffer
+ * @param Size number of bytes (1 to 4)
+ * @return number
+ */
+uint32_t iqrfPgmGetLe(const uint8_t *Buffer, uint8_t Size)
+{
+    uint32_t Value = 0;
+
+    while (Size--)
+        Value = (Value << 8) | Buffer[Size];
+    return(Value);
+}
+
+/**
+ * Initialize reading of programming packets from the beginning of code file
+ */
+void iqrfPgmCtxInitPacketReader(IQRF_PGM_CONTEXT *Ctx)
+{
+    Ctx->FileInfo->FileByteCnt = 0;
+    iqrfPgmResetFileBuffer(Ctx);
+    Ctx->FileHashing = false;
+    Ctx->MemBlock.HiAddress = 0;
+    Ctx->MemBlock.DataInBufferReady = 0;
+    Ctx->MemBlock.DataOverflow = 0;
+    Ctx->MemBlock.MemoryBlockProcessState = 0;
+    Ctx->ImagePacketCnt = 0;
+    Ctx->ImageHeaderRead = 0;
+    Ctx->ImageHash = 0x811C9DC5UL;
+    memset(Ctx->BlockMap.Present, 0, sizeof(Ctx->BlockMap.Present));
+    Ctx->BlockMap.Active = true;
+    Ctx->BlockMap.Flushing = 0;
+    Ctx->BlockMap.Index = 0;
+    Ctx->BlockMap.Blocks = 0;
+    Ctx->BlockMap.Flushed = 0;
+}
+
+/**
+ * Read next programming packet from code file
+ * @param Packet pointer to structure, where SPI command, data and size of the packet will be stored
+ * @return Return code (IQRF_PGM_FILE_DATA_READY - packet ready, IQRF_PGM_FILE_DATA_ERROR - code file format error, IQRF_PGM_END_OF_FILE - end of file)
+ */
+uint8_t iqrfPgmCtxPreparePacket(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet)
+{
+    uint8_t Result;
+
+    // whole HEX file is read to block map at once
+    while ((Result = iqrfPgmPreparePacketStep(Ctx, Packet)) == IQRF_PGM_FILE_DATA_PENDING)
+        ;   /* void */
+    return(Result);
+}
+
+/**
+ * Read next programming packet from code file, HEX file is read to block map in bounded steps
+ * @param Packet pointer to structure, where SPI command, data and size of the packet will be stored
+ * @return Return code (IQRF_PGM_FILE_DATA_READY - packet ready, IQRF_PGM_FILE_DATA_ERROR - code file format error,
+ *         IQRF_PGM_END_OF_FILE - end of file, IQRF_PGM_FILE_DATA_PENDING - no packet yet, call again)
+ */
+uint8_t iqrfPgmPreparePacketStep(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet)
+{
+    uint8_t OperationResult;
+    uint8_t Cnt;
+
+    switch (Ctx->FileInfo->FileType) {
+    case IQRF_PGM_PLUGIN_FILE_TYPE:
+        // one line of *.IQRF file is one plugin packet
+        Packet->SpiCmd = SPI_PLUGIN_PGM;
+        Packet->Data = Ctx->CodeLineBuffer;
+        Packet->Length = 20;
+        return(iqrfPgmReadIQRFFileLine(Ctx));
+
+    case IQRF_PGM_IMAGE_FILE_TYPE:
+        // packets are stored in image file ready to send
+        return(iqrfPgmReadImageRecord(Ctx, Packet));
+
+    case IQRF_PGM_PASS_FILE_TYPE:
+    case IQRF_PGM_KEY_FILE_TYPE:
+        // 16 bytes of user password or user key are written by one EEPROM packet
+        if (Ctx->FileInfo->FileByteCnt)
+            return(IQRF_PGM_END_OF_FILE);
+        if (Ctx->FileInfo->FileSize != 16)
+            return(IQRF_PGM_FILE_DATA_ERROR);
+        Ctx->MemBlock.MemoryBlock[0] = (Ctx->FileInfo->FileType == IQRF_PGM_PASS_FILE_TYPE) ? 0xD0 : 0xD1;
+        Ctx->MemBlock.MemoryBlock[1] = 0x10;
+        for (Cnt=0; Cnt<16; Cnt++)
+            Ctx->MemBlock.MemoryBlock[Cnt + 2] = iqrfPgmReadFileByte(Ctx);
+        Packet->SpiCmd = SPI_EEPROM_PGM;
+        Packet->Data = &Ctx->MemBlock.MemoryBlock[0];
+        Packet->Length = 16 + 2;
+        return(IQRF_PGM_FILE_DATA_READY);
+
+    default:
+        // if image of memory block has been sent, prepare next one
+        if (Ctx->MemBlock.MemoryBlockProcessState == 0) {
+            if (Ctx->FileInfo->FileType == IQRF_PGM_HEX_FILE_TYPE)
+                OperationResult = iqrfPgmPrepareMappedBlock(Ctx);
+            else
+                OperationResult = iqrfPgmProcessCfgFile(Ctx);
+            if (OperationResult == IQRF_PGM_SUCCESS)
+                return(IQRF_PGM_END_OF_FILE);
+            if (OperationResult == IQRF_PGM_BLOCK_PENDING)
+                return(IQRF_PGM_FILE_DATA_PENDING);
+            if (OperationResult != IQRF_PGM_FLASH_BLOCK_READY && OperationResult != IQRF_PGM_EEPROM_BLOCK_READY)
+                return(IQRF_PGM_FILE_DATA_ERROR);
+            Ctx->MemBlock.MemoryBlockType = OperationResult;
+        }
+
+        if (Ctx->MemBlock.MemoryBlockType == IQRF_PGM_FLASH_BLOCK_READY) {
+            Packet->SpiCmd = SPI_FLASH_PGM;
+            // image of flash block is written in 2 packets, image of EEPROM block in 1 packet
+            if (Ctx->MemBlock.MemoryBlockProcessState == 2)
+                Packet->Data = &Ctx->MemBlock.MemoryBlock[0];
+            else
+                Packet->Data = &Ctx->MemBlock.MemoryBlock[34];
+            Packet->Length = 32 + 2;
+        } else {
+            Packet->SpiCmd = SPI_EEPROM_PGM;
+            Packet->Data = &Ctx->MemBlock.MemoryBlock[0];
+            Packet->Length = Ctx->MemBlock.MemoryBlock[1] + 2;
+        }
+        Ctx->MemBlock.MemoryBlockProcessState--;
+        return(IQRF_PGM_FILE_DATA_READY);
+    }
+}
+
+/**
+ * Read one packet record from binary block image file
+ * @param Packet pointer to structure, where SPI command, data and size of the packet will be stored
+ * @return Return code (IQRF_PGM_FILE_DATA_READY - packet ready, IQRF_PGM_FILE_DATA_ERROR - image format error, IQRF_PGM_END_OF_FILE - end of image)
+ * @note End of image is reported only if the trailer matches hash of all previous bytes and no data follow it,
+ *       so truncated image or image with reordered records fails the check pass before anything is written
+ */
+uint8_t iqrfPgmReadImageRecord(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet)
+{
+    uint32_t Hash;
+    uint8_t Checksum;
+    uint8_t Cnt;
+
+    // check image header
+    if (!Ctx->ImageHeaderRead) {
+        for (Cnt=0; Cnt<IQRF_PGM_IMAGE_HEADER_SIZE; Cnt++)
+            Ctx->MemBlock.MemoryBlock[Cnt] = iqrfPgmReadImageByte(Ctx);
+        if (memcmp(Ctx->MemBlock.MemoryBlock, IQRF_PGM_IMAGE_MAGIC, 4) != 0
+            || Ctx->MemBlock.MemoryBlock[4] != IQRF_PGM_IMAGE_VERSION)
+        {
+            return(IQRF_PGM_FILE_DATA_ERROR);
+        }
+        Ctx->ImagePacketCnt = ((uint16_t)Ctx->MemBlock.MemoryBlock[7] << 8) | Ctx->MemBlock.MemoryBlock[6];
+        Ctx->ImageHeaderRead = 1;
+    }
+
+    // all packets read, check trailer
+    if (Ctx->ImagePacketCnt == 0) {
+        if (Ctx->ImageHeaderRead == 1) {
+            Hash = Ctx->ImageHash;
+            for (Cnt=0; Cnt<IQRF_PGM_IMAGE_TRAILER_SIZE; Cnt++)
+                Ctx->MemBlock.MemoryBlock[Cnt] = iqrfPgmReadFileByte(Ctx);
+            if (iqrfPgmGetLe(Ctx->MemBlock.MemoryBlock, IQRF_PGM_IMAGE_TRAILER_SIZE) != Hash
+                || Ctx->FileInfo->FileByteCnt != Ctx->FileInfo->FileSize)
+            {
+                return(IQRF_PGM_FILE_DATA_ERROR);
+            }
+            Ctx->ImageHeaderRead = 2;
+        }
+        return(IQRF_PGM_END_OF_FILE);
+    }
+
+    // read record header (SPI command and size of packet data)
+    Packet->SpiCmd = iqrfPgmReadImageByte(Ctx);
+    Packet->Length = iqrfPgmReadImageByte(Ctx);
+    Packet->Data = Ctx->MemBlock.MemoryBlock;
+    switch (Packet->SpiCmd) {
+    case SPI_FLASH_PGM:
+        if (Packet->Length != 32 + 2)
+            return(IQRF_PGM_FILE_DATA_ERROR);
+        break;
+    case SPI_EEPROM_PGM:
+        if (Packet->Length < 3 || Packet->Length > 32 + 2)
+            return(IQRF_PGM_FILE_DATA_ERROR);
+        break;
+    case SPI_PLUGIN_PGM:
+        if (Packet->Length != 20)
+            return(IQRF_PGM_FILE_DATA_ERROR);
+        break;
+    default:
+        return(IQRF_PGM_FILE_DATA_ERROR);
+    }
+
+    // read packet data and check record checksum
+    Checksum = Packet->SpiCmd + Packet->Length;
+    for (Cnt=0; Cnt<Packet->Length; Cnt++) {
+        Ctx->MemBlock.MemoryBlock[Cnt] = iqrfPgmReadImageByte(Ctx);
+        Checksum += Ctx->MemBlock.MemoryBlock[Cnt];
+    }
+    Checksum += iqrfPgmReadImageByte(Ctx);
+    if (Checksum != 0)
+        return(IQRF_PGM_FILE_DATA_ERROR);
+
+    Ctx->ImagePacketCnt--;
+    return(IQRF_PGM_FILE_DATA_READY);
+}
+
+/**
+ * Read one byte of header or packet records of binary block image and add it to hash of the image
+ * @return byte from image or 0 = end of file
+ */
+uint8_t iqrfPgmReadImageByte(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint8_t Byte = iqrfPgmReadFileByte(Ctx);
+
+    Ctx->ImageHash = iqrfPgmHash(Ctx->ImageHash, &Byte, 1);
+    return(Byte);
 }
 
 /**
@@ -270,36 +1309,38 @@ uint8_t iqrfPgmWriteCodeFile(void)
  * @param Buffer pointer to 16 byte buffer with user password or user key
  * @return result of partial programming operation
  */
-uint8_t iqrfPgmWriteKeyOrPass(uint8_t BufferContent, uint8_t *Buffer)
+uint8_t iqrfPgmCtxWriteKeyOrPass(IQRF_PGM_CONTEXT *Ctx, uint8_t BufferContent, uint8_t *Buffer)
 {
-    static enum {
+    enum {
         INIT_TASK = 0,
         ENTER_PROG_MODE,
         WAIT_PROG_MODE,
         WAIT_PROG_END,
         PROG_END,
-    } WriteCodeTaskSM = INIT_TASK;
-
-    static uint8_t Attempts;
-    static uint8_t OperationResult;
-    static uint32_t SysTickTime;
+    };
 
-   	switch (WriteCodeTaskSM) {
+   	switch (Ctx->TaskSM) {
     case INIT_TASK:     // initialize programming state machine
-        Attempts = 1;
+        // wait until other context releases TR module
+        if (!iqrfPgmClaimTr(Ctx))
+            break;
+        Ctx->Attempts = 1;
         if (BufferContent == IQRF_PGM_PASS_FILE_TYPE)
-            PrepareMemBlock.MemoryBlock[0] = 0xD0;
+            Ctx->MemBlock.MemoryBlock[0] = 0xD0;
         else
-            PrepareMemBlock.MemoryBlock[0] = 0xD1;
-        PrepareMemBlock.MemoryBlock[1] = 0x10;
-        memcpy((uint8_t *)&PrepareMemBlock.MemoryBlock[2], Buffer, 0x10);
-        WriteCodeTaskSM = ENTER_PROG_MODE;
+            Ctx->MemBlock.MemoryBlock[0] = 0xD1;
+        Ctx->MemBlock.MemoryBlock[1] = 0x10;
+        memcpy((uint8_t *)&Ctx->MemBlock.MemoryBlock[2], Buffer, 0x10);
+        Ctx->TaskSM = ENTER_PROG_MODE;
         break;
 
     case ENTER_PROG_MODE:
+        // entry time includes repeated attempts
+        if (Ctx->Attempts)
+            Ctx->PgmModeStartTime = iqrfGetSysTick();
         iqrfTrEnterPgmMode();
-        SysTickTime = iqrfGetSysTick();
-        WriteCodeTaskSM = WAIT_PROG_MODE;
+        Ctx->SysTickTime = iqrfGetSysTick();
+        Ctx->TaskSM = WAIT_PROG_MODE;
         break;
 
     case WAIT_PROG_MODE:      // wait for TR module programming mode
@@ -307,37 +1348,45 @@ uint8_t iqrfPgmWriteKeyOrPass(uint8_t BufferContent, uint8_t *Buffer)
             && iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE
             && iqrfGetLibraryStatus() == IQRF_READY)
         {
+            Ctx->Stats.PgmModeEntryTime = (uint32_t)(iqrfGetSysTick() - Ctx->PgmModeStartTime) * 1000 / TICKS_IN_SECOND;
             // send USER PASSWORD or USER KEY to TR module
-            iqrfSendPacket(SPI_EEPROM_PGM, (uint8_t *)&PrepareMemBlock.MemoryBlock[0], PrepareMemBlock.MemoryBlock[1] + 2);
-            OperationResult = IQRF_PGM_SUCCESS;
-            WriteCodeTaskSM = WAIT_PROG_END;            // go to end programming mode
+            iqrfSendPacket(SPI_EEPROM_PGM, (uint8_t *)&Ctx->MemBlock.MemoryBlock[0], Ctx->MemBlock.MemoryBlock[1] + 2);
+            Ctx->TaskSM = WAIT_PROG_END;            // go to end programming mode
         } else {
-            if (iqrfGetSysTick() - SysTickTime >= (TICKS_IN_SECOND / 2)) {
+            if (iqrfGetSysTick() - Ctx->SysTickTime >= IQRF_PGM_MODE_WAIT_TIMEOUT) {
                 // in a case, try it twice to enter programming mode
-                if (Attempts) {
-                    Attempts--;
-                    WriteCodeTaskSM = ENTER_PROG_MODE;
+                if (Ctx->Attempts) {
+                    Ctx->Attempts--;
+                    Ctx->TaskSM = ENTER_PROG_MODE;
                 } else {
                     // TR module probably does not work
-                    OperationResult = IQRF_PGM_ERROR;
-                    WriteCodeTaskSM = PROG_END;
+                    Ctx->OperationResult = IQRF_PGM_ERROR;
+                    Ctx->TaskSM = PROG_END;
                 }
             }
         }
         break;
 
     case WAIT_PROG_END:     // wait until last packet is written to TR module
-        if (iqrfGetSpiStatus() == PROGRAMMING_MODE && iqrfGetLibraryStatus() == IQRF_READY) {
+        if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE
+            && iqrfGetSpiStatus() == PROGRAMMING_MODE
+            && iqrfGetLibraryStatus() == IQRF_READY)
+        {
+            if (iqrfGetPacketResult() == IQRF_PACKET_OK)
+                Ctx->OperationResult = IQRF_PGM_SUCCESS;
+            else
+                Ctx->OperationResult = IQRF_PGM_ERROR;
             iqrfTrEndPgmMode();
-            WriteCodeTaskSM = PROG_END;                           // go to end programming mode
+            Ctx->TaskSM = PROG_END;                           // go to end programming mode
         }
         break;
 
     case PROG_END:
         // if no packet is pending to send to TR module
         if (iqrfGetTxBufferStatus() == IQRF_BUFFER_FREE && iqrfGetLibraryStatus() == IQRF_READY) {
-            WriteCodeTaskSM = INIT_TASK;
-            return(OperationResult);
+            iqrfPgmReleaseTr(Ctx);
+            Ctx->TaskSM = INIT_TASK;
+            return(Ctx->OperationResult);
         }
         break;
     }
@@ -350,48 +1399,49 @@ uint8_t iqrfPgmWriteKeyOrPass(uint8_t BufferContent, uint8_t *Buffer)
  * @param none
  * @return result of config data preparing operation
  */
-uint8_t iqrfPgmProcessCfgFile(void)
+uint8_t iqrfPgmProcessCfgFile(IQRF_PGM_CONTEXT *Ctx)
 {
     // prepare image of 32byte configuration block to flash memory
-    if (PrepareMemBlock.DataInBufferReady == 0) {
+    if (Ctx->MemBlock.DataInBufferReady == 0) {
+        // configuration file contains 32 bytes of configuration and RFPGM byte
+        if (Ctx->FileInfo->FileSize < 33)
+            return(IQRF_PGM_ERROR);
         // initialize block address
-        PrepareMemBlock.MemoryBlock[0] = IQRF_CONFIG_MEM_L_ADR & 0x00FF;
-        PrepareMemBlock.MemoryBlock[1] = IQRF_CONFIG_MEM_L_ADR >> 8;
-        PrepareMemBlock.MemoryBlock[34] = IQRF_CONFIG_MEM_H_ADR & 0x00FF;
-        PrepareMemBlock.MemoryBlock[35] = IQRF_CONFIG_MEM_H_ADR >> 8;;
-        PrepareMemBlock.MemoryBlockProcessState = 2;
+        Ctx->MemBlock.MemoryBlock[0] = IQRF_CONFIG_MEM_L_ADR & 0x00FF;
+        Ctx->MemBlock.MemoryBlock[1] = IQRF_CONFIG_MEM_L_ADR >> 8;
+        Ctx->MemBlock.MemoryBlock[34] = IQRF_CONFIG_MEM_H_ADR & 0x00FF;
+        Ctx->MemBlock.MemoryBlock[35] = IQRF_CONFIG_MEM_H_ADR >> 8;;
+        Ctx->MemBlock.MemoryBlockProcessState = 2;
         // read configuration data from file
-        iqrfSuspendDriver();
         for (uint8_t Cnt=0; Cnt<32; Cnt++) {
             if (Cnt < 16){
                 // first half of configuration
-                PrepareMemBlock.MemoryBlock[Cnt*2 + 2] = iqrfReadByteFromFile();
-                PrepareMemBlock.MemoryBlock[Cnt*2 + 3] = 0x34;
+                Ctx->MemBlock.MemoryBlock[Cnt*2 + 2] = iqrfPgmReadFileByte(Ctx);
+                Ctx->MemBlock.MemoryBlock[Cnt*2 + 3] = 0x34;
             } else {
                 // second half of configuration
-                PrepareMemBlock.MemoryBlock[Cnt*2 + 4] = iqrfReadByteFromFile();
-                PrepareMemBlock.MemoryBlock[Cnt*2 + 5] = 0x34;
+                Ctx->MemBlock.MemoryBlock[Cnt*2 + 4] = iqrfPgmReadFileByte(Ctx);
+                Ctx->MemBlock.MemoryBlock[Cnt*2 + 5] = 0x34;
             }
         }
         // store last configuration byte for next packet
-        PrepareMemBlock.MemoryBlockNumber = iqrfReadByteFromFile();
-        iqrfRunDriver();
+        Ctx->MemBlock.MemoryBlockNumber = iqrfPgmReadFileByte(Ctx);
 
-        PrepareMemBlock.DataInBufferReady = 1;
+        Ctx->MemBlock.DataInBufferReady = 1;
         return(IQRF_PGM_FLASH_BLOCK_READY);
     } else {
         // prepare packet for RFPGM configuration
-        if (PrepareMemBlock.DataInBufferReady == 1) {
-            PrepareMemBlock.MemoryBlock[0] = RFPGM_CFG_ADR;
-            PrepareMemBlock.MemoryBlock[1] = 0x01;
-            PrepareMemBlock.MemoryBlock[2] = PrepareMemBlock.MemoryBlockNumber;
-            PrepareMemBlock.MemoryBlockProcessState = 1;
+        if (Ctx->MemBlock.DataInBufferReady == 1) {
+            Ctx->MemBlock.MemoryBlock[0] = RFPGM_CFG_ADR;
+            Ctx->MemBlock.MemoryBlock[1] = 0x01;
+            Ctx->MemBlock.MemoryBlock[2] = Ctx->MemBlock.MemoryBlockNumber;
+            Ctx->MemBlock.MemoryBlockProcessState = 1;
 
-            PrepareMemBlock.DataInBufferReady = 2;
+            Ctx->MemBlock.DataInBufferReady = 2;
             return(IQRF_PGM_EEPROM_BLOCK_READY);
         } else {
             // configuration programming successfully ended
-            PrepareMemBlock.DataInBufferReady = 0;
+            Ctx->MemBlock.DataInBufferReady = 0;
             return(IQRF_PGM_SUCCESS);
         }
     }
@@ -400,22 +1450,22 @@ uint8_t iqrfPgmProcessCfgFile(void)
 /**
  * Move overflowed data to active block ready to programming
  */
-void iqrfPgmMoveOverflowedData(void)
+void iqrfPgmMoveOverflowedData(IQRF_PGM_CONTEXT *Ctx)
 {
     uint16_t MemBlock;
     // move overflowed data to active block
-    memcpy((uint8_t *)&PrepareMemBlock.MemoryBlock[34], (uint8_t *)&PrepareMemBlock.MemoryBlock[0], 34);
+    memcpy((uint8_t *)&Ctx->MemBlock.MemoryBlock[34], (uint8_t *)&Ctx->MemBlock.MemoryBlock[0], 34);
     // clear block of memory for overflowed data
-    memset((uint8_t *)&PrepareMemBlock.MemoryBlock[0], 0, 34);
+    memset((uint8_t *)&Ctx->MemBlock.MemoryBlock[0], 0, 34);
     // calculate the data block index
-    MemBlock = ((uint16_t)PrepareMemBlock.MemoryBlock[35] << 8) | PrepareMemBlock.MemoryBlock[34];
-    PrepareMemBlock.MemoryBlockNumber = MemBlock + 0x10;
+    MemBlock = ((uint16_t)Ctx->MemBlock.MemoryBlock[35] << 8) | Ctx->MemBlock.MemoryBlock[34];
+    Ctx->MemBlock.MemoryBlockNumber = MemBlock + 0x10;
     MemBlock++;
-    PrepareMemBlock.MemoryBlock[0] = MemBlock & 0x00FF;         // write next block index to image
-    PrepareMemBlock.MemoryBlock[1] = MemBlock >> 8;
-    PrepareMemBlock.DataOverflow = 0;
+    Ctx->MemBlock.MemoryBlock[0] = MemBlock & 0x00FF;         // write next block index to image
+    Ctx->MemBlock.MemoryBlock[1] = MemBlock >> 8;
+    Ctx->MemBlock.DataOverflow = 0;
     // initialize block process counter (block will be written to TR module in 1 write packet)
-    PrepareMemBlock.MemoryBlockProcessState = 1;
+    Ctx->MemBlock.MemoryBlockProcessState = 1;
 }
 
 /**
@@ -423,7 +1473,7 @@ void iqrfPgmMoveOverflowedData(void)
  * @param none
  * @return result of data preparing operation
  */
-uint8_t iqrfPgmPrepareMemBlock(void)
+uint8_t iqrfPgmPrepareMemBlock(IQRF_PGM_CONTEXT *Ctx)
 {
     uint16_t MemBlock;
     uint8_t DataCounter;
@@ -433,31 +1483,30 @@ uint8_t iqrfPgmPrepareMemBlock(void)
     uint8_t Cnt;
 
     // initialize memory block for flash programming
-    if (!PrepareMemBlock.DataOverflow) {
-        for (Cnt=0; Cnt<sizeof(PrepareMemBlock.MemoryBlock); Cnt+=2) {
-            PrepareMemBlock.MemoryBlock[Cnt] = 0xFF;
-            PrepareMemBlock.MemoryBlock[Cnt+1] = 0x3F;
+    Ctx->MemBlock.WordMask = 0;
+    if (!Ctx->MemBlock.DataOverflow) {
+        for (Cnt=0; Cnt<sizeof(Ctx->MemBlock.MemoryBlock); Cnt+=2) {
+            Ctx->MemBlock.MemoryBlock[Cnt] = 0xFF;
+            Ctx->MemBlock.MemoryBlock[Cnt+1] = 0x3F;
         }
     }
-    PrepareMemBlock.MemoryBlockNumber = 0;
+    Ctx->MemBlock.MemoryBlockNumber = 0;
 
     while(1) {
         // if no data ready in file buffer
-        if (!PrepareMemBlock.DataInBufferReady) {
-            iqrfSuspendDriver();
-            OperationResult = iqrfPgmReadHEXFileLine();       // read one line from HEX file
-            iqrfRunDriver();
+        if (!Ctx->MemBlock.DataInBufferReady) {
+            OperationResult = iqrfPgmReadHEXFileLine(Ctx);       // read one line from HEX file
             // check result of file reading operation
             if (OperationResult == IQRF_PGM_FILE_DATA_ERROR) {
                 return(IQRF_PGM_ERROR);
             } else {
                 if (OperationResult == IQRF_PGM_END_OF_FILE) {
                     // if any data are ready to programm to FLASH
-                    if (PrepareMemBlock.MemoryBlockNumber) {
+                    if (Ctx->MemBlock.MemoryBlockNumber) {
                         return(IQRF_PGM_FLASH_BLOCK_READY);
                     } else {
-                        if (PrepareMemBlock.DataOverflow) {
-                            iqrfPgmMoveOverflowedData();
+                        if (Ctx->MemBlock.DataOverflow) {
+                            iqrfPgmMoveOverflowedData(Ctx);
                             return(IQRF_PGM_FLASH_BLOCK_READY);
                         } else {
                             return(IQRF_PGM_SUCCESS);
@@ -465,119 +1514,119 @@ uint8_t iqrfPgmPrepareMemBlock(void)
                     }
                 }
             }
-            PrepareMemBlock.DataInBufferReady = 1;            // set flag, data ready in file buffer
+            Ctx->MemBlock.DataInBufferReady = 1;            // set flag, data ready in file buffer
         }
 
-        if (IqrfPgmCodeLineBuffer[3] == 0) {                   // data block ready in file buffer
+        if (Ctx->CodeLineBuffer[3] == 0) {                   // data block ready in file buffer
             // read destination address for data in buffer
-            PrepareMemBlock.Address = (PrepareMemBlock.HiAddress
-                + ((uint16_t)IqrfPgmCodeLineBuffer[1] << 8)
-                + IqrfPgmCodeLineBuffer[2]) / 2;
+            Ctx->MemBlock.Address = (Ctx->MemBlock.HiAddress
+                + ((uint16_t)Ctx->CodeLineBuffer[1] << 8)
+                + Ctx->CodeLineBuffer[2]) / 2;
 
-            if (PrepareMemBlock.DataOverflow)
-                iqrfPgmMoveOverflowedData();
+            if (Ctx->MemBlock.DataOverflow)
+                iqrfPgmMoveOverflowedData(Ctx);
             // data for external serial EEPROM
-            if (PrepareMemBlock.Address >= SERIAL_EEPROM_MIN_ADR && PrepareMemBlock.Address <= SERIAL_EEPROM_MAX_ADR) {
+            if (Ctx->MemBlock.Address >= SERIAL_EEPROM_MIN_ADR && Ctx->MemBlock.Address <= SERIAL_EEPROM_MAX_ADR) {
                 // if image of data block is not initialized
-                if (PrepareMemBlock.MemoryBlockNumber == 0) {
-                    MemBlock = (PrepareMemBlock.Address - 0x200) / 32;          // calculate data block index
-                    memset((uint8_t *)&PrepareMemBlock.MemoryBlock[0], 0, 68);  // clear image of data block
-                    PrepareMemBlock.MemoryBlock[34] = MemBlock & 0x00FF;        // write block index to image
-                    PrepareMemBlock.MemoryBlock[35] = MemBlock >> 8;
+                if (Ctx->MemBlock.MemoryBlockNumber == 0) {
+                    MemBlock = (Ctx->MemBlock.Address - 0x200) / 32;          // calculate data block index
+                    memset((uint8_t *)&Ctx->MemBlock.MemoryBlock[0], 0, 68);  // clear image of data block
+                    Ctx->MemBlock.MemoryBlock[34] = MemBlock & 0x00FF;        // write block index to image
+                    Ctx->MemBlock.MemoryBlock[35] = MemBlock >> 8;
                     MemBlock++;                                                 // next block index
-                    PrepareMemBlock.MemoryBlock[0] = MemBlock & 0x00FF;         // write next block index to image
-                    PrepareMemBlock.MemoryBlock[1] = MemBlock >> 8;
-                    PrepareMemBlock.MemoryBlockNumber = PrepareMemBlock.Address / 32;   // remember actual memory block
+                    Ctx->MemBlock.MemoryBlock[0] = MemBlock & 0x00FF;         // write next block index to image
+                    Ctx->MemBlock.MemoryBlock[1] = MemBlock >> 8;
+                    Ctx->MemBlock.MemoryBlockNumber = Ctx->MemBlock.Address / 32;   // remember actual memory block
                     // initialize block process counter (block will be written to TR module in 1 write packet)
-                    PrepareMemBlock.MemoryBlockProcessState = 1;
+                    Ctx->MemBlock.MemoryBlockProcessState = 1;
                 }
 
-                MemBlock = PrepareMemBlock.Address / 32;                        // calculate actual memory block
+                MemBlock = Ctx->MemBlock.Address / 32;                        // calculate actual memory block
                 // calculate offset from start of image, where data to be written
-                DestinationIndex = (PrepareMemBlock.Address % 32) + 36;
-                DataCounter = IqrfPgmCodeLineBuffer[0] / 2;                     // read number of data bytes in file buffer
+                DestinationIndex = (Ctx->MemBlock.Address % 32) + 36;
+                DataCounter = Ctx->CodeLineBuffer[0] / 2;                     // read number of data bytes in file buffer
 
                 // if data in file buffer are from different memory block, write actual image to TR module
-                if (PrepareMemBlock.MemoryBlockNumber != MemBlock)
+                if (Ctx->MemBlock.MemoryBlockNumber != MemBlock)
                     return(IQRF_PGM_FLASH_BLOCK_READY);
 
                 // check if all data are inside the image of data block
-                if (DestinationIndex + DataCounter > sizeof(PrepareMemBlock.MemoryBlock))
-                    PrepareMemBlock.DataOverflow = 1;
+                if (DestinationIndex + DataCounter > sizeof(Ctx->MemBlock.MemoryBlock))
+                    Ctx->MemBlock.DataOverflow = 1;
                 // copy data from file buffer to image of data block
                 for (uint8_t Cnt=0; Cnt < DataCounter; Cnt++) {
-                    PrepareMemBlock.MemoryBlock[DestinationIndex++] = IqrfPgmCodeLineBuffer[2*Cnt+4];
+                    Ctx->MemBlock.MemoryBlock[DestinationIndex++] = Ctx->CodeLineBuffer[2*Cnt+4];
                     if (DestinationIndex == 68)
                         DestinationIndex = 2;
                 }
 
-                if (PrepareMemBlock.DataOverflow) {
-                    PrepareMemBlock.DataInBufferReady = 0;                      // process next line from HEX file
+                if (Ctx->MemBlock.DataOverflow) {
+                    Ctx->MemBlock.DataInBufferReady = 0;                      // process next line from HEX file
                     return(IQRF_PGM_FLASH_BLOCK_READY);
                 }
             } else {  // check if data in file buffer are for other memory areas
-                MemBlock = PrepareMemBlock.Address / 32;                        // calculate actual memory block
+                MemBlock = Ctx->MemBlock.Address / 32;                        // calculate actual memory block
                 // calculate offset from start of image, where data to be written
-                DestinationIndex = (PrepareMemBlock.Address % 32) * 2;
+                DestinationIndex = (Ctx->MemBlock.Address % 32) * 2;
                 if (DestinationIndex < 32)
                     DestinationIndex += 2;
                 else
                     DestinationIndex += 4;
-                DataCounter = IqrfPgmCodeLineBuffer[0];                         // read number of data bytes in file buffer
+                DataCounter = Ctx->CodeLineBuffer[0];                         // read number of data bytes in file buffer
                 ValidAddress = 0;
 
                 // check if data in file buffer are for main FLASH memory area in TR module
-                if (PrepareMemBlock.Address >= IQRF_MAIN_MEM_MIN_ADR
-                    && PrepareMemBlock.Address <= IQRF_MAIN_MEM_MAX_ADR)
+                if (Ctx->MemBlock.Address >= IQRF_MAIN_MEM_MIN_ADR
+                    && Ctx->MemBlock.Address <= IQRF_MAIN_MEM_MAX_ADR)
                 {
                     ValidAddress = 1;                                           // set flag, data are for FLASH memory area
                     // check if all data are in main memory area
-                    if ((PrepareMemBlock.Address + DataCounter/2) > IQRF_MAIN_MEM_MAX_ADR)
-                        DataCounter = (IQRF_MAIN_MEM_MAX_ADR - PrepareMemBlock.Address) * 2;
+                    if ((Ctx->MemBlock.Address + DataCounter/2) > IQRF_MAIN_MEM_MAX_ADR)
+                        DataCounter = (IQRF_MAIN_MEM_MAX_ADR - Ctx->MemBlock.Address) * 2;
                     // check if all data are inside the image of data block
-                    if (DestinationIndex + DataCounter > sizeof(PrepareMemBlock.MemoryBlock))
+                    if (DestinationIndex + DataCounter > sizeof(Ctx->MemBlock.MemoryBlock))
                         return(IQRF_PGM_ERROR);
                     // if data in file buffer are from different memory block, write actual image to TR module
-                    if (PrepareMemBlock.MemoryBlockNumber)
-                        if (PrepareMemBlock.MemoryBlockNumber != MemBlock)
+                    if (Ctx->MemBlock.MemoryBlockNumber)
+                        if (Ctx->MemBlock.MemoryBlockNumber != MemBlock)
                             return(IQRF_PGM_FLASH_BLOCK_READY);
                 } else {
                     // check if data in file buffer are for licensed FLASH memory area in TR module
-                    if (PrepareMemBlock.Address >= IQRF_LICENCED_MEM_MIN_ADR
-                        && PrepareMemBlock.Address <= IQRF_LICENCED_MEM_MAX_ADR)
+                    if (Ctx->MemBlock.Address >= IQRF_LICENCED_MEM_MIN_ADR
+                        && Ctx->MemBlock.Address <= IQRF_LICENCED_MEM_MAX_ADR)
                     {
                         ValidAddress = 1;                                       // set flag, data are for FLASH memory area
                         // check if all data are in licensed memory area
-                        if ((PrepareMemBlock.Address + DataCounter/2) > IQRF_LICENCED_MEM_MAX_ADR)
-                            DataCounter = (IQRF_LICENCED_MEM_MAX_ADR - PrepareMemBlock.Address) * 2;
+                        if ((Ctx->MemBlock.Address + DataCounter/2) > IQRF_LICENCED_MEM_MAX_ADR)
+                            DataCounter = (IQRF_LICENCED_MEM_MAX_ADR - Ctx->MemBlock.Address) * 2;
                         // check if all data are inside the image of data block
-                        if (DestinationIndex + DataCounter > sizeof(PrepareMemBlock.MemoryBlock))
+                        if (DestinationIndex + DataCounter > sizeof(Ctx->MemBlock.MemoryBlock))
                             return(IQRF_PGM_ERROR);
                         // if data in file buffer are from different memory block, write actual image to TR module
-                        if (PrepareMemBlock.MemoryBlockNumber)
-                            if (PrepareMemBlock.MemoryBlockNumber != MemBlock)
+                        if (Ctx->MemBlock.MemoryBlockNumber)
+                            if (Ctx->MemBlock.MemoryBlockNumber != MemBlock)
                                 return(IQRF_PGM_FLASH_BLOCK_READY);
                     } else {
                         // check if data in file buffer are for internal EEPROM of TR module
-                        if (PrepareMemBlock.Address >= PIC16LF1938_EEPROM_MIN
-                            && PrepareMemBlock.Address <= PIC16LF1938_EEPROM_MAX)
+                        if (Ctx->MemBlock.Address >= PIC16LF1938_EEPROM_MIN
+                            && Ctx->MemBlock.Address <= PIC16LF1938_EEPROM_MAX)
                         {
                             // if image of data block contains any data, write it to TR module
-                            if (PrepareMemBlock.MemoryBlockNumber)
+                            if (Ctx->MemBlock.MemoryBlockNumber)
                                 return(IQRF_PGM_FLASH_BLOCK_READY);
                             // prepare image of data block for internal EEPROM
-                            PrepareMemBlock.MemoryBlock[0] = PrepareMemBlock.Address & 0x00FF;
-                            PrepareMemBlock.MemoryBlock[1] = DataCounter / 2;
-                            if (PrepareMemBlock.Address + PrepareMemBlock.MemoryBlock[1] > PIC16LF1938_EEPROM_MAX
-                                || PrepareMemBlock.MemoryBlock[1] > 32)
+                            Ctx->MemBlock.MemoryBlock[0] = Ctx->MemBlock.Address & 0x00FF;
+                            Ctx->MemBlock.MemoryBlock[1] = DataCounter / 2;
+                            if (Ctx->MemBlock.Address + Ctx->MemBlock.MemoryBlock[1] > PIC16LF1938_EEPROM_MAX
+                                || Ctx->MemBlock.MemoryBlock[1] > 32)
                             {
                                 return(IQRF_PGM_ERROR);
                             }
-                            for (uint8_t Cnt=0; Cnt < PrepareMemBlock.MemoryBlock[1]; Cnt++)
-                                PrepareMemBlock.MemoryBlock[Cnt+2] = IqrfPgmCodeLineBuffer[2*Cnt+4];
-                            PrepareMemBlock.DataInBufferReady = 0;
+                            for (uint8_t Cnt=0; Cnt < Ctx->MemBlock.MemoryBlock[1]; Cnt++)
+                                Ctx->MemBlock.MemoryBlock[Cnt+2] = Ctx->CodeLineBuffer[2*Cnt+4];
+                            Ctx->MemBlock.DataInBufferReady = 0;
                             // initialize block process counter (block will be written to TR module in 1 write packet)
-                            PrepareMemBlock.MemoryBlockProcessState = 1;
+                            Ctx->MemBlock.MemoryBlockProcessState = 1;
                             return(IQRF_PGM_EEPROM_BLOCK_READY);
                         }
                     }
@@ -585,29 +1634,425 @@ uint8_t iqrfPgmPrepareMemBlock(void)
                 // if destination address is from FLASH memory area
                 if (ValidAddress) {
                     // remember actual memory block
-                    PrepareMemBlock.MemoryBlockNumber = MemBlock;
+                    Ctx->MemBlock.MemoryBlockNumber = MemBlock;
                     // initialize block process counter (block will be written to TR module in 2 write packets)
-                    PrepareMemBlock.MemoryBlockProcessState = 2;
+                    Ctx->MemBlock.MemoryBlockProcessState = 2;
                     // compute and write destination address of first half of image
                     MemBlock *= 32;
-                    PrepareMemBlock.MemoryBlock[0] = MemBlock & 0x00FF;
-                    PrepareMemBlock.MemoryBlock[1] = MemBlock >> 8;
+                    Ctx->MemBlock.MemoryBlock[0] = MemBlock & 0x00FF;
+                    Ctx->MemBlock.MemoryBlock[1] = MemBlock >> 8;
                     // compute and write destination address of second half of image
                     MemBlock += 0x0010;
-                    PrepareMemBlock.MemoryBlock[34] = MemBlock & 0x00FF;
-                    PrepareMemBlock.MemoryBlock[35] = MemBlock >> 8;
+                    Ctx->MemBlock.MemoryBlock[34] = MemBlock & 0x00FF;
+                    Ctx->MemBlock.MemoryBlock[35] = MemBlock >> 8;
                     // copy data from file buffer to image of data block
-                    memcpy(&PrepareMemBlock.MemoryBlock[DestinationIndex], &IqrfPgmCodeLineBuffer[4], DataCounter);
+                    memcpy(&Ctx->MemBlock.MemoryBlock[DestinationIndex], &Ctx->CodeLineBuffer[4], DataCounter);
+                    // mark written words of the image
+                    for (Cnt = Ctx->MemBlock.Address % 32; Cnt < (Ctx->MemBlock.Address % 32) + (DataCounter + 1) / 2 && Cnt < 32; Cnt++)
+                        Ctx->MemBlock.WordMask |= (uint32_t)1 << Cnt;
                 }
             }
         } else {
-            if (IqrfPgmCodeLineBuffer[3] == 4)                                  // in file buffer is address info
-                PrepareMemBlock.HiAddress = ((uint32_t)IqrfPgmCodeLineBuffer[4] << 24) + ((uint32_t)IqrfPgmCodeLineBuffer[5] << 16);
+            if (Ctx->CodeLineBuffer[3] == 4)                                  // in file buffer is address info
+                Ctx->MemBlock.HiAddress = ((uint32_t)Ctx->CodeLineBuffer[4] << 24) + ((uint32_t)Ctx->CodeLineBuffer[5] << 16);
+        }
+        Ctx->MemBlock.DataInBufferReady = 0;                                  // process next line from HEX file
+    }
+}
+
+/**
+ * Prepare next block of HEX file, flash blocks of licensed and main memory windows are collected
+ * in block map until end of file and then written once in address order
+ * @return result of data preparing operation, IQRF_PGM_BLOCK_PENDING = IQRF_PGM_MAP_BLOCKS_PER_STEP blocks
+ *         have been merged to block map, call again
+ * @note Check pass does not use block map, blocks are prepared in order of HEX file records
+ */
+uint8_t iqrfPgmPrepareMappedBlock(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint8_t OperationResult;
+    uint8_t Cnt;
+
+    if (!Ctx->BlockMap.Active)
+        return(iqrfPgmPrepareMemBlock(Ctx));
+    for (Cnt=0; !Ctx->BlockMap.Flushing; Cnt++) {
+        // main loop is not blocked by reading of whole HEX file
+        if (Cnt == IQRF_PGM_MAP_BLOCKS_PER_STEP)
+            return(IQRF_PGM_BLOCK_PENDING);
+        OperationResult = iqrfPgmPrepareMemBlock(Ctx);
+        if (OperationResult == IQRF_PGM_SUCCESS) {
+            Ctx->BlockMap.Flushing = 1;
+            Ctx->BlockMap.Index = 0;
+            break;
+        }
+        // EEPROM blocks, serial EEPROM blocks and errors are processed immediately
+        if (OperationResult != IQRF_PGM_FLASH_BLOCK_READY || !iqrfPgmBlockMapPut(Ctx))
+            return(OperationResult);
+    }
+    return(iqrfPgmBlockMapGet(Ctx));
+}
+
+/**
+ * Find index of flash block in block map
+ * @param MemoryBlockNumber number of 32 words memory block
+ * @return index of block in block map or IQRF_PGM_MAP_NO_BLOCK
+ */
+uint8_t iqrfPgmBlockMapIndex(uint16_t MemoryBlockNumber)
+{
+    if (MemoryBlockNumber >= IQRF_PGM_MAP_LICENCED_BLOCK
+        && MemoryBlockNumber < IQRF_PGM_MAP_LICENCED_BLOCK + IQRF_LICENCED_MEMORY_BLOCKS)
+    {
+        return(MemoryBlockNumber - IQRF_PGM_MAP_LICENCED_BLOCK);
+    }
+    if (MemoryBlockNumber >= IQRF_PGM_MAP_MAIN_BLOCK
+        && MemoryBlockNumber < IQRF_PGM_MAP_MAIN_BLOCK + IQRF_MAIN_MEMORY_BLOCKS)
+    {
+        return(IQRF_LICENCED_MEMORY_BLOCKS + MemoryBlockNumber - IQRF_PGM_MAP_MAIN_BLOCK);
+    }
+    return(IQRF_PGM_MAP_NO_BLOCK);
+}
+
+/**
+ * Merge prepared flash block image to block map
+ * @return true = block stored in block map, false = block is not from mapped memory windows
+ */
+uint8_t iqrfPgmBlockMapPut(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint8_t Index;
+    uint8_t Word;
+    uint8_t Cnt;
+
+    if (Ctx->MemBlock.MemoryBlockProcessState != 2
+        || (Index = iqrfPgmBlockMapIndex(Ctx->MemBlock.MemoryBlockNumber)) == IQRF_PGM_MAP_NO_BLOCK)
+    {
+        return(false);
+    }
+    Ctx->MemBlock.MemoryBlockProcessState = 0;
+
+    // first occurrence of the block, store whole image (unwritten words are erased)
+    if (!(Ctx->BlockMap.Present[Index / 8] & (1 << (Index % 8)))) {
+        Ctx->BlockMap.Present[Index / 8] |= 1 << (Index % 8);
+        Ctx->BlockMap.Blocks++;
+        iqrfPgmBlockMapWrite(Ctx, Index, 0, &Ctx->MemBlock.MemoryBlock[2], 32);
+        iqrfPgmBlockMapWrite(Ctx, Index, 32, &Ctx->MemBlock.MemoryBlock[36], 32);
+        return(true);
+    }
+
+    // block already stored, merge only words written from HEX file
+    for (Word=0; Word<32; Word=Cnt) {
+        if (!(Ctx->MemBlock.WordMask & ((uint32_t)1 << Word))) {
+            Cnt = Word + 1;
+            continue;
+        }
+        // find run of written words inside one half of the image
+        for (Cnt=Word+1; Cnt<32 && Cnt!=16 && (Ctx->MemBlock.WordMask & ((uint32_t)1 << Cnt)); Cnt++)
+            ;
+        iqrfPgmBlockMapWrite(Ctx, Index, Word * 2, &Ctx->MemBlock.MemoryBlock[Word * 2 + (Word < 16 ? 2 : 4)], (Cnt - Word) * 2);
+    }
+    return(true);
+}
+
+/**
+ * Prepare image of next flash block stored in block map
+ * @return IQRF_PGM_FLASH_BLOCK_READY or IQRF_PGM_SUCCESS, if all blocks have been prepared
+ */
+uint8_t iqrfPgmBlockMapGet(IQRF_PGM_CONTEXT *Ctx)
+{
+    uint16_t Address;
+    uint8_t Index;
+
+    while ((Index = Ctx->BlockMap.Index) < IQRF_PGM_MAP_BLOCKS) {
+        Ctx->BlockMap.Index++;
+        if (!(Ctx->BlockMap.Present[Index / 8] & (1 << (Index % 8))))
+            continue;
+        // compute memory block number from block map index
+        if (Index < IQRF_LICENCED_MEMORY_BLOCKS)
+            Ctx->MemBlock.MemoryBlockNumber = IQRF_PGM_MAP_LICENCED_BLOCK + Index;
+        else
+            Ctx->MemBlock.MemoryBlockNumber = IQRF_PGM_MAP_MAIN_BLOCK + Index - IQRF_LICENCED_MEMORY_BLOCKS;
+        Address = Ctx->MemBlock.MemoryBlockNumber * 32;
+        Ctx->MemBlock.MemoryBlock[0] = Address & 0x00FF;
+        Ctx->MemBlock.MemoryBlock[1] = Address >> 8;
+        Address += 0x0010;
+        Ctx->MemBlock.MemoryBlock[34] = Address & 0x00FF;
+        Ctx->MemBlock.MemoryBlock[35] = Address >> 8;
+        if (Ctx->BlockMap.Data) {
+            memcpy(&Ctx->MemBlock.MemoryBlock[2], &Ctx->BlockMap.Data[(uint16_t)Index * IQRF_SIZE_OF_FLASH_BLOCK], 32);
+            memcpy(&Ctx->MemBlock.MemoryBlock[36], &Ctx->BlockMap.Data[(uint16_t)Index * IQRF_SIZE_OF_FLASH_BLOCK + 32], 32);
+        } else {
+            iqrfSuspendDriver();
+            iqrfReadStorage(Ctx->BlockMap.ScratchName, (uint32_t)Index * IQRF_SIZE_OF_FLASH_BLOCK, &Ctx->MemBlock.MemoryBlock[2], 32);
+            iqrfReadStorage(Ctx->BlockMap.ScratchName, (uint32_t)Index * IQRF_SIZE_OF_FLASH_BLOCK + 32, &Ctx->MemBlock.MemoryBlock[36], 32);
+            iqrfRunDriver();
         }
-        PrepareMemBlock.DataInBufferReady = 0;                                  // process next line from HEX file
+        // initialize block process counter (block will be written to TR module in 2 write packets)
+        Ctx->MemBlock.MemoryBlockProcessState = 2;
+        Ctx->BlockMap.Flushed++;
+        return(IQRF_PGM_FLASH_BLOCK_READY);
     }
+    return(IQRF_PGM_SUCCESS);
 }
 
+/**
+ * Write data to flash block stored in block map
+ * @param Index index of block in block map
+ * @param Offset offset of data in flash block
+ * @param Data pointer to data
+ * @param Size size of data
+ */
+void iqrfPgmBlockMapWrite(IQRF_PGM_CONTEXT *Ctx, uint8_t Index, uint8_t Offset, const uint8_t *Data, uint8_t Size)
+{
+    if (Ctx->BlockMap.Data) {
+        memcpy(&Ctx->BlockMap.Data[(uint16_t)Index * IQRF_SIZE_OF_FLASH_BLOCK + Offset], Data, Size);
+    } else {
+        iqrfSuspendDriver();
+        iqrfWriteStorage(Ctx->BlockMap.ScratchName, (uint32_t)Index * IQRF_SIZE_OF_FLASH_BLOCK + Offset, Data, Size);
+        iqrfRunDriver();
+    }
+}
+
+/**
+ * Select input stream of code file
+ * @param Fetch function providing chunks of code file (NULL = read code file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ */
+void iqrfPgmCtxSetStream(IQRF_PGM_CONTEXT *Ctx, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context)
+{
+    Ctx->StreamFetch = Fetch ? Fetch : iqrfPgmFileStreamFetch;
+    Ctx->StreamContext = Fetch ? Context : Ctx;
+    iqrfPgmResetFileBuffer(Ctx);
+}
+
+/**
+ * Select code file stored in memory as input stream
+ * @param Data pointer to code file in memory
+ * @param Size size of code file
+ */
+void iqrfPgmCtxSetMemoryStream(IQRF_PGM_CONTEXT *Ctx, const uint8_t *Data, uint32_t Size)
+{
+    Ctx->MemoryStream.Data = Data;
+    Ctx->MemoryStream.Size = Size;
+    Ctx->FileInfo->FileSize = Size;
+    iqrfPgmCtxSetStream(Ctx, iqrfPgmMemoryStreamFetch, &Ctx->MemoryStream);
+}
+
+/**
+ * Provide next chunk of code file read by iqrfReadBlockFromFile()
+ * @param Context pointer to programmer context
+ * @param Offset position of requested chunk in code file
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+uint16_t iqrfPgmFileStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk)
+{
+    IQRF_PGM_CONTEXT *Ctx = (IQRF_PGM_CONTEXT *)Context;
+    uint16_t Size;
+
+    // code file shares SPI bus with TR module, read whole block at once
+    iqrfSuspendDriver();
+    // code file is read sequentially, position is changed only if the file is read again
+    if (Offset != Ctx->FilePosition)
+        iqrfSeekFile(Offset);
+    Size = iqrfReadBlockFromFile(Ctx->FileBuffer.Data, sizeof(Ctx->FileBuffer.Data));
+    iqrfRunDriver();
+    Ctx->FilePosition = Offset + Size;
+    *Chunk = Ctx->FileBuffer.Data;
+    return(Size);
+}
+
+/**
+ * Provide next chunk of code file stored in memory
+ * @param Context pointer to IQRF_PGM_MEMORY_STREAM structure
+ * @param Offset position of requested chunk in code file
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+uint16_t iqrfPgmMemoryStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk)
+{
+    IQRF_PGM_MEMORY_STREAM *Stream = (IQRF_PGM_MEMORY_STREAM *)Context;
+    uint32_t Size;
+
+    if (Offset >= Stream->Size)
+        return(0);
+    Size = Stream->Size - Offset;
+    *Chunk = Stream->Data + Offset;
+    return(Size > 0x8000 ? 0x8000 : (uint16_t)Size);
+}
+
+/**
+ * Select compressed code file as input stream
+ * @param Stream pointer to decompressor state
+ * @param Fetch function providing chunks of compressed file (NULL = read compressed file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ * @return true = compressed file selected, false = file is not compressed code file
+ */
+uint8_t iqrfPgmCtxSetCompressedStream(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_LZ_STREAM *Stream, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context)
+{
+    uint8_t Header[IQRF_PGM_LZ_HEADER_SIZE];
+    uint8_t Cnt;
+
+    memset(Stream, 0, sizeof(IQRF_PGM_LZ_STREAM));
+    Stream->Fetch = Fetch ? Fetch : iqrfPgmFileStreamFetch;
+    Stream->Context = Fetch ? Context : Ctx;
+    // file stream shares read buffer with the programmer
+    iqrfPgmResetFileBuffer(Ctx);
+
+    // header: magic, format version, source file type, size of decompressed file
+    for (Cnt=0; Cnt<IQRF_PGM_LZ_HEADER_SIZE; Cnt++) {
+        if (!iqrfPgmLzReadByte(Stream, &Header[Cnt]))
+            return(false);
+    }
+    if (memcmp(Header, IQRF_PGM_LZ_MAGIC, 4) != 0 || Header[4] != IQRF_PGM_LZ_VERSION)
+        return(false);
+    Stream->Size = (uint32_t)Header[6] | ((uint32_t)Header[7] << 8) | ((uint32_t)Header[8] << 16) | ((uint32_t)Header[9] << 24);
+    Ctx->FileInfo->FileType = Header[5];
+    Ctx->FileInfo->FileSize = Stream->Size;
+
+    iqrfPgmLzReset(Stream);
+    iqrfPgmCtxSetStream(Ctx, iqrfPgmLzStreamFetch, Stream);
+    return(true);
+}
+
+/**
+ * Provide next chunk of decompressed code file
+ * @param Context pointer to IQRF_PGM_LZ_STREAM structure
+ * @param Offset position of requested chunk in code file
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+uint16_t iqrfPgmLzStreamFetch(void *Context, uint32_t Offset, const uint8_t **Chunk)
+{
+    IQRF_PGM_LZ_STREAM *Stream = (IQRF_PGM_LZ_STREAM *)Context;
+    uint8_t Start;
+    uint16_t Size;
+
+    // code file is read again, decompress it from the beginning up to requested position
+    if (Offset == 0 || Offset != Stream->OutputOffset) {
+        iqrfPgmLzReset(Stream);
+        while (Stream->OutputOffset < Offset && iqrfPgmLzDecode(Stream) != 0)
+            ;   /* void */
+        if (Stream->OutputOffset != Offset)
+            return(0);
+    }
+
+    // chunk is provided directly from window, it is valid until next chunk is decompressed
+    Start = Stream->WindowPtr;
+    Size = iqrfPgmLzDecode(Stream);
+    Stream->BytesDecoded += Size;
+    *Chunk = &Stream->Window[Start];
+    return(Size);
+}
+
+/**
+ * Start decompression from the beginning of compressed file
+ * @param Stream pointer to decompressor state
+ */
+void iqrfPgmLzReset(IQRF_PGM_LZ_STREAM *Stream)
+{
+    Stream->InputPtr = 0;
+    Stream->InputLength = 0;
+    Stream->InputOffset = IQRF_PGM_LZ_HEADER_SIZE;
+    Stream->OutputOffset = 0;
+    Stream->MatchLength = 0;
+    Stream->FlagCnt = 0;
+    Stream->WindowPtr = 0;
+    memset(Stream->Window, 0, sizeof(Stream->Window));
+}
+
+/**
+ * Read one byte of compressed file, fetch next chunk from input stream if empty
+ * @param Stream pointer to decompressor state
+ * @param Byte pointer to variable, where the byte will be stored
+ * @return true = byte read, false = end of compressed file
+ */
+uint8_t iqrfPgmLzReadByte(IQRF_PGM_LZ_STREAM *Stream, uint8_t *Byte)
+{
+    if (Stream->InputPtr >= Stream->InputLength) {
+        Stream->InputLength = Stream->Fetch(Stream->Context, Stream->InputOffset, &Stream->Input);
+        Stream->InputPtr = 0;
+        if (Stream->InputLength == 0)
+            return(false);
+        Stream->InputOffset += Stream->InputLength;
+        Stream->BytesRead += Stream->InputLength;
+    }
+    *Byte = Stream->Input[Stream->InputPtr++];
+    return(true);
+}
+
+/**
+ * Decompress data from actual position in window up to the end of window
+ * @param Stream pointer to decompressor state
+ * @return number of decompressed bytes, 0 = end of file
+ * @note Tokens are grouped by eight, every group starts by byte with token flags (LSB first).
+ *       Literal token is one byte of data, match token is two bytes: distance - 1 and length - IQRF_PGM_LZ_MIN_MATCH.
+ */
+uint16_t iqrfPgmLzDecode(IQRF_PGM_LZ_STREAM *Stream)
+{
+    uint16_t Size = 0;
+    uint8_t Literal;
+    uint8_t Byte;
+
+    while (Stream->OutputOffset < Stream->Size) {
+        if (Stream->MatchLength) {
+            // copy byte of match from history of decompressed data (window size is 256 bytes)
+            Byte = Stream->Window[(uint8_t)(Stream->WindowPtr - Stream->MatchDistance - 1)];
+            Stream->MatchLength--;
+        } else {
+            if (!Stream->FlagCnt) {
+                if (!iqrfPgmLzReadByte(Stream, &Stream->Flags))
+                    break;
+                Stream->FlagCnt = 8;
+            }
+            Literal = Stream->Flags & 0x01;
+            Stream->Flags >>= 1;
+            Stream->FlagCnt--;
+            if (!iqrfPgmLzReadByte(Stream, &Byte))
+                break;
+            if (!Literal) {
+                Stream->MatchDistance = Byte;
+                if (!iqrfPgmLzReadByte(Stream, &Byte))
+                    break;
+                Stream->MatchLength = Byte + IQRF_PGM_LZ_MIN_MATCH;
+                continue;
+            }
+        }
+        Stream->Window[Stream->WindowPtr++] = Byte;
+        Stream->OutputOffset++;
+        Size++;
+        // end of window reached, next chunk starts at the beginning of window
+        if (Stream->WindowPtr == 0)
+            break;
+    }
+    return(Size);
+}
+
+/**
+ * Initialize code file read buffer (must be called after code file is opened or rewound)
+ */
+void iqrfPgmResetFileBuffer(IQRF_PGM_CONTEXT *Ctx)
+{
+    Ctx->FileBuffer.Ptr = 0;
+    Ctx->FileBuffer.Length = 0;
+    Ctx->FileBuffer.Offset = 0;
+}
+
+/**
+ * Read one byte from actual chunk of code file, fetch next chunk from input stream if empty
+ * @return byte from code file or 0 = end of file
+ */
+uint8_t iqrfPgmReadFileByte(IQRF_PGM_CONTEXT *Ctx)
+{
+    if (Ctx->FileBuffer.Ptr >= Ctx->FileBuffer.Length) {
+        Ctx->FileBuffer.Length = Ctx->StreamFetch(Ctx->StreamContext, Ctx->FileBuffer.Offset, &Ctx->FileBuffer.Chunk);
+        Ctx->FileBuffer.Ptr = 0;
+        if (Ctx->FileBuffer.Length == 0)
+            return(0);
+        Ctx->FileBuffer.Offset += Ctx->FileBuffer.Length;
+        if (Ctx->FileHashing)
+            Ctx->FileHash = iqrfPgmHash(Ctx->FileHash, Ctx->FileBuffer.Chunk, Ctx->FileBuffer.Length);
+    }
+    Ctx->FileInfo->FileByteCnt++;
+    return(Ctx->FileBuffer.Chunk[Ctx->FileBuffer.Ptr++]);
+}
 
 /**
  * Convert two ASCII chars to number
@@ -617,21 +2062,7 @@ uint8_t iqrfPgmPrepareMemBlock(void)
  */
 uint8_t iqrfPgmConvertToNum(uint8_t dataByteHi, uint8_t dataByteLo)
 {
-    uint8_t result = 0;
-
-    /* convert High nibble */
-    if (dataByteHi >= '0' && dataByteHi <= '9')
-        result = (dataByteHi - '0') << 4;
-    else if (dataByteHi >= 'a' && dataByteHi <= 'f')
-        result = (dataByteHi - 87) << 4;
-
-    /* convert Low nibble */
-    if (dataByteLo >= '0' && dataByteLo <= '9')
-        result |= (dataByteLo - '0');
-    else if (dataByteLo >= 'a' && dataByteLo <= 'f')
-        result |= (dataByteLo - 87);
-
-    return(result);
+    return((iqrfPgmHexValue(dataByteHi) << 4) | iqrfPgmHexValue(dataByteLo));
 }
 
 
@@ -639,7 +2070,7 @@ uint8_t iqrfPgmConvertToNum(uint8_t dataByteHi, uint8_t dataByteLo)
  * Read and process line from plugin file
  * @return Return code (IQRF_PGM_FILE_DATA_READY - iqrf file line ready, IQRF_PGM_FILE_DATA_READY - input file format error, IQRF_PGM_END_OF_FILE - end of file)
  */
-uint8_t iqrfPgmReadIQRFFileLine(void)
+uint8_t iqrfPgmReadIQRFFileLine(IQRF_PGM_CONTEXT *Ctx)
 {
     uint8_t FirstChar;
     uint8_t SecondChar;
@@ -647,19 +2078,19 @@ uint8_t iqrfPgmReadIQRFFileLine(void)
 
 repeat_read:
     // read one char from file
-    FirstChar = tolower(iqrfReadByteFromFile());
+    FirstChar = iqrfPgmReadFileByte(Ctx);
 
     // read one char from file
     if (FirstChar == '#') {
         // read data to end of line
-        while (((FirstChar = iqrfReadByteFromFile()) != 0) && (FirstChar != 0x0D))
+        while (((FirstChar = iqrfPgmReadFileByte(Ctx)) != 0) && (FirstChar != 0x0D))
             ; /* void */
     }
 
     // if end of line
     if (FirstChar == 0x0D) {
         // read second code 0x0A
-        iqrfReadByteFromFile();
+        iqrfPgmReadFileByte(Ctx);
         if (CodeLineBufferPtr == 0)
             // read another line
             goto repeat_read;
@@ -676,11 +2107,11 @@ repeat_read:
         return(IQRF_PGM_END_OF_FILE);
 
     // read second character from code file
-    SecondChar = tolower(iqrfReadByteFromFile());
+    SecondChar = iqrfPgmReadFileByte(Ctx);
     if (CodeLineBufferPtr >= 20)
         return(IQRF_PGM_FILE_DATA_ERROR);
     // convert chars to number and store to buffer
-    IqrfPgmCodeLineBuffer[CodeLineBufferPtr++] = iqrfPgmConvertToNum(FirstChar, SecondChar);
+    Ctx->CodeLineBuffer[CodeLineBufferPtr++] = iqrfPgmConvertToNum(FirstChar, SecondChar);
     // read next data
     goto repeat_read;
 }
@@ -689,7 +2120,7 @@ repeat_read:
  * Read and process line from HEX file
  * @return Return code (IQRF_PGM_FILE_DATA_READY - iqrf file line ready, IQRF_PGM_FILE_DATA_READY - input file format error, IQRF_PGM_END_OF_FILE - end of file)
  */
-uint8_t iqrfPgmReadHEXFileLine(void)
+uint8_t iqrfPgmReadHEXFileLine(IQRF_PGM_CONTEXT *Ctx)
 {
     uint8_t Sign;
     uint8_t DataByteHi, DataByteLo;
@@ -698,7 +2129,7 @@ uint8_t iqrfPgmReadHEXFileLine(void)
     uint8_t CodeLineBufferCrc = 0;
 
     // find start of line or end of file
-    while (((Sign = iqrfReadByteFromFile()) != 0) && (Sign != ':'))
+    while (((Sign = iqrfPgmReadFileByte(Ctx)) != 0) && (Sign != ':'))
         ; /* void */
     // if end of file
     if (Sign == 0)
@@ -707,7 +2138,7 @@ uint8_t iqrfPgmReadHEXFileLine(void)
     // read data to end of line and convert if to numbers
     for ( ; ; ) {
         // read High nibble
-        DataByteHi = tolower(iqrfReadByteFromFile());
+        DataByteHi = iqrfPgmReadFileByte(Ctx);
         // check end of line
         if (DataByteHi == 0x0A || DataByteHi == 0x0D) {
             if (CodeLineBufferCrc != 0)
@@ -717,14 +2148,14 @@ uint8_t iqrfPgmReadHEXFileLine(void)
             return(IQRF_PGM_FILE_DATA_READY);
         }
         // read Low nibble
-        DataByteLo = tolower(iqrfReadByteFromFile());
+        DataByteLo = iqrfPgmReadFileByte(Ctx);
         // convert two ASCII to number
         DataByte = iqrfPgmConvertToNum(DataByteHi, DataByteLo);
         // add to CRC
         CodeLineBufferCrc += DataByte;
         // store to line buffer
-        IqrfPgmCodeLineBuffer[CodeLineBufferPtr++] = DataByte;
-        if (CodeLineBufferPtr >= SIZE_OF_CODE_LINE_BUFFER)
+        Ctx->CodeLineBuffer[CodeLineBufferPtr++] = DataByte;
+        if (CodeLineBufferPtr >= IQRF_PGM_CODE_LINE_BUFFER_SIZE)
             return (IQRF_PGM_FILE_DATA_ERROR);
     }
 }
@@ -30,21 +30,64 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "IQRFPort.h"
 
 #define	IQRF_PGM_SUCCESS              200
 #define IQRF_PGM_FLASH_BLOCK_READY    220
 #define IQRF_PGM_EEPROM_BLOCK_READY   221
 #define	IQRF_PGM_ERROR                222
+#define IQRF_PGM_FORMAT_ERROR         223
+#define IQRF_PGM_BLOCK_PENDING        224
 
 #define IQRF_PGM_FILE_DATA_READY      0
 #define IQRF_PGM_FILE_DATA_ERROR      1
 #define IQRF_PGM_END_OF_FILE          2
+#define IQRF_PGM_FILE_DATA_PENDING    3
 
 #define	IQRF_PGM_HEX_FILE_TYPE        1
 #define IQRF_PGM_PLUGIN_FILE_TYPE     2
 #define IQRF_PGM_CFG_FILE_TYPE        3
 #define IQRF_PGM_PASS_FILE_TYPE       4
 #define IQRF_PGM_KEY_FILE_TYPE        5
+#define IQRF_PGM_IMAGE_FILE_TYPE      6
+
+// delta programming modes
+#define IQRF_PGM_DELTA_OFF            0     // write all blocks, delta manifest is not used
+#define IQRF_PGM_DELTA_ON             1     // write only blocks changed since last programming of the module
+#define IQRF_PGM_DELTA_FORCE          2     // write all blocks and rebuild delta manifest of the module
+
+// validated-image cache lookup modes
+#define IQRF_PGM_CACHE_MEMORY         0     // look up code files in memory by hash of content, other files by size and hash of first chunk
+#define IQRF_PGM_CACHE_ALWAYS         1     // read and hash every code file before check (extra pass over the file)
+
+// keys of validated-image cache entries
+#define IQRF_PGM_CACHE_KEY_CONTENT    0     // hash of whole code file
+#define IQRF_PGM_CACHE_KEY_PROBE      1     // hash of size and first chunk of code file (streams in IQRF_PGM_CACHE_MEMORY mode)
+
+// binary block image file (header, packet records, trailer with FNV-1a hash of header and records)
+#define IQRF_PGM_IMAGE_MAGIC          "IQBI"
+#define IQRF_PGM_IMAGE_VERSION        2
+#define IQRF_PGM_IMAGE_HEADER_SIZE    8
+#define IQRF_PGM_IMAGE_TRAILER_SIZE   4
+
+// compressed code file (header, LZ tokens), see iqrfPgmCtxSetCompressedStream()
+#define IQRF_PGM_LZ_MAGIC             "IQLZ"
+#define IQRF_PGM_LZ_VERSION           1
+#define IQRF_PGM_LZ_HEADER_SIZE       10
+#define IQRF_PGM_LZ_WINDOW_SIZE       256   // fixed, decoder uses 8-bit positions in window
+#define IQRF_PGM_LZ_MIN_MATCH         3
+
+// checkpoint record (header, little-endian fields of IQRF_PGM_CHECKPOINT), see iqrfPgmCtxResumeCodeFile()
+#define IQRF_PGM_CHECKPOINT_MAGIC     "IQCP"
+#define IQRF_PGM_CHECKPOINT_VERSION   1
+#define IQRF_PGM_CHECKPOINT_HEADER_SIZE 6
+#define IQRF_PGM_CHECKPOINT_DATA_SIZE 17
+
+// entry of validated-image cache (header, little-endian fields of IQRF_PGM_CACHE_ENTRY)
+#define IQRF_PGM_CACHE_MAGIC          "IQVC"
+#define IQRF_PGM_CACHE_VERSION        1
+#define IQRF_PGM_CACHE_HEADER_SIZE    6
+#define IQRF_PGM_CACHE_DATA_SIZE      13
 
 #define IQRF_SIZE_OF_FLASH_BLOCK      64
 #define IQRF_LICENCED_MEMORY_BLOCKS   96
@@ -67,6 +110,344 @@ extern "C" {
 #define ACCESS_PASSWORD_CFG_ADR       0xD0
 #define USER_KEY_CFG_ADR              0xD1
 
+typedef struct {
+    uint8_t SpiCmd;                   // SPI command (SPI_FLASH_PGM, SPI_EEPROM_PGM, SPI_PLUGIN_PGM)
+    uint8_t Length;                   // size of packet data
+    uint8_t *Data;                    // pointer to packet data
+} IQRF_PGM_PACKET;
+
+/**
+ * Code file input stream, provides next chunk of code file
+ * @param Context user data registered with the stream
+ * @param Offset position of requested chunk in code file (sequential sources may ignore it)
+ * @param Chunk pointer to variable, where pointer to chunk data will be stored
+ * @return size of chunk, 0 = end of file
+ */
+typedef uint16_t (*T_IQRF_PGM_STREAM_FETCH)(void *Context, uint32_t Offset, const uint8_t **Chunk);
+
+typedef struct {
+    uint16_t PacketsSent;             // number of packets sent to TR module
+    uint16_t PacketsSkipped;          // number of unchanged packets skipped in delta mode
+    uint16_t PacketsResumed;          // number of packets written before interruption of programming
+    uint16_t PgmModeEntryTime;        // time of last programming mode entry in ms
+    uint16_t PacketsChecked;          // number of packets of last checked code file
+    uint8_t CheckCached;              // result of last check has been found in validated-image cache
+} IQRF_PGM_STATS;
+
+//******************************************************************************
+//		 	programmer context (state of one programming job)
+//******************************************************************************
+#define IQRF_PGM_CODE_LINE_BUFFER_SIZE  32
+
+// size of code file read buffer (divisor of SD card sector size), reduced on ATmega328P (2 kB of RAM) and ATmega32U4 (2.5 kB of RAM)
+#if !defined(IQRF_PGM_FILE_BUFFER_SIZE)
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega32U4__)
+#define IQRF_PGM_FILE_BUFFER_SIZE     64
+#else
+#define IQRF_PGM_FILE_BUFFER_SIZE     512
+#endif
+#endif
+
+// flash blocks of licensed and main memory windows are collected in block map and written in address order
+#define IQRF_PGM_MAP_BLOCKS           (IQRF_LICENCED_MEMORY_BLOCKS + IQRF_MAIN_MEMORY_BLOCKS)
+
+// size of caller-supplied RAM buffer of block map, see iqrfPgmCtxSetBlockMap()
+#define IQRF_PGM_MAP_SIZE             ((uint16_t)IQRF_PGM_MAP_BLOCKS * IQRF_SIZE_OF_FLASH_BLOCK)
+// number of HEX file blocks merged to block map in one step of iqrfPgmCtxWriteCodeFile()
+#if !defined(IQRF_PGM_MAP_BLOCKS_PER_STEP)
+#define IQRF_PGM_MAP_BLOCKS_PER_STEP  4
+#endif
+// share of reading of HEX file in progress of programming with block map (percent)
+#define IQRF_PGM_MAP_READ_PROGRESS    10
+
+typedef struct {
+    uint32_t  HiAddress;
+    uint16_t  Address;
+    uint16_t  MemoryBlockNumber;
+    uint8_t MemoryBlockProcessState;
+    uint8_t MemoryBlockType;
+    uint8_t DataInBufferReady;
+    uint8_t DataOverflow;
+    uint32_t WordMask;                // words of flash block image written from HEX file
+    uint8_t MemoryBlock[68];
+} IQRF_PGM_MEM_BLOCK;
+
+typedef struct {
+    uint16_t Ptr;
+    uint16_t Length;
+    uint32_t Offset;                  // position of next chunk in code file
+    const uint8_t *Chunk;             // actual chunk of code file provided by input stream
+    uint8_t Data[IQRF_PGM_FILE_BUFFER_SIZE];
+} IQRF_PGM_FILE_BUFFER;
+
+typedef struct {                      // code file stored in memory
+    const uint8_t *Data;
+    uint32_t Size;
+} IQRF_PGM_MEMORY_STREAM;
+
+typedef struct {                      // decompressor of compressed code file, owned by the caller
+    T_IQRF_PGM_STREAM_FETCH Fetch;    // input stream of compressed file
+    void *Context;
+    const uint8_t *Input;             // actual chunk of compressed file
+    uint16_t InputPtr;
+    uint16_t InputLength;
+    uint32_t InputOffset;             // position of next chunk of compressed file
+    uint32_t Size;                    // size of decompressed code file
+    uint32_t OutputOffset;            // position of next decompressed byte
+    uint16_t MatchLength;             // remaining bytes of actual match
+    uint8_t MatchDistance;
+    uint8_t Flags;                    // token flags of actual group (1 = literal, 0 = match)
+    uint8_t FlagCnt;                  // number of remaining tokens of actual group
+    uint8_t WindowPtr;                // position of next decompressed byte in window
+    uint32_t BytesRead;               // number of compressed bytes read from input stream
+    uint32_t BytesDecoded;            // number of decompressed bytes provided to the programmer
+    uint8_t Window[IQRF_PGM_LZ_WINDOW_SIZE];  // history of decompressed data, chunks are provided from it
+} IQRF_PGM_LZ_STREAM;
+
+// number of entries of validated-image cache (0 = check results are not cached)
+#if !defined(IQRF_PGM_CACHE_ENTRIES)
+#define IQRF_PGM_CACHE_ENTRIES        16
+#endif
+
+typedef struct {                      // result of code file check, stored in persistent storage record PGMCACHE.DAT
+    uint32_t FileSize;
+    uint32_t Hash;                    // hash of code file content
+    uint8_t FileType;
+    uint8_t Result;                   // IQRF_PGM_SUCCESS or IQRF_PGM_ERROR (0 = empty entry)
+    uint16_t Packets;                 // number of programming packets of code file
+    uint8_t KeyType;                  // IQRF_PGM_CACHE_KEY_CONTENT or IQRF_PGM_CACHE_KEY_PROBE
+} IQRF_PGM_CACHE_ENTRY;
+
+// checkpoint of programming is stored after every IQRF_PGM_CHECKPOINT_INTERVAL written packets (0 = on error only)
+#if !defined(IQRF_PGM_CHECKPOINT_INTERVAL)
+#define IQRF_PGM_CHECKPOINT_INTERVAL  16
+#endif
+
+typedef struct {                      // progress of programming, stored in persistent storage record <ModuleId>.CKP
+                                      // (serialized by iqrfPgmCheckpointSave(), not stored as the structure)
+    uint32_t FileSize;
+    uint8_t FileType;
+    uint16_t Packets;                 // number of packets written to TR module (0 = no checkpoint)
+    uint16_t Address;                 // destination address of last written packet
+    uint32_t FileOffset;              // position in code file after last written packet
+    uint32_t Hash;                    // hash of all written packets (identity of code file)
+} IQRF_PGM_CHECKPOINT;
+
+typedef struct {                      // packet prepared to be sent to TR module
+    IQRF_PGM_PACKET Packet;
+    uint16_t DeltaSlot;               // slot of delta manifest (0xFFFF = not tracked)
+    uint32_t DeltaHash;               // hash of packet content
+    IQRF_PGM_CHECKPOINT Progress;     // checkpoint valid after the packet is written
+    uint8_t Ready;
+} IQRF_PGM_STAGED_PACKET;
+
+typedef struct {                      // sparse map of flash blocks read from HEX file
+    uint8_t Present[(IQRF_PGM_MAP_BLOCKS + 7) / 8];
+    uint8_t Active;                   // blocks are collected (not in check pass, records are validated in file order)
+    uint8_t Flushing;                 // end of HEX file reached, blocks are written to TR module
+    uint8_t Index;                    // next block to be written
+    uint8_t Blocks;                   // number of blocks in the map
+    uint8_t Flushed;                  // number of blocks prepared for writing
+    uint8_t *Data;                    // content of blocks in RAM (NULL = scratch storage record ScratchName)
+    char ScratchName[13];             // PGMMAPxx.TMP, unique for every context
+} IQRF_PGM_BLOCK_MAP;
+
+typedef struct {                      // item of programming session
+    IQRF_PGM_FILE_INFO FileInfo;      // FileType and FileSize must be filled by the user
+    const uint8_t *Data;              // code file (or 16 bytes of password or key) stored in memory
+    T_IQRF_PGM_STREAM_FETCH Fetch;    // input stream of the item (NULL = Data are used)
+    void *Context;                    // user data passed to Fetch function
+    uint8_t Result;                   // result of programming of the item
+} IQRF_PGM_SESSION_ITEM;
+
+typedef struct {                      // programmer context, owned by the caller
+    IQRF_PGM_FILE_INFO *FileInfo;     // information about code file
+    IQRF_PGM_STATS Stats;
+    uint8_t TaskSM;                   // state of running operation
+    uint8_t Attempts;
+    uint8_t OperationResult;
+    uint32_t SysTickTime;
+    uint32_t PgmModeStartTime;        // start of programming mode entry
+    uint8_t DeltaMode;
+    char DeltaName[13];
+    uint16_t DeltaSlot;
+    uint32_t DeltaHash;
+    char CheckpointName[13];
+    uint8_t Resume;                   // continue interrupted programming
+    uint16_t CheckpointSaved;         // number of written packets in stored checkpoint
+    IQRF_PGM_CHECKPOINT Checkpoint;   // progress of packets written to TR module
+    IQRF_PGM_CHECKPOINT SentProgress; // progress after the packet being written
+    uint8_t PacketPending;            // packet sent to TR module has not been confirmed yet
+    IQRF_PGM_CHECKPOINT ResumePoint;  // progress of interrupted programming
+    uint16_t PacketCnt;               // number of prepared packets
+    uint32_t PacketHash;              // hash of prepared packets
+    IQRF_PGM_SESSION_ITEM *Session;   // items of running programming session (NULL = single code file)
+    uint8_t SessionCount;
+    uint8_t SessionIndex;             // item being written
+    IQRF_PGM_FILE_INFO *SessionFileInfo;  // file info of the context, restored at the end of session
+    T_IQRF_PGM_STREAM_FETCH StreamFetch;
+    void *StreamContext;
+    IQRF_PGM_MEMORY_STREAM MemoryStream;
+    uint32_t FilePosition;            // position of code file read by iqrfReadBlockFromFile()
+    uint32_t FileHash;                // hash of code file content
+    uint32_t FileProbeHash;           // hash of size and first chunk of code file, see IQRF_PGM_CACHE_KEY_PROBE
+    uint8_t FileHashing;              // chunks read from input stream are added to FileHash
+    uint8_t CacheMode;
+    uint16_t ImagePacketCnt;
+    uint8_t ImageHeaderRead;          // 0 = header not read, 1 = records are read, 2 = trailer checked
+    uint32_t ImageHash;               // hash of image bytes read, compared with trailer
+    IQRF_PGM_STAGED_PACKET NextPacket;
+    IQRF_PGM_MEM_BLOCK MemBlock;
+    uint8_t CodeLineBuffer[IQRF_PGM_CODE_LINE_BUFFER_SIZE];
+    IQRF_PGM_FILE_BUFFER FileBuffer;
+    IQRF_PGM_BLOCK_MAP BlockMap;
+} IQRF_PGM_CONTEXT;
+
+// context used by functions without context parameter, code file is described by CodeFileInfo
+extern IQRF_PGM_CONTEXT IqrfPgmContext;
+
+/**
+ * Initialize programmer context
+ * @param Ctx pointer to programmer context
+ * @param FileInfo pointer to information about code file of the context
+ * @note The context reads code file by iqrfReadBlockFromFile(), until other stream is selected
+ */
+void iqrfPgmInit(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_FILE_INFO *FileInfo);
+
+/**
+ * Abort running operation of programmer context
+ * @param Ctx pointer to programmer context
+ * @note If the context uses TR module, pending packet is dropped and TR module is reset to communication mode
+ */
+void iqrfPgmAbort(IQRF_PGM_CONTEXT *Ctx);
+
+/**
+ * Checking the format accuracy of the programming file
+ * @param Ctx pointer to programmer context
+ * @return result of partial checking operation
+ * @note Content of the file is hashed while it is checked and the result is stored to validated-image cache
+ *       (persistent storage record PGMCACHE.DAT). Code file in memory is hashed first and if the same file has
+ *       already been checked, the result is taken from the cache and the file is not parsed. Other streams are
+ *       looked up by size and hash of the first chunk read from the stream, or by hash of the whole file in
+ *       IQRF_PGM_CACHE_ALWAYS mode, see iqrfPgmCtxSetCacheMode().
+ */
+uint8_t iqrfPgmCtxCheckCodeFile(IQRF_PGM_CONTEXT *Ctx);
+
+/**
+ * Core programming function
+ * @param Ctx pointer to programmer context
+ * @return result of partial programming operation
+ * @note Every record of the code file is validated before the memory block it belongs to is written
+ *       to TR module, so the function can be used without previous iqrfPgmCheckCodeFile() pass.
+ *       In that case the function returns IQRF_PGM_FORMAT_ERROR if a wrong record is found.
+ *       Only one context can use TR module, other contexts wait (return 0) until it is finished. Contexts are
+ *       interleaved cooperatively, all of them must be run from one thread (main loop), not from interrupts.
+ */
+uint8_t iqrfPgmCtxWriteCodeFile(IQRF_PGM_CONTEXT *Ctx);
+
+/**
+ * Continue interrupted programming of code file
+ * @param Ctx pointer to programmer context
+ * @return result of partial programming operation, see iqrfPgmCtxWriteCodeFile()
+ * @note Packets written before interruption (according to checkpoint of TR module) are read from the code file,
+ *       but not sent again. If there is no checkpoint or the code file differs, whole file is written.
+ */
+uint8_t iqrfPgmCtxResumeCodeFile(IQRF_PGM_CONTEXT *Ctx);
+
+/**
+ * Write several code files, passwords and keys to TR module in one programming mode session
+ * @param Ctx pointer to programmer context
+ * @param Items pointer to array of session items, result of every item is stored to its Result
+ * @param Count number of items
+ * @return result of partial programming operation (0-100 = progress of the session in %, IQRF_PGM_SUCCESS = all items
+ *         have been written, IQRF_PGM_ERROR = programming of any item failed)
+ * @note TR module enters programming mode once, before the first item, and it is reset once, after the last item.
+ *       Wrong item (IQRF_PGM_FORMAT_ERROR) does not stop the session. Checkpoints are not used in the session.
+ *       Stream of the context is set to the default one after the session.
+ */
+uint8_t iqrfPgmCtxWriteSession(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_SESSION_ITEM *Items, uint8_t Count);
+
+/**
+ * Core programming function for user password or user key
+ * @param Ctx pointer to programmer context
+ * @param BufferContent selects between user key or user password to be written
+ * @param Buffer pointer to 16 byte buffer with user password or user key
+ * @return result of partial programming operation
+ */
+uint8_t iqrfPgmCtxWriteKeyOrPass(IQRF_PGM_CONTEXT *Ctx, uint8_t BufferContent, uint8_t *Buffer);
+
+/**
+ * Select delta programming mode of iqrfPgmCtxWriteCodeFile()
+ * @param Ctx pointer to programmer context
+ * @param Mode IQRF_PGM_DELTA_OFF, IQRF_PGM_DELTA_ON or IQRF_PGM_DELTA_FORCE
+ * @note Hashes of written flash blocks are stored in persistent storage record named by TR module ID
+ */
+void iqrfPgmCtxSetDeltaMode(IQRF_PGM_CONTEXT *Ctx, uint8_t Mode);
+
+/**
+ * Select storage of block map of iqrfPgmCtxWriteCodeFile()
+ * @param Ctx pointer to programmer context
+ * @param Buffer RAM buffer of IQRF_PGM_MAP_SIZE bytes, valid while the context writes HEX files
+ *        (NULL = scratch storage record of the context)
+ */
+void iqrfPgmCtxSetBlockMap(IQRF_PGM_CONTEXT *Ctx, uint8_t *Buffer);
+
+/**
+ * Select lookup of validated-image cache by iqrfPgmCtxCheckCodeFile()
+ * @param Ctx pointer to programmer context
+ * @param Mode IQRF_PGM_CACHE_MEMORY or IQRF_PGM_CACHE_ALWAYS
+ * @note IQRF_PGM_CACHE_ALWAYS reads the whole code file once more before the check, it saves time only if
+ *       reading of the file is much faster than parsing
+ */
+void iqrfPgmCtxSetCacheMode(IQRF_PGM_CONTEXT *Ctx, uint8_t Mode);
+
+/**
+ * Select input stream of code file
+ * @param Ctx pointer to programmer context
+ * @param Fetch function providing chunks of code file (NULL = read code file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ * @note FileSize and FileType of the context file info must be filled by the user
+ */
+void iqrfPgmCtxSetStream(IQRF_PGM_CONTEXT *Ctx, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context);
+
+/**
+ * Select code file stored in memory as input stream (data are read in place, without copying)
+ * @param Ctx pointer to programmer context
+ * @param Data pointer to code file in memory
+ * @param Size size of code file
+ * @note FileSize of the context file info is filled by the function, FileType must be filled by the user
+ */
+void iqrfPgmCtxSetMemoryStream(IQRF_PGM_CONTEXT *Ctx, const uint8_t *Data, uint32_t Size);
+
+/**
+ * Select compressed code file as input stream, code file is decompressed on the fly during reading
+ * @param Ctx pointer to programmer context
+ * @param Stream pointer to decompressor state, must be valid until other stream is selected
+ * @param Fetch function providing chunks of compressed file (NULL = read compressed file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ * @return true = compressed file selected, false = file is not compressed code file (input stream is not changed)
+ * @note FileSize and FileType of the context file info are filled from header of compressed file
+ */
+uint8_t iqrfPgmCtxSetCompressedStream(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_LZ_STREAM *Stream, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context);
+
+/**
+ * Initialize reading of programming packets from the beginning of code file
+ * @param Ctx pointer to programmer context
+ */
+void iqrfPgmCtxInitPacketReader(IQRF_PGM_CONTEXT *Ctx);
+
+/**
+ * Read next programming packet from code file
+ * @param Ctx pointer to programmer context
+ * @param Packet pointer to structure, where SPI command, data and size of the packet will be stored
+ * @return Return code (IQRF_PGM_FILE_DATA_READY - packet ready, IQRF_PGM_FILE_DATA_ERROR - code file format error, IQRF_PGM_END_OF_FILE - end of file)
+ */
+uint8_t iqrfPgmCtxPreparePacket(IQRF_PGM_CONTEXT *Ctx, IQRF_PGM_PACKET *Packet);
+
+//******************************************************************************
+//		 	functions using default context IqrfPgmContext
+//******************************************************************************
+
 /**
  * Checking the format accuracy of the programming file
  * @return result of partial checking operation
@@ -76,9 +457,82 @@ uint8_t iqrfPgmCheckCodeFile(void);
 /**
  * Core programming function
  * @return result of partial programming operation
+ * @note See iqrfPgmCtxWriteCodeFile()
  */
 uint8_t iqrfPgmWriteCodeFile(void);
 
+/**
+ * Continue interrupted programming of code file
+ * @return result of partial programming operation
+ * @note See iqrfPgmCtxResumeCodeFile()
+ */
+uint8_t iqrfPgmResumeCodeFile(void);
+
+/**
+ * Write several code files, passwords and keys to TR module in one programming mode session
+ * @param Items pointer to array of session items, result of every item is stored to its Result
+ * @param Count number of items
+ * @return result of partial programming operation
+ * @note See iqrfPgmCtxWriteSession()
+ */
+uint8_t iqrfPgmWriteSession(IQRF_PGM_SESSION_ITEM *Items, uint8_t Count);
+
+/**
+ * Select delta programming mode of iqrfPgmWriteCodeFile()
+ * @param Mode IQRF_PGM_DELTA_OFF, IQRF_PGM_DELTA_ON or IQRF_PGM_DELTA_FORCE
+ */
+void iqrfPgmSetDeltaMode(uint8_t Mode);
+
+/**
+ * Select storage of block map of iqrfPgmWriteCodeFile()
+ * @param Buffer RAM buffer of IQRF_PGM_MAP_SIZE bytes (NULL = scratch storage record)
+ */
+void iqrfPgmSetBlockMap(uint8_t *Buffer);
+
+/**
+ * Select lookup of validated-image cache by iqrfPgmCheckCodeFile()
+ * @param Mode IQRF_PGM_CACHE_MEMORY or IQRF_PGM_CACHE_ALWAYS
+ */
+void iqrfPgmSetCacheMode(uint8_t Mode);
+
+/**
+ * Select input stream of code file
+ * @param Fetch function providing chunks of code file (NULL = read code file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ * @note CodeFileInfo.FileSize and CodeFileInfo.FileType must be filled by the user
+ */
+void iqrfPgmSetStream(T_IQRF_PGM_STREAM_FETCH Fetch, void *Context);
+
+/**
+ * Select code file stored in memory as input stream (data are read in place, without copying)
+ * @param Data pointer to code file in memory
+ * @param Size size of code file
+ * @note CodeFileInfo.FileSize is filled by the function, CodeFileInfo.FileType must be filled by the user
+ */
+void iqrfPgmSetMemoryStream(const uint8_t *Data, uint32_t Size);
+
+/**
+ * Select compressed code file as input stream, code file is decompressed on the fly during reading
+ * @param Stream pointer to decompressor state, must be valid until other stream is selected
+ * @param Fetch function providing chunks of compressed file (NULL = read compressed file by iqrfReadBlockFromFile())
+ * @param Context user data passed to Fetch function
+ * @return true = compressed file selected, false = file is not compressed code file
+ * @note CodeFileInfo.FileSize and CodeFileInfo.FileType are filled from header of compressed file
+ */
+uint8_t iqrfPgmSetCompressedStream(IQRF_PGM_LZ_STREAM *Stream, T_IQRF_PGM_STREAM_FETCH Fetch, void *Context);
+
+/**
+ * Initialize reading of programming packets from the beginning of code file
+ */
+void iqrfPgmInitPacketReader(void);
+
+/**
+ * Read next programming packet from code file
+ * @param Packet pointer to structure, where SPI command, data and size of the packet will be stored
+ * @return Return code (IQRF_PGM_FILE_DATA_READY - packet ready, IQRF_PGM_FILE_DATA_ERROR - code file format error, IQRF_PGM_END_OF_FILE - end of file)
+ */
+uint8_t iqrfPgmPreparePacket(IQRF_PGM_PACKET *Packet);
+
 /**
  * Core programming function for user password or user key
  * @param BufferContent selects between user key or user password to be written
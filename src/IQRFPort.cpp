@@ -79,29 +79,65 @@ void iqrfTrPowerOn(void)
 
 
 /**
- * switch TR module to programming mode
+ * switch SPI pins to GPIO for MOSI to MISO echo
  */
-void iqrfTrEnterPgmMode(void)
+void iqrfTrEchoPins(void)
 {
-    uint32_t SysTickTime;
-
-    iqrfDelayMs(200);
-    iqrfSuspendDriver();
     SPI.end();
     pinMode(TR_MOSI_PIN, OUTPUT);
     pinMode(TR_MISO_PIN, INPUT);
     pinMode(TR_SCK_PIN, OUTPUT);
     digitalWrite(TR_SCK_PIN, LOW);
     digitalWrite(TR_MOSI_PIN, LOW);
+}
+
+
+/**
+ * switch TR module to programming mode
+ */
+void iqrfTrEnterPgmMode(void)
+{
+    uint32_t SysTickTime;
+#if IQRF_PGM_MODE_ENTRY_PROBE
+    uint32_t CheckTime;
+    uint8_t SpiStatus;
+#endif
+
+    iqrfDelayMs(200);
+    iqrfSuspendDriver();
+    iqrfTrEchoPins();
     iqrfTrReset();
+#if !IQRF_PGM_MODE_ENTRY_PROBE
     digitalWrite(TR_SS_PIN, LOW);
     SysTickTime = iqrfGetSysTick();
     do {
-        // Copy MOSI to MISO for approx. 500ms => TR into programming mode
+        // Copy MOSI to MISO => TR into programming mode
         digitalWrite(TR_MOSI_PIN, digitalRead(TR_MISO_PIN));
-    } while ((iqrfGetSysTick() - SysTickTime) < (TICKS_IN_SECOND / 2));
+    } while ((iqrfGetSysTick() - SysTickTime) < IQRF_PGM_MODE_ENTRY_TIMEOUT);
     digitalWrite(TR_SS_PIN, HIGH);
     SPI.begin();
+#else
+    SysTickTime = iqrfGetSysTick();
+    do {
+        // Copy MOSI to MISO => TR into programming mode
+        digitalWrite(TR_SS_PIN, LOW);
+        CheckTime = iqrfGetSysTick();
+        do {
+            digitalWrite(TR_MOSI_PIN, digitalRead(TR_MISO_PIN));
+        } while ((iqrfGetSysTick() - CheckTime) < IQRF_PGM_MODE_CHECK_PERIOD);
+        digitalWrite(TR_SS_PIN, HIGH);
+        // stop the echo as soon as TR module reports programming mode
+        SPI.begin();
+        SpiStatus = iqrfSendSpiByte(SPI_CHECK);
+        if (IqrfControl.TRmoduleSelected)
+            iqrfDeselectTRmodule();
+        if (SpiStatus == PROGRAMMING_MODE)
+            break;
+        iqrfTrEchoPins();
+    } while ((iqrfGetSysTick() - SysTickTime) < IQRF_PGM_MODE_ENTRY_TIMEOUT);
+    if (SpiStatus != PROGRAMMING_MODE)
+        SPI.begin();
+#endif
     iqrfRunDriver();
 }
 
@@ -162,3 +198,91 @@ uint8_t iqrfReadByteFromFile(void)
         return(0);
     }
 }
+
+
+/**
+ * Read block of data from code file
+ *
+ * @param Buffer pointer to destination buffer
+ * @param Size maximal number of bytes to read
+ * @return number of bytes read, 0 = end of file
+ *
+ */
+uint16_t iqrfReadBlockFromFile(uint8_t *Buffer, uint16_t Size)
+{
+    int Count = CodeFile.read(Buffer, Size);
+
+    if (Count <= 0)
+        return(0);
+    return((uint16_t)Count);
+}
+
+
+/**
+ * Set position of next read from code file
+ *
+ * @param Offset position in code file
+ * @return true = position changed, false = error
+ *
+ */
+uint8_t iqrfSeekFile(uint32_t Offset)
+{
+    return(CodeFile.seek(Offset));
+}
+
+
+/**
+ * Read data from persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name)
+ * @param Offset position of data in the record
+ * @param Buffer pointer to destination buffer
+ * @param Size number of bytes to read
+ * @return number of bytes read, 0 = record or data does not exist
+ *
+ */
+uint16_t iqrfReadStorage(const char *Name, uint32_t Offset, uint8_t *Buffer, uint16_t Size)
+{
+    File Record;
+    int Count = 0;
+
+    Record = SD.open(Name, FILE_READ);
+    if (Record) {
+        if (Record.seek(Offset))
+            Count = Record.read(Buffer, Size);
+        Record.close();
+    }
+    return(Count > 0 ? (uint16_t)Count : 0);
+}
+
+
+/**
+ * Write data to persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name), record is created if does not exist
+ * @param Offset position of data in the record
+ * @param Buffer pointer to source buffer
+ * @param Size number of bytes to write
+ * @return number of bytes written
+ *
+ */
+uint16_t iqrfWriteStorage(const char *Name, uint32_t Offset, const uint8_t *Buffer, uint16_t Size)
+{
+    File Record;
+    uint16_t Count = 0;
+
+    // FILE_WRITE contains O_APPEND flag, which does not allow to rewrite data
+    Record = SD.open(Name, O_READ | O_WRITE | O_CREAT);
+    if (Record) {
+        // fill the gap, if the record is shorter than required position
+        if (Record.size() < Offset) {
+            Record.seek(Record.size());
+            while (Record.size() < Offset)
+                Record.write((uint8_t)0);
+        }
+        if (Record.seek(Offset))
+            Count = Record.write(Buffer, Size);
+        Record.close();
+    }
+    return(Count);
+}
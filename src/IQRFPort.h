@@ -23,14 +23,18 @@
 #ifndef IQRF_PORTS_H
 #define IQRF_PORTS_H
 
-#if defined(__cplusplus)
-extern "C" {
-#endif
-
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
 
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if defined(ARDUINO)
 // Pins
 #if !defined(TR_PWRCTRL_PIN)
 #define TR_PWRCTRL_PIN        9           //!< TR power control pin
@@ -49,9 +53,60 @@ extern "C" {
 
 #define iqrfGetSysTick()    millis()
 
+#define iqrfPollDriver()      // IQRF driver runs in timer interrupt
+
+#else
+// host platform (see extras/host)
+#define TICKS_IN_SECOND     1000
+
+#define iqrfDelayMs(T)    iqrfHostDelayMs(T)
+
+#define iqrfGetSysTick()    iqrfHostGetSysTick()
+
+#define iqrfPollDriver()    iqrfHostPollDriver()
+
+/**
+ * Delay on host platform
+ * @param Time delay in ms
+ */
+void iqrfHostDelayMs(uint32_t Time);
+
+/**
+ * Get system timer value on host platform
+ * @return number of ms from start of the program
+ */
+uint32_t iqrfHostGetSysTick(void);
+
+/**
+ * Run IQRF driver ticks elapsed since last call (called from busy-wait loops)
+ */
+void iqrfHostPollDriver(void);
+#endif
+
+// maximal time of MOSI to MISO echo during programming mode entry (ticks)
+#if !defined(IQRF_PGM_MODE_ENTRY_TIMEOUT)
+#define IQRF_PGM_MODE_ENTRY_TIMEOUT   (TICKS_IN_SECOND / 2)
+#endif
+// 1 = echo is interrupted by SPI status check and stopped in programming mode,
+// 0 = continuous echo for IQRF_PGM_MODE_ENTRY_TIMEOUT ticks (opt-out for TR modules, which do not tolerate the interrupted echo)
+#if !defined(IQRF_PGM_MODE_ENTRY_PROBE)
+#define IQRF_PGM_MODE_ENTRY_PROBE     1
+#endif
+// SPI status of TR module is checked after every IQRF_PGM_MODE_CHECK_PERIOD ticks of the echo
+#define IQRF_PGM_MODE_CHECK_PERIOD    (TICKS_IN_SECOND / 50)
+// maximal time of waiting for programming mode reported by IQRF driver after the echo (ticks),
+// the probe has already seen programming mode, so the driver only has to read SPI status
+#if !defined(IQRF_PGM_MODE_WAIT_TIMEOUT)
+#if IQRF_PGM_MODE_ENTRY_PROBE
+#define IQRF_PGM_MODE_WAIT_TIMEOUT    (TICKS_IN_SECOND / 10)
+#else
+#define IQRF_PGM_MODE_WAIT_TIMEOUT    (TICKS_IN_SECOND / 2)
+#endif
+#endif
+
 typedef struct {
-    uint16_t FileByteCnt;             // size of code file on SD card
-    uint16_t FileSize;                // size of code file on SD card
+    uint32_t FileByteCnt;             // number of bytes read from code file
+    uint32_t FileSize;                // size of code file
     uint8_t FileType;                 // file type (HEX / IQRF)
 } IQRF_PGM_FILE_INFO;
 
@@ -91,6 +146,8 @@ void iqrfTrPowerOn(void);
 
 /**
  * switch TR module to programming mode
+ * @note MOSI to MISO echo takes IQRF_PGM_MODE_ENTRY_TIMEOUT ticks. If IQRF_PGM_MODE_ENTRY_PROBE is set,
+ *       the echo is stopped as soon as TR module reports PROGRAMMING_MODE
  */
 void iqrfTrEnterPgmMode(void);
 
@@ -117,6 +174,49 @@ uint8_t iqrfSendSpiByte(uint8_t Tx_Byte);
  */
 uint8_t iqrfReadByteFromFile(void);
 
+/**
+ * Read block of data from code file
+ *
+ * @param Buffer pointer to destination buffer
+ * @param Size maximal number of bytes to read
+ * @return number of bytes read, 0 = end of file
+ *
+ */
+uint16_t iqrfReadBlockFromFile(uint8_t *Buffer, uint16_t Size);
+
+/**
+ * Set position of next read from code file
+ *
+ * @param Offset position in code file
+ * @return true = position changed, false = error
+ *
+ */
+uint8_t iqrfSeekFile(uint32_t Offset);
+
+/**
+ * Read data from persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name)
+ * @param Offset position of data in the record
+ * @param Buffer pointer to destination buffer
+ * @param Size number of bytes to read
+ * @return number of bytes read, 0 = record or data does not exist
+ *
+ */
+uint16_t iqrfReadStorage(const char *Name, uint32_t Offset, uint8_t *Buffer, uint16_t Size);
+
+/**
+ * Write data to persistent storage of the programmer
+ *
+ * @param Name name of the storage record (8.3 file name), record is created if does not exist
+ * @param Offset position of data in the record
+ * @param Buffer pointer to source buffer
+ * @param Size number of bytes to write
+ * @return number of bytes written
+ *
+ */
+uint16_t iqrfWriteStorage(const char *Name, uint32_t Offset, const uint8_t *Buffer, uint16_t Size);
+
 #if defined(__cplusplus)
 }
 #endif